@@ -0,0 +1,78 @@
+#include "admission_control.h"
+
+#include <algorithm>
+#include <thread>
+#include <utility>
+
+/**
+ * @file admission_control.cpp
+ * @brief Implementation of the load shedder.
+ */
+
+AdmissionLimits default_admission_limits(size_t compute_threads) {
+    size_t threads = compute_threads != 0 ? compute_threads : std::max(1u, std::thread::hardware_concurrency());
+    AdmissionLimits limits;
+    limits.max_expensive_in_flight = 2 * threads;
+    limits.max_compute_backlog = threads;
+    limits.expensive_io_queue = 256;
+    limits.max_io_queue = 1024;
+    return limits;
+}
+
+LoadShedder::LoadShedder(AdmissionLimits limits) : limits_(limits) {}
+
+void LoadShedder::configure(AdmissionLimits limits) {
+    limits_ = limits;
+}
+
+void LoadShedder::watch(std::function<size_t()> io_queue_length, std::function<size_t()> compute_backlog) {
+    io_queue_length_ = std::move(io_queue_length);
+    compute_backlog_ = std::move(compute_backlog);
+}
+
+bool LoadShedder::admit(RouteCost cost) {
+    size_t slot = index(cost);
+    size_t io_queue = io_queue_length_ ? io_queue_length_() : 0;
+    bool refused = io_queue >= limits_.max_io_queue;
+
+    if (!refused && cost == RouteCost::Expensive) {
+        refused = draining_.load(std::memory_order_relaxed) || io_queue >= limits_.expensive_io_queue ||
+                  (compute_backlog_ && compute_backlog_() >= limits_.max_compute_backlog);
+        // Claim a slot first and give it back on overshoot: two racing requests can never both
+        // take the last one.
+        if (!refused && in_flight_[slot].fetch_add(1, std::memory_order_relaxed) >= limits_.max_expensive_in_flight) {
+            in_flight_[slot].fetch_sub(1, std::memory_order_relaxed);
+            refused = true;
+        }
+    } else if (!refused) {
+        in_flight_[slot].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    if (refused) shed_[slot].fetch_add(1, std::memory_order_relaxed);
+    return !refused;
+}
+
+void LoadShedder::release(RouteCost cost) {
+    in_flight_[index(cost)].fetch_sub(1, std::memory_order_relaxed);
+}
+
+size_t LoadShedder::in_flight(RouteCost cost) const {
+    return in_flight_[index(cost)].load(std::memory_order_relaxed);
+}
+
+uint64_t LoadShedder::shed(RouteCost cost) const {
+    return shed_[index(cost)].load(std::memory_order_relaxed);
+}
+
+void LoadShedder::drain() {
+    draining_.store(true, std::memory_order_relaxed);
+}
+
+bool LoadShedder::draining() const {
+    return draining_.load(std::memory_order_relaxed);
+}
+
+LoadShedder &load_shedder() {
+    static LoadShedder shedder;
+    return shedder;
+}
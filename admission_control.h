@@ -0,0 +1,130 @@
+#ifndef DOMINOREST_ADMISSION_CONTROL_H
+#define DOMINOREST_ADMISSION_CONTROL_H
+
+#include "crow.h"
+#include "rate_limiter.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+/**
+ * @file admission_control.h
+ * @brief Load shedding: refusing work up front once the server is saturated, so admitted requests stay fast.
+ */
+
+/**
+ * @struct AdmissionLimits
+ * @brief Thresholds past which LoadShedder refuses work. Expensive work is shed first.
+ */
+struct AdmissionLimits {
+    /// Expensive requests admitted at once, running or waiting for a thread. Keeping this near
+    /// the core count bounds how long an admitted solve can wait behind the others.
+    size_t max_expensive_in_flight;
+    /// Tasks waiting in the compute pool beyond which expensive requests are refused.
+    size_t max_compute_backlog;
+    /// Connections on the busiest IO thread beyond which expensive requests are refused.
+    size_t expensive_io_queue;
+    /// Connections on the busiest IO thread beyond which every admission-controlled request is refused.
+    size_t max_io_queue;
+};
+
+/**
+ * @brief Limits scaled to the compute pool: twice its threads in flight, at most one task per thread queued.
+ * @param compute_threads The compute pool's thread count, or 0 for one per core.
+ */
+AdmissionLimits default_admission_limits(size_t compute_threads = 0);
+
+/**
+ * @class LoadShedder
+ * @brief Decides, per request, whether the server has room for it.
+ *
+ * Two kinds of pressure are watched. The first is work queued behind the server: connections per
+ * IO thread (Crow's task queue lengths) and tasks waiting in the compute pool. The second is the
+ * expensive work already in flight. Cheap requests are refused only at max_io_queue, well after
+ * expensive ones, so lookups keep working while the solver is saturated. Every check is a few
+ * relaxed atomic operations.
+ */
+class LoadShedder {
+public:
+    explicit LoadShedder(AdmissionLimits limits = default_admission_limits());
+
+    /// Changes the limits; call before the shedder is shared between threads.
+    void configure(AdmissionLimits limits);
+
+    /// Supplies the queue depths to watch; either may be empty. Call before the server starts.
+    void watch(std::function<size_t()> io_queue_length, std::function<size_t()> compute_backlog);
+
+    /**
+     * @brief Admits one request of @p cost, counting it in flight.
+     * @return false if it should be refused; nothing is counted then.
+     */
+    bool admit(RouteCost cost);
+
+    /// Ends a request admit() let in.
+    void release(RouteCost cost);
+
+    size_t in_flight(RouteCost cost) const;
+
+    /// Refuses every expensive request from now on, for shutdown; cheap ones are still admitted.
+    void drain();
+
+    bool draining() const;
+
+    /// Requests of @p cost refused so far.
+    uint64_t shed(RouteCost cost) const;
+
+private:
+    static size_t index(RouteCost cost) { return cost == RouteCost::Cheap ? 0 : 1; }
+
+    AdmissionLimits limits_;
+    std::function<size_t()> io_queue_length_;
+    std::function<size_t()> compute_backlog_;
+    std::atomic<size_t> in_flight_[2]{}; ///< Admitted and not yet released, per cost.
+    std::atomic<uint64_t> shed_[2]{}; ///< Refusals per cost.
+    std::atomic<bool> draining_{false};
+};
+
+/// The shedder every route and channel admits through.
+LoadShedder &load_shedder();
+
+/**
+ * @struct AdmissionControl
+ * @brief Crow middleware answering 503 with Retry-After when load_shedder() refuses a @p Cost request.
+ *
+ * Attach it after the rate limits, so a caller over its own budget still gets 429 rather than
+ * holding an in-flight slot, and before AuthMiddleware, so refused requests cost no credential
+ * checks. The slot is released in after_handle, i.e. once the response is complete, which for
+ * responses finished on a worker pool covers the time spent there too.
+ */
+template<RouteCost Cost>
+struct AdmissionControl : crow::ILocalMiddleware {
+    struct context {
+        bool admitted = false;
+    };
+
+    void before_handle(crow::request &, crow::response &res, context &ctx) {
+        if (load_shedder().admit(Cost)) {
+            ctx.admitted = true;
+            return;
+        }
+        if (load_shedder().draining()) {
+            CROW_LOG_WARNING << "Service Unavailable: Server is shutting down.";
+            res = crow::response(503, "Service Unavailable: Server is shutting down.");
+        } else {
+            CROW_LOG_WARNING << "Service Unavailable: Server is overloaded.";
+            res = crow::response(503, "Service Unavailable: Server is overloaded, retry later.");
+        }
+        res.set_header("Retry-After", "1");
+        res.end();
+    }
+
+    void after_handle(crow::request &, crow::response &, context &ctx) {
+        if (ctx.admitted) load_shedder().release(Cost);
+    }
+};
+
+using CheapAdmission = AdmissionControl<RouteCost::Cheap>;
+using ExpensiveAdmission = AdmissionControl<RouteCost::Expensive>;
+
+#endif //DOMINOREST_ADMISSION_CONTROL_H
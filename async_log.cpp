@@ -0,0 +1,220 @@
+#include "async_log.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+
+/**
+ * @file async_log.cpp
+ * @brief Implementation of the buffered log handler.
+ */
+
+/// The level column, padded as CerrLogHandler pads it.
+static const char *level_prefix(crow::LogLevel level) {
+    switch (level) {
+        case crow::LogLevel::Debug:
+            return "DEBUG   ";
+        case crow::LogLevel::Info:
+            return "INFO    ";
+        case crow::LogLevel::Warning:
+            return "WARNING ";
+        case crow::LogLevel::Error:
+            return "ERROR   ";
+        default:
+            return "CRITICAL";
+    }
+}
+
+static uint64_t next_handler_id() {
+    static std::atomic<uint64_t> next{1};
+    return next.fetch_add(1, std::memory_order_relaxed);
+}
+
+AsyncLogHandler::AsyncLogHandler(AsyncLogOptions options) : options_(std::move(options)), id_(next_handler_id()) {
+    size_t capacity = 2;
+    while (capacity < options_.ring_capacity) capacity *= 2;
+    options_.ring_capacity = capacity;
+    if (!options_.write) {
+        options_.write = [](const std::string &lines) {
+            std::fwrite(lines.data(), 1, lines.size(), stderr);
+            std::fflush(stderr);
+        };
+    }
+    writer_ = std::thread([this] { run(); });
+}
+
+AsyncLogHandler::~AsyncLogHandler() {
+    stop();
+}
+
+AsyncLogHandler::Ring &AsyncLogHandler::thread_ring() {
+    struct Owned {
+        uint64_t handler = 0;
+        Ring *ring = nullptr;
+    };
+    thread_local Owned owned;
+    if (owned.handler != id_) {
+        std::lock_guard<std::mutex> lock(rings_mutex_);
+        rings_.emplace_back(new Ring(options_.ring_capacity));
+        owned.handler = id_;
+        owned.ring = rings_.back().get();
+    }
+    return *owned.ring;
+}
+
+void AsyncLogHandler::log(std::string message, crow::LogLevel level) {
+    auto now = std::chrono::system_clock::now();
+    Ring *ring = stopped_.load(std::memory_order_acquire) ? nullptr : &thread_ring();
+    if (ring != nullptr) {
+        // Either stop() sees this flag and waits for the push before its last drain, or this sees stopped_:
+        // both are sequentially consistent, so a record can no longer land in a ring nobody drains.
+        ring->pushing.store(true);
+        if (stopped_.load()) {
+            ring->pushing.store(false, std::memory_order_release);
+            ring = nullptr;
+        }
+    }
+    if (ring == nullptr) {
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        std::string line;
+        append_line(now, level, message, line);
+        options_.write(line);
+        return;
+    }
+
+    size_t tail = ring->tail.load(std::memory_order_relaxed);
+    if (tail - ring->head.load(std::memory_order_acquire) > ring->mask) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        Record &slot = ring->slots[tail & ring->mask];
+        slot.message = std::move(message);
+        slot.level = level;
+        slot.time = now;
+        ring->tail.store(tail + 1, std::memory_order_release);
+    }
+    ring->pushing.store(false, std::memory_order_release);
+}
+
+void AsyncLogHandler::flush() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (stopping_) return;
+    uint64_t ticket = ++flush_requested_;
+    wake_.notify_one();
+    flushed_.wait(lock, [this, ticket] { return flush_done_ >= ticket; });
+}
+
+void AsyncLogHandler::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_) return;
+        stopping_ = true;
+    }
+    stopped_.store(true);
+    wake_.notify_one();
+    writer_.join();
+    // Threads that read stopped_ before it was set may still be pushing; once they are done nothing
+    // else reaches the rings, so this last drain takes everything.
+    {
+        std::lock_guard<std::mutex> lock(rings_mutex_);
+        for (auto &ring: rings_) {
+            while (ring->pushing.load()) std::this_thread::yield();
+        }
+    }
+    drain();
+}
+
+uint64_t AsyncLogHandler::dropped() const {
+    return dropped_.load(std::memory_order_relaxed);
+}
+
+uint64_t AsyncLogHandler::suppressed() const {
+    return suppressed_.load(std::memory_order_relaxed);
+}
+
+void AsyncLogHandler::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        wake_.wait_for(lock, options_.flush_interval,
+                       [this] { return stopping_ || flush_requested_ != flush_done_; });
+        uint64_t requested = flush_requested_;
+        bool stopping = stopping_;
+        lock.unlock();
+        drain();
+        lock.lock();
+        flush_done_ = requested;
+        flushed_.notify_all();
+        if (stopping) return;
+    }
+}
+
+void AsyncLogHandler::drain() {
+    std::lock_guard<std::mutex> write_lock(write_mutex_);
+    {
+        std::lock_guard<std::mutex> lock(rings_mutex_);
+        for (auto &ring: rings_) {
+            size_t head = ring->head.load(std::memory_order_relaxed);
+            size_t tail = ring->tail.load(std::memory_order_acquire);
+            for (; head != tail; ++head) batch_.push_back(std::move(ring->slots[head & ring->mask]));
+            ring->head.store(head, std::memory_order_release);
+        }
+    }
+    // Each ring is in order already; merging them by time keeps the lines of different threads interleaved.
+    std::stable_sort(batch_.begin(), batch_.end(),
+                     [](const Record &a, const Record &b) { return a.time < b.time; });
+
+    std::string out;
+    for (Record &record: batch_) append(record, out);
+    batch_.clear();
+
+    auto now = std::chrono::system_clock::now();
+    if (repeats_ > 0 && now - last_written_ >= options_.repeat_window) append_repeats(out);
+    uint64_t dropped = dropped_.load(std::memory_order_relaxed);
+    if (dropped != dropped_reported_) {
+        append_line(now, crow::LogLevel::Warning,
+                    "Log buffer full: dropped " + std::to_string(dropped - dropped_reported_) + " messages.", out);
+        dropped_reported_ = dropped;
+    }
+    if (!out.empty()) options_.write(out);
+}
+
+void AsyncLogHandler::append(Record &record, std::string &out) {
+    if (record.level == last_.level && record.message == last_.message &&
+        record.time - last_written_ < options_.repeat_window) {
+        ++repeats_;
+        suppressed_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    append_repeats(out);
+    append_line(record.time, record.level, record.message, out);
+    last_.message = std::move(record.message);
+    last_.level = record.level;
+    last_written_ = record.time;
+}
+
+void AsyncLogHandler::append_repeats(std::string &out) {
+    if (repeats_ == 0) return;
+    append_line(last_written_, last_.level, "Last message repeated " + std::to_string(repeats_) + " times.", out);
+    repeats_ = 0;
+}
+
+void AsyncLogHandler::append_line(std::chrono::system_clock::time_point time, crow::LogLevel level,
+                                  const std::string &message, std::string &out) {
+    time_t second = std::chrono::system_clock::to_time_t(time);
+    if (second != stamp_second_) {
+        tm parts;
+#ifdef CROW_USE_LOCALTIMEZONE
+        localtime_r(&second, &parts);
+#else
+        gmtime_r(&second, &parts);
+#endif
+        std::strftime(stamp_, sizeof(stamp_), "%Y-%m-%d %H:%M:%S", &parts);
+        stamp_second_ = second;
+    }
+    out += '(';
+    out += stamp_;
+    out += ") [";
+    out += level_prefix(level);
+    out += "] ";
+    out += message;
+    out += '\n';
+}
@@ -0,0 +1,140 @@
+#ifndef DOMINOREST_ASYNC_LOG_H
+#define DOMINOREST_ASYNC_LOG_H
+
+#include "crow.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @file async_log.h
+ * @brief A Crow log handler that takes lines off the calling thread and writes them in batches.
+ */
+
+/**
+ * @struct AsyncLogOptions
+ * @brief Buffering and rate limiting for AsyncLogHandler.
+ */
+struct AsyncLogOptions {
+    /// Records each thread can have waiting; further ones are dropped and counted. A power of two.
+    size_t ring_capacity = 1024;
+    /// How often the writer wakes to drain the rings.
+    std::chrono::milliseconds flush_interval{50};
+    /// How long a message repeated back to back is reported only by a count.
+    std::chrono::milliseconds repeat_window{1000};
+    /// Receives each batch of formatted lines; standard error unless a test substitutes its own.
+    std::function<void(const std::string &)> write;
+};
+
+/**
+ * @class AsyncLogHandler
+ * @brief Per-thread lock-free rings of log records, drained by one background writer thread.
+ *
+ * log() stamps the record and moves it into the calling thread's single-producer ring: no lock,
+ * no allocation beyond the line Crow already built, no system call. The writer merges the rings
+ * in time order, formats the lines as CerrLogHandler does (the timestamp text is reformatted at
+ * most once a second) and writes each batch with one call.
+ *
+ * A message identical to the one before it, at the same level, within repeat_window is not
+ * written again; a "Last message repeated N times." line follows once the run ends. When a
+ * thread's ring is full the record is dropped and counted, and the writer reports the drops.
+ * After stop(), which the destructor calls, lines are written synchronously instead.
+ */
+class AsyncLogHandler : public crow::ILogHandler {
+public:
+    explicit AsyncLogHandler(AsyncLogOptions options = AsyncLogOptions());
+
+    /// Writes everything still buffered and joins the writer.
+    ~AsyncLogHandler() override;
+
+    AsyncLogHandler(const AsyncLogHandler &) = delete;
+
+    AsyncLogHandler &operator=(const AsyncLogHandler &) = delete;
+
+    void log(std::string message, crow::LogLevel level) override;
+
+    /// Blocks until every record logged before the call has been written.
+    void flush();
+
+    /// Writes everything buffered and stops the writer; later records are written synchronously.
+    void stop();
+
+    /// Records dropped because their thread's ring was full.
+    uint64_t dropped() const;
+
+    /// Repeated messages written only as a count.
+    uint64_t suppressed() const;
+
+private:
+    struct Record {
+        std::string message;
+        crow::LogLevel level = crow::LogLevel::Info;
+        std::chrono::system_clock::time_point time;
+    };
+
+    /// A single-producer, single-consumer ring: its thread pushes, the writer pops.
+    struct Ring {
+        explicit Ring(size_t capacity) : slots(capacity), mask(capacity - 1) {}
+
+        std::vector<Record> slots;
+        size_t mask;
+        alignas(64) std::atomic<size_t> head{0}; ///< Next slot the writer reads.
+        alignas(64) std::atomic<size_t> tail{0}; ///< Next slot the producer fills.
+        /// Set by the producer from before it checks stopped_ until its record is in; stop() waits it out.
+        std::atomic<bool> pushing{false};
+    };
+
+    Ring &thread_ring();
+
+    void run();
+
+    /// Moves every waiting record into a batch and writes it.
+    void drain();
+
+    /// Appends @p record as a line, or counts it as a repeat of the line before.
+    void append(Record &record, std::string &out);
+
+    void append_line(std::chrono::system_clock::time_point time, crow::LogLevel level, const std::string &message,
+                     std::string &out);
+
+    void append_repeats(std::string &out);
+
+    AsyncLogOptions options_;
+    const uint64_t id_; ///< Tells this handler's rings apart from an earlier one's in thread_ring().
+
+    std::mutex rings_mutex_;
+    std::vector<std::unique_ptr<Ring>> rings_;
+
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<uint64_t> suppressed_{0};
+    std::atomic<bool> stopped_{false};
+
+    std::mutex mutex_; ///< Guards the flush handshake and stopping_.
+    std::condition_variable wake_;
+    std::condition_variable flushed_;
+    uint64_t flush_requested_ = 0;
+    uint64_t flush_done_ = 0;
+    bool stopping_ = false;
+    std::mutex write_mutex_; ///< Serializes drain() with synchronous writes after stop().
+
+    // Writer state, touched only under write_mutex_.
+    std::vector<Record> batch_;
+    Record last_;
+    std::chrono::system_clock::time_point last_written_;
+    uint64_t repeats_ = 0;
+    uint64_t dropped_reported_ = 0;
+    time_t stamp_second_ = -1;
+    char stamp_[32] = {};
+
+    std::thread writer_;
+};
+
+#endif //DOMINOREST_ASYNC_LOG_H
@@ -1,14 +1,98 @@
 #include "auth_handler.h"
 #include <openssl/sha.h>
 #include <openssl/evp.h>
+#include <openssl/rand.h>
+#include <openssl/crypto.h>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <thread>
 
-std::unordered_map<std::string, User> users;
-std::unordered_map<std::string, std::string> active_tokens;
-std::unordered_map<std::string, std::string> dev_keys;
+/// Tasks allowed to wait for a hashing thread before login and register answer 503.
+static const size_t HASHING_QUEUE_LIMIT = 128;
+
+ShardedMap<std::string, User> users;
+TokenStore active_tokens(TOKEN_TTL);
+TokenStore dev_keys;
+
+/// Bumped whenever a credential is revoked, so caches of verified credentials know to drop them.
+static std::atomic<uint64_t> revocation_epoch{0};
+
+uint64_t credential_epoch() {
+    return revocation_epoch.load(std::memory_order_acquire);
+}
+
+/// Set by use_admin_key; empty disables the admin endpoints.
+static std::string admin_key;
+
+void use_admin_key(const std::string &key) {
+    admin_key = key;
+}
+
+bool verifyAdminKey(const std::string &key) {
+    return !admin_key.empty() && key.size() == admin_key.size() &&
+           CRYPTO_memcmp(key.data(), admin_key.data(), key.size()) == 0;
+}
+
+/// Set by use_signed_tokens; when present, credentials are signed instead of stored.
+static std::unique_ptr<TokenSigner> signer;
+
+void use_signed_tokens(uint32_t key_id, const std::string &secret, const std::string &previous_secret) {
+    if (secret.empty()) {
+        signer.reset();
+        return;
+    }
+    signer.reset(new TokenSigner(key_id, secret, DEV_KEY_TTL));
+    if (!previous_secret.empty()) {
+        signer->add_verification_key(key_id - 1, previous_secret);
+    }
+    revocation_epoch.fetch_add(1, std::memory_order_release);
+}
+
+/// Issues a new credential of @p kind for @p username, signed or stored depending on the mode.
+static std::string issue_credential(TokenKind kind, const std::string &username) {
+    if (signer) {
+        auto lifetime = kind == TokenKind::Session ? std::chrono::seconds(TOKEN_TTL) : DEV_KEY_TTL;
+        return signer->issue(kind, username, std::chrono::system_clock::now() + lifetime);
+    }
+    std::string credential = generateNonce(32);
+    TokenKey key;
+    decodeToken(credential, key);
+    (kind == TokenKind::Session ? active_tokens : dev_keys).insert(key, username);
+    return credential;
+}
+
+/// Looks @p credential up as a @p kind, copying its owner into @p username.
+static bool resolve_credential(TokenKind kind, const std::string &credential, std::string &username) {
+    if (signer) {
+        TokenClaims claims;
+        if (!signer->verify(credential, kind, claims)) return false;
+        username = std::move(claims.username);
+        return true;
+    }
+    TokenKey key;
+    return decodeToken(credential, key) &&
+           (kind == TokenKind::Session ? active_tokens : dev_keys).find(key, username);
+}
 
 std::string generateNonce(size_t length) {
-    unsigned char buffer[length];
-    return crow::utility::base64encode(buffer, length);
+    std::vector<unsigned char> buffer(length);
+    if (RAND_bytes(buffer.data(), static_cast<int>(length)) != 1) {
+        CROW_LOG_ERROR << "RAND_bytes failed to generate a nonce.";
+        throw std::runtime_error("RAND_bytes failed");
+    }
+    return crow::utility::base64encode(buffer.data(), length);
+}
+
+bool decodeToken(const std::string &token, TokenKey &key) {
+    // 32 bytes encode to exactly 44 base64 characters; anything else cannot be one of ours.
+    if (token.size() != 44) return false;
+    std::string raw = crow::utility::base64decode(token, token.size());
+    if (raw.size() != key.size()) return false;
+    std::memcpy(key.data(), raw.data(), key.size());
+    return true;
 }
 
 std::string pbkdf2Sha256(const std::string &password, const std::string &salt, int iterations, int keyLen) {
@@ -19,6 +103,23 @@ std::string pbkdf2Sha256(const std::string &password, const std::string &salt, i
     return std::string(reinterpret_cast<char *>(key), keyLen);
 }
 
+/// What hashing_pool() is created with; 0 threads means the default.
+static size_t hashing_threads = 0;
+static size_t hashing_queue_limit = HASHING_QUEUE_LIMIT;
+
+void configure_hashing_pool(size_t threads, size_t queue_limit) {
+    hashing_threads = threads;
+    hashing_queue_limit = queue_limit;
+}
+
+WorkerPool &hashing_pool() {
+    // A quarter of the cores by default: enough to keep up with bursts without starving the solver.
+    static WorkerPool pool("hashing", hashing_threads != 0 ? hashing_threads
+                                                           : std::max(1u, std::thread::hardware_concurrency() / 4),
+                           hashing_queue_limit);
+    return pool;
+}
+
 std::string generateToken() {
     return generateNonce(32);
 }
@@ -29,7 +130,7 @@ crow::response register_route(const crow::request &req) {
     std::string username = x["username"].s();
     std::string password = x["password"].s();
 
-    if (users.find(username) != users.end()) {
+    if (users.contains(username)) {
         CROW_LOG_WARNING << "User " + username + " already exists.";
         return crow::response(400, "User " + username + "already exists.");
     }
@@ -37,7 +138,11 @@ crow::response register_route(const crow::request &req) {
     std::string salt = generateNonce(16);
     std::string hashed_password = pbkdf2Sha256(password, salt, 4096, 32);
 
-    users[username] = {salt, hashed_password};
+    // Two concurrent registrations of one name both pass the check above; only one insert wins.
+    if (!users.insert(username, {salt, hashed_password})) {
+        CROW_LOG_WARNING << "User " + username + " already exists.";
+        return crow::response(400, "User " + username + "already exists.");
+    }
 
     CROW_LOG_INFO << "User " + username + " registered successfully.";
     return crow::response(200, "User " + username + " registered successfully.");
@@ -49,22 +154,20 @@ crow::response login_route(const crow::request &req) {
     std::string username = x["username"].s();
     std::string password = x["password"].s();
 
-    auto it = users.find(username);
-    if (it == users.end()) {
+    User user;
+    if (!users.find(username, user)) {
         CROW_LOG_WARNING << "Invalid username or password.";
         return crow::response(400, "Invalid username or password.");
     }
 
-    std::string salt = it->second.salt;
-    std::string hashed_password = pbkdf2Sha256(password, salt, 4096, 32);
+    std::string hashed_password = pbkdf2Sha256(password, user.salt, 4096, 32);
 
-    if (hashed_password != it->second.hashed_password) {
+    if (hashed_password != user.hashed_password) {
         CROW_LOG_WARNING << "Invalid username or password.";
         return crow::response(400, "Invalid username or password.");
     }
 
-    std::string token = generateToken();
-    active_tokens[token] = username;
+    std::string token = issue_credential(TokenKind::Session, username);
 
     crow::json::wvalue result;
     result["token"] = token;
@@ -74,7 +177,12 @@ crow::response login_route(const crow::request &req) {
 }
 
 bool authenticate(const std::string &token) {
-    return active_tokens.find(token) != active_tokens.end();
+    std::string username;
+    return authenticate(token, username);
+}
+
+bool authenticate(const std::string &token, std::string &username) {
+    return resolve_credential(TokenKind::Session, token, username);
 }
 
 std::string generateDevKey() {
@@ -84,14 +192,13 @@ std::string generateDevKey() {
 crow::response create_dev_key_route(const crow::request &req) {
     std::string token = req.get_header_value("Authorization");
 
-    if (!authenticate(token)) {
+    std::string username;
+    if (!authenticate(token, username)) {
         CROW_LOG_ERROR << "Unauthorized: Invalid or missing token.";
         return crow::response(401, "Unauthorized: Invalid or missing token.");
     }
 
-    std::string username = active_tokens[token];
-    std::string dev_key = generateDevKey();
-    dev_keys[dev_key] = username;
+    std::string dev_key = issue_credential(TokenKind::DevKey, username);
 
     crow::json::wvalue result;
     result["dev_key"] = dev_key;
@@ -101,5 +208,55 @@ crow::response create_dev_key_route(const crow::request &req) {
 }
 
 bool verifyDevKey(const std::string &dev_key) {
-    return dev_keys.find(dev_key) != dev_keys.end();
-}
\ No newline at end of file
+    std::string username;
+    return verifyDevKey(dev_key, username);
+}
+
+bool verifyDevKey(const std::string &dev_key, std::string &username) {
+    return resolve_credential(TokenKind::DevKey, dev_key, username);
+}
+
+crow::response logout_route(const crow::request &req) {
+    std::string token = req.get_header_value("Authorization");
+
+    std::string username;
+    if (!authenticate(token, username)) {
+        CROW_LOG_ERROR << "Unauthorized: Invalid or missing token.";
+        return crow::response(401, "Unauthorized: Invalid or missing token.");
+    }
+
+    if (signer) {
+        signer->revoke(token);
+    } else {
+        TokenKey key;
+        decodeToken(token, key);
+        active_tokens.erase(key);
+    }
+    revocation_epoch.fetch_add(1, std::memory_order_release);
+
+    CROW_LOG_INFO << "User " + username + " logged out.";
+    return crow::response(200, "User " + username + " logged out.");
+}
+
+void expire_credentials() {
+    active_tokens.expire();
+    if (signer) signer->expire_revocations();
+}
+
+void register_route_async(const crow::request &req, crow::response &res) {
+    std::string body = req.body;
+    respond_from_pool(hashing_pool(), req, res, [body] {
+        crow::request copy;
+        copy.body = body;
+        return register_route(copy);
+    });
+}
+
+void login_route_async(const crow::request &req, crow::response &res) {
+    std::string body = req.body;
+    respond_from_pool(hashing_pool(), req, res, [body] {
+        crow::request copy;
+        copy.body = body;
+        return login_route(copy);
+    });
+}
@@ -2,27 +2,109 @@
 #define DOMINOREST_AUTH_HANDLER_H
 
 #include "crow.h"
-#include <unordered_map>
+#include "sharded_map.h"
+#include "signed_token.h"
+#include "token_store.h"
+#include "worker_pool.h"
+#include <chrono>
 
 struct User {
     std::string salt;
     std::string hashed_password;
 };
 
+/// How long a login token stays valid.
+const std::chrono::hours TOKEN_TTL(1);
+
+/// How long a signed dev key stays valid; stored dev keys do not expire.
+const std::chrono::seconds DEV_KEY_TTL(30 * 24 * 3600);
+
+/**
+ * @brief Switches login_route and create_dev_key_route to stateless HMAC-SHA256 tokens (see signed_token.h).
+ *
+ * Signed credentials are verified from their own contents, so every instance configured with the same
+ * secret accepts them. Must be called at startup, before any request is served.
+ *
+ * @param key_id Key id embedded in new tokens.
+ * @param secret Signing secret; empty switches back to in-process tokens.
+ * @param previous_secret If non-empty, tokens signed under key_id - 1 with this secret stay valid.
+ */
+void use_signed_tokens(uint32_t key_id, const std::string &secret, const std::string &previous_secret = "");
+
 std::string generateNonce(size_t length);
 
+/**
+ * @brief Decodes a token or dev key from its base64 text to its binary key.
+ * @return false if @p token is not the encoding of exactly 32 bytes.
+ */
+bool decodeToken(const std::string &token, TokenKey &key);
+
 std::string pbkdf2Sha256(const std::string &password, const std::string &salt, int iterations, int keyLen);
 
+/**
+ * @brief Sets the key the Admin-Key header must carry on admin endpoints; empty disables them.
+ *
+ * Must be called at startup, before any request is served.
+ */
+void use_admin_key(const std::string &key);
+
+/// Constant-time check of @p key against the configured admin key.
+bool verifyAdminKey(const std::string &key);
+
 bool authenticate(const std::string &token);
 
+/// As authenticate(token), also copying the token's user name into @p username.
+bool authenticate(const std::string &token, std::string &username);
+
 crow::response register_route(const crow::request &req);
 
 crow::response login_route(const crow::request &req);
 
 crow::response create_dev_key_route(const crow::request &req);
 
+/**
+ * @brief Invalidates the Authorization token; signed tokens are added to the revocation set.
+ */
+crow::response logout_route(const crow::request &req);
+
+/**
+ * @brief The dedicated pool PBKDF2 hashing runs on, so bursts of logins never occupy HTTP IO threads.
+ */
+WorkerPool &hashing_pool();
+
+/**
+ * @brief Sizes hashing_pool(); only takes effect before its first use.
+ * @param threads Worker threads, or 0 for a quarter of the cores.
+ */
+void configure_hashing_pool(size_t threads, size_t queue_limit);
+
+/**
+ * @brief register_route, run on hashing_pool(); answers 503 when the pool's queue is full.
+ */
+void register_route_async(const crow::request &req, crow::response &res);
+
+/**
+ * @brief login_route, run on hashing_pool(); answers 503 when the pool's queue is full.
+ */
+void login_route_async(const crow::request &req, crow::response &res);
+
 bool verifyDevKey(const std::string &dev_key);
 
+/// As verifyDevKey(dev_key), also copying the key's user name into @p username.
+bool verifyDevKey(const std::string &dev_key, std::string &username);
+
+/**
+ * @brief Counter that changes whenever a credential is revoked or the token mode changes.
+ *
+ * Anything caching the outcome of authenticate or verifyDevKey must discard it once this moves.
+ */
+uint64_t credential_epoch();
+
+/**
+ * @brief Reclaims expired login tokens and revocations; call periodically.
+ */
+void expire_credentials();
+
 std::string generateToken();
 
 std::string generateDevKey();
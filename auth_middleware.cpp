@@ -0,0 +1,85 @@
+#include "auth_middleware.h"
+
+#include "auth_handler.h"
+#include "metrics.h"
+#include <openssl/crypto.h>
+#include <array>
+#include <chrono>
+#include <functional>
+
+/**
+ * @file auth_middleware.cpp
+ * @brief Implementation of the authentication middleware and its per-thread cache.
+ */
+
+/// Slots in each thread's credential cache.
+static const size_t AUTH_CACHE_SLOTS = 64;
+
+/// How long a cached verification is trusted; bounds how far past expiry a credential can be used.
+static const std::chrono::seconds AUTH_CACHE_TTL(1);
+
+namespace {
+    struct CachedCredential {
+        std::string credential;
+        bool dev_key = false;
+        std::string username;
+        uint64_t epoch = 0;
+        std::chrono::steady_clock::time_point verified;
+    };
+
+    thread_local std::array<CachedCredential, AUTH_CACHE_SLOTS> auth_cache;
+}
+
+static bool same_credential(const std::string &a, const std::string &b) {
+    return a.size() == b.size() && CRYPTO_memcmp(a.data(), b.data(), a.size()) == 0;
+}
+
+/// Verifies @p credential as a login token or dev key, through the calling thread's cache.
+static bool verify_cached(const std::string &credential, bool dev_key, std::string &username) {
+    auto now = std::chrono::steady_clock::now();
+    uint64_t epoch = credential_epoch();
+    CachedCredential &slot = auth_cache[(std::hash<std::string>{}(credential) + dev_key) % AUTH_CACHE_SLOTS];
+
+    static Counter &hits = metrics().counter("dominorest_cache_lookups_total", "Cache lookups, by cache and result.",
+                                             "cache=\"credential\",result=\"hit\"");
+    static Counter &misses = metrics().counter("dominorest_cache_lookups_total", "Cache lookups, by cache and result.",
+                                               "cache=\"credential\",result=\"miss\"");
+    if (slot.dev_key == dev_key && slot.epoch == epoch && now - slot.verified < AUTH_CACHE_TTL &&
+        same_credential(slot.credential, credential)) {
+        hits.add();
+        username = slot.username;
+        return true;
+    }
+    misses.add();
+
+    bool valid = dev_key ? verifyDevKey(credential, username) : authenticate(credential, username);
+    if (valid) {
+        slot.credential = credential;
+        slot.dev_key = dev_key;
+        slot.username = username;
+        slot.epoch = epoch;
+        slot.verified = now;
+    }
+    return valid;
+}
+
+bool authorize_request(const crow::request &req, AuthMiddleware::context &ctx) {
+    const std::string &token = req.get_header_value("Authorization");
+    if (!token.empty() && verify_cached(token, false, ctx.username)) {
+        return true;
+    }
+    const std::string &dev_key = req.get_header_value("Dev-Key");
+    if (!dev_key.empty() && verify_cached(dev_key, true, ctx.username)) {
+        ctx.dev_key = dev_key;
+        return true;
+    }
+    return false;
+}
+
+void AuthMiddleware::before_handle(crow::request &req, crow::response &res, context &ctx) {
+    if (!authorize_request(req, ctx)) {
+        CROW_LOG_ERROR << "Unauthorized: Invalid or missing token/dev-key.";
+        res = crow::response(401, "Unauthorized: Invalid or missing token/dev-key.");
+        res.end();
+    }
+}
@@ -0,0 +1,38 @@
+#ifndef DOMINOREST_AUTH_MIDDLEWARE_H
+#define DOMINOREST_AUTH_MIDDLEWARE_H
+
+#include "crow.h"
+#include <string>
+
+/**
+ * @file auth_middleware.h
+ * @brief Crow middleware that rejects requests without a valid login token or dev key.
+ */
+
+/**
+ * @struct AuthMiddleware
+ * @brief Checks the Authorization header (login token), then the Dev-Key header, before the handler runs.
+ *
+ * Attach it per route with CROW_MIDDLEWARES(app, AuthMiddleware). Each thread keeps a small
+ * direct-mapped cache of credentials it recently verified, so a client repeating its credential
+ * costs one constant-time comparison and no shared lock. Cached entries are dropped after
+ * AUTH_CACHE_TTL and whenever credential_epoch() moves, i.e. on every logout.
+ */
+struct AuthMiddleware : crow::ILocalMiddleware {
+    struct context {
+        std::string username; ///< Owner of the accepted credential.
+        std::string dev_key;  ///< The Dev-Key that was accepted, empty for login tokens.
+    };
+
+    void before_handle(crow::request &req, crow::response &res, context &ctx);
+
+    void after_handle(crow::request &, crow::response &, context &) {}
+};
+
+/**
+ * @brief Resolves the credentials @p req carries to a user, consulting the calling thread's cache first.
+ * @return false if neither header holds a valid credential.
+ */
+bool authorize_request(const crow::request &req, AuthMiddleware::context &ctx);
+
+#endif //DOMINOREST_AUTH_MIDDLEWARE_H
@@ -0,0 +1,115 @@
+#include "board_codec.h"
+
+#include <algorithm>
+
+/**
+ * @file board_codec.cpp
+ * @brief Implementation of the packed board encoding.
+ */
+
+std::vector<unsigned char> placement_directions(const std::vector<std::vector<int>> &placement) {
+    int rows = placement.size();
+    int cols = rows == 0 ? 0 : placement[0].size();
+    std::vector<unsigned char> directions(static_cast<size_t>(rows) * cols, PLACEMENT_RIGHT);
+    for (int i = 0; i < rows; ++i) {
+        for (int j = 0; j < cols; ++j) {
+            int piece = placement[i][j];
+            unsigned char direction = PLACEMENT_UP;
+            if (j + 1 < cols && placement[i][j + 1] == piece) direction = PLACEMENT_RIGHT;
+            else if (i + 1 < rows && placement[i + 1][j] == piece) direction = PLACEMENT_DOWN;
+            else if (j > 0 && placement[i][j - 1] == piece) direction = PLACEMENT_LEFT;
+            directions[static_cast<size_t>(i) * cols + j] = direction;
+        }
+    }
+    return directions;
+}
+
+static size_t pip_bytes(size_t cells, bool nibbles) {
+    return nibbles ? (cells + 1) / 2 : cells;
+}
+
+static size_t direction_bytes(size_t cells) {
+    return (cells + 3) / 4;
+}
+
+std::string encode_packed_board(const FlatBoard &board, const std::vector<unsigned char> *directions, bool solved) {
+    size_t cells = board.pips.size();
+    bool nibbles = std::all_of(board.pips.begin(), board.pips.end(), [](unsigned char pip) { return pip < 16; });
+    unsigned char flags = nibbles ? PACKED_NIBBLES : 0;
+    if (directions != nullptr) {
+        flags |= PACKED_PLACEMENT;
+        if (solved) flags |= PACKED_SOLVED;
+    }
+
+    std::string out(PACKED_BOARD_HEADER + pip_bytes(cells, nibbles) +
+                    (directions != nullptr ? direction_bytes(cells) : 0), '\0');
+    out[0] = 'D';
+    out[1] = 'B';
+    out[2] = static_cast<char>(PACKED_BOARD_VERSION);
+    out[3] = static_cast<char>(flags);
+    out[4] = static_cast<char>(board.rows >> 8);
+    out[5] = static_cast<char>(board.rows & 0xFF);
+    out[6] = static_cast<char>(board.cols >> 8);
+    out[7] = static_cast<char>(board.cols & 0xFF);
+
+    size_t pos = PACKED_BOARD_HEADER;
+    if (nibbles) {
+        for (size_t k = 0; k < cells; ++k) {
+            out[pos + k / 2] = static_cast<char>(out[pos + k / 2] | (board.pips[k] << (k % 2 == 0 ? 4 : 0)));
+        }
+    } else {
+        std::copy(board.pips.begin(), board.pips.end(), out.begin() + pos);
+    }
+    pos += pip_bytes(cells, nibbles);
+
+    if (directions != nullptr) {
+        for (size_t k = 0; k < cells; ++k) {
+            out[pos + k / 4] = static_cast<char>(out[pos + k / 4] | (((*directions)[k] & 3) << (k % 4 * 2)));
+        }
+    }
+    return out;
+}
+
+bool decode_packed_board(const char *data, size_t size, FlatBoard &board, BoardParseError &error,
+                         std::vector<unsigned char> *directions, int max_pip) {
+    auto fail = [&error](size_t offset, const char *message) {
+        error.offset = offset;
+        error.message = message;
+        return false;
+    };
+    auto byte = [data](size_t offset) { return static_cast<unsigned char>(data[offset]); };
+
+    if (size < PACKED_BOARD_HEADER) return fail(size, "truncated header");
+    if (data[0] != 'D' || data[1] != 'B') return fail(0, "bad magic");
+    if (byte(2) != PACKED_BOARD_VERSION) return fail(2, "unsupported version");
+    unsigned char flags = byte(3);
+    if (flags & ~(PACKED_NIBBLES | PACKED_PLACEMENT | PACKED_SOLVED)) return fail(3, "unknown flags");
+
+    board.rows = (byte(4) << 8) | byte(5);
+    board.cols = (byte(6) << 8) | byte(7);
+    if (board.rows == 0) return fail(4, "board has no rows");
+    if (board.cols == 0) return fail(6, "board has no columns");
+
+    size_t cells = static_cast<size_t>(board.rows) * board.cols;
+    bool nibbles = flags & PACKED_NIBBLES;
+    size_t expected = PACKED_BOARD_HEADER + pip_bytes(cells, nibbles) +
+                      ((flags & PACKED_PLACEMENT) ? direction_bytes(cells) : 0);
+    if (size != expected) return fail(std::min(size, expected), "length does not match dimensions");
+
+    board.pips.resize(cells);
+    for (size_t k = 0; k < cells; ++k) {
+        size_t offset = PACKED_BOARD_HEADER + (nibbles ? k / 2 : k);
+        int pip = nibbles ? (byte(offset) >> (k % 2 == 0 ? 4 : 0)) & 0x0F : byte(offset);
+        if (pip > max_pip) return fail(offset, "pip out of range");
+        board.pips[k] = static_cast<unsigned char>(pip);
+    }
+
+    if (directions != nullptr && (flags & PACKED_PLACEMENT)) {
+        size_t base = PACKED_BOARD_HEADER + pip_bytes(cells, nibbles);
+        directions->resize(cells);
+        for (size_t k = 0; k < cells; ++k) {
+            (*directions)[k] = (byte(base + k / 4) >> (k % 4 * 2)) & 3;
+        }
+    }
+    return true;
+}
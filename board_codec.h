@@ -0,0 +1,69 @@
+#pragma once
+
+#include "board_parser.h"
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * @file board_codec.h
+ * @brief Compact binary encoding of boards and solutions, served as application/octet-stream.
+ *
+ * Layout (multi-byte integers big-endian):
+ *
+ *     offset 0  'D' 'B'          magic
+ *     offset 2  uint8 version    PACKED_BOARD_VERSION
+ *     offset 3  uint8 flags      PACKED_* bits below
+ *     offset 4  uint16 rows
+ *     offset 6  uint16 cols
+ *     offset 8  pips             row-major; one byte each, or two per byte (high nibble first)
+ *                                when PACKED_NIBBLES is set
+ *     then      directions       only with PACKED_PLACEMENT: 2 bits per cell, four cells per byte,
+ *                                lowest bits first, naming the cell holding the other half of the
+ *                                cell's domino (PlacementDirection)
+ */
+
+const char *const PACKED_BOARD_MIME = "application/octet-stream";
+
+const unsigned char PACKED_BOARD_VERSION = 1;
+
+/// Header bytes before the pips.
+const size_t PACKED_BOARD_HEADER = 8;
+
+const unsigned char PACKED_NIBBLES = 0x01;   ///< Every pip fits in 4 bits and is stored as a nibble.
+const unsigned char PACKED_PLACEMENT = 0x02; ///< Placement directions follow the pips.
+const unsigned char PACKED_SOLVED = 0x04;    ///< The placement is a complete solution.
+
+/// Where the other half of a cell's domino lies.
+enum PlacementDirection : unsigned char {
+    PLACEMENT_RIGHT = 0,
+    PLACEMENT_DOWN = 1,
+    PLACEMENT_LEFT = 2,
+    PLACEMENT_UP = 3
+};
+
+/**
+ * @brief Derives each cell's PlacementDirection from a solver placement (domino index per cell).
+ * @return rows * cols directions, row-major.
+ */
+std::vector<unsigned char> placement_directions(const std::vector<std::vector<int>> &placement);
+
+/**
+ * @brief Encodes @p board, with its placement @p directions if given.
+ * @param solved Sets PACKED_SOLVED; only meaningful with @p directions.
+ */
+std::string encode_packed_board(const FlatBoard &board, const std::vector<unsigned char> *directions = nullptr,
+                                bool solved = false);
+
+/**
+ * @brief Decodes a packed board, checking the header, the exact length and the pip range.
+ * @param directions If non-null and the input carries a placement, receives it.
+ * @return false on malformed input, with @p error pointing at the offending byte.
+ */
+bool decode_packed_board(const char *data, size_t size, FlatBoard &board, BoardParseError &error,
+                         std::vector<unsigned char> *directions = nullptr, int max_pip = BOARD_MAX_PIP);
+
+inline bool decode_packed_board(const std::string &data, FlatBoard &board, BoardParseError &error,
+                                std::vector<unsigned char> *directions = nullptr, int max_pip = BOARD_MAX_PIP) {
+    return decode_packed_board(data.data(), data.size(), board, error, directions, max_pip);
+}
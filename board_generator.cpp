@@ -1,4 +1,5 @@
 #include "board_generator.h"
+#include "utils.h"
 #include <random>
 #include <algorithm>
 #include <iostream>
@@ -6,6 +7,8 @@
 #include <vector>
 #include <string>
 #include <chrono>
+#include <stdexcept>
+#include <tuple>
 
 std::vector<Domino> generate_dominos(int max_pips) {
     std::vector<Domino> dominos;
@@ -39,21 +42,83 @@ void place_dominos_on_board(std::vector<std::vector<int>> &board, const std::vec
     }
 }
 
-std::string board_to_json_string(const std::vector<std::vector<int>> &vec) {
-    std::string result = "[";
-    for (int i = 0; i < vec.size(); ++i) {
-        if (i > 0) result += ",";
-        result += "[";
-        for (int j = 0; j < vec[i].size(); ++j) {
-            if (j > 0) result += ",";
-            result += std::to_string(vec[i][j]);
+// "00" "01" ... "99": two digits per lookup when writing integers.
+static const char DIGIT_PAIRS[] =
+        "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+        "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+        "8081828384858687888990919293949596979899";
+
+static unsigned magnitude_of(int value) {
+    return value < 0 ? 0u - static_cast<unsigned>(value) : static_cast<unsigned>(value);
+}
+
+/// Writes @p value in exactly decimal_width(value) characters at @p out; returns the end.
+static char *write_json_int(char *out, int value) {
+    char *end = out + decimal_width(value);
+    char *pos = end;
+    unsigned magnitude = magnitude_of(value);
+    while (magnitude >= 100) {
+        unsigned pair = magnitude % 100 * 2;
+        magnitude /= 100;
+        *--pos = DIGIT_PAIRS[pair + 1];
+        *--pos = DIGIT_PAIRS[pair];
+    }
+    if (magnitude >= 10) {
+        *--pos = DIGIT_PAIRS[magnitude * 2 + 1];
+        *--pos = DIGIT_PAIRS[magnitude * 2];
+    } else {
+        *--pos = static_cast<char>('0' + magnitude);
+    }
+    if (value < 0) *--pos = '-';
+    return end;
+}
+
+size_t board_json_size(const std::vector<std::vector<int>> &vec) {
+    size_t size = 2; // outer brackets
+    for (const auto &row: vec) {
+        size += 2 + (row.empty() ? 0 : row.size() - 1); // row brackets and commas
+        for (int value: row) size += decimal_width(value);
+    }
+    return size + (vec.empty() ? 0 : vec.size() - 1);
+}
+
+void append_board_json(const std::vector<std::vector<int>> &vec, std::string &out) {
+    size_t start = out.size();
+    out.resize(start + board_json_size(vec));
+    char *pos = &out[start];
+    *pos++ = '[';
+    for (size_t i = 0; i < vec.size(); ++i) {
+        if (i > 0) *pos++ = ',';
+        *pos++ = '[';
+        for (size_t j = 0; j < vec[i].size(); ++j) {
+            if (j > 0) *pos++ = ',';
+            pos = write_json_int(pos, vec[i][j]);
         }
-        result += "]";
+        *pos++ = ']';
     }
-    result += "]";
+    *pos = ']';
+}
+
+std::string board_to_json_string(const std::vector<std::vector<int>> &vec) {
+    std::string result;
+    append_board_json(vec, result);
     return result;
 }
 
+std::string board_response_json(const std::string &board_json, int id) {
+    static const char prefix[] = "{\"board\":";
+    static const char infix[] = ",\"id\":";
+    std::string body;
+    body.resize(sizeof(prefix) - 1 + board_json.size() + sizeof(infix) - 1 + decimal_width(id) + 1);
+    char *pos = &body[0];
+    pos = std::copy(prefix, prefix + sizeof(prefix) - 1, pos);
+    pos = std::copy(board_json.begin(), board_json.end(), pos);
+    pos = std::copy(infix, infix + sizeof(infix) - 1, pos);
+    pos = write_json_int(pos, id);
+    *pos = '}';
+    return body;
+}
+
 std::vector<std::vector<int>> generate_board(int rows, int cols) {
     int max_pips = std::max(rows, cols) - 1;
     auto dominos = generate_dominos(max_pips);
@@ -1,13 +1,29 @@
 #pragma once
 
+#include "board_parser.h"
 #include "domino.h"
+#include <cstddef>
 #include <vector>
 #include <string>
 
 std::vector<Domino> generate_dominos(int max_pips);
 
+/// Exact length of the JSON text append_board_json writes for @p vec.
+size_t board_json_size(const std::vector<std::vector<int>> &vec);
+
+/// Appends @p vec as compact JSON (`[[0,1],[2,3]]`), sized up front and written in place.
+void append_board_json(const std::vector<std::vector<int>> &vec, std::string &out);
+
+/// The compact JSON text of @p vec: the form boards are stored in and served as.
 std::string board_to_json_string(const std::vector<std::vector<int>> &vec);
 
+/// The generate_board response body, `{"board":<board_json>,"id":<id>}`, in one allocation.
+std::string board_response_json(const std::string &board_json, int id);
+
+/// Longest side /generate_board hands out. generate_board's pips reach max(rows, cols) - 1, and a
+/// board with pips over BOARD_MAX_PIP could be neither solved nor packed.
+const int GENERATED_BOARD_MAX_SIDE = BOARD_MAX_PIP + 1;
+
 std::vector<std::vector<int>> generate_board(int rows, int cols);
 
 std::vector<std::vector<std::vector<int>>> generate_all_boards(int rows, int cols);
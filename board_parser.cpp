@@ -0,0 +1,130 @@
+#include "board_parser.h"
+
+/**
+ * @file board_parser.cpp
+ * @brief Implementation of the flat board parser.
+ */
+
+std::vector<std::vector<int>> FlatBoard::to_rows() const {
+    std::vector<std::vector<int>> result(rows, std::vector<int>(cols));
+    for (int i = 0; i < rows; ++i) {
+        for (int j = 0; j < cols; ++j) {
+            result[i][j] = at(i, j);
+        }
+    }
+    return result;
+}
+
+bool flatten_board(const std::vector<std::vector<int>> &rows, FlatBoard &board) {
+    if (rows.empty() || rows[0].empty()) return false;
+    board.rows = rows.size();
+    board.cols = rows[0].size();
+    board.pips.clear();
+    board.pips.reserve(static_cast<size_t>(board.rows) * board.cols);
+    for (const auto &row: rows) {
+        if (static_cast<int>(row.size()) != board.cols) return false;
+        for (int pip: row) {
+            if (pip < 0 || pip > BOARD_MAX_PIP) return false;
+            board.pips.push_back(static_cast<unsigned char>(pip));
+        }
+    }
+    return true;
+}
+
+namespace {
+    /// Cursor over the input; every failure records its position and message.
+    struct Cursor {
+        const char *begin;
+        const char *pos;
+        const char *end;
+        BoardParseError &error;
+
+        void skip_whitespace() {
+            while (pos != end && (*pos == ' ' || *pos == '\t' || *pos == '\n' || *pos == '\r')) ++pos;
+        }
+
+        bool fail(const char *message) {
+            error.offset = static_cast<size_t>(pos - begin);
+            error.message = message;
+            return false;
+        }
+
+        bool expect(char c, const char *message) {
+            skip_whitespace();
+            if (pos == end || *pos != c) return fail(message);
+            ++pos;
+            return true;
+        }
+
+        /// Consumes ',' (returns true, @p more set) or @p close (returns true, @p more cleared).
+        bool separator(char close, bool &more, const char *message) {
+            skip_whitespace();
+            if (pos != end && *pos == ',') {
+                ++pos;
+                more = true;
+                return true;
+            }
+            if (pos != end && *pos == close) {
+                ++pos;
+                more = false;
+                return true;
+            }
+            return fail(message);
+        }
+    };
+}
+
+bool parse_board(const char *data, size_t size, FlatBoard &board, BoardParseError &error, int max_pip) {
+    Cursor in{data, data, data + size, error};
+    board.rows = 0;
+    board.cols = 0;
+    board.pips.clear();
+    // Each pip takes at least two bytes ("0,"), which bounds the buffer without a second pass.
+    board.pips.reserve(size / 2);
+
+    if (!in.expect('[', "expected '[' opening the board")) return false;
+    bool more_rows = true;
+    while (more_rows) {
+        if (!in.expect('[', "expected '[' opening a row")) return false;
+
+        int cols = 0;
+        bool more_pips = true;
+        while (more_pips) {
+            in.skip_whitespace();
+            if (in.pos == in.end || *in.pos < '0' || *in.pos > '9') {
+                if (in.pos != in.end && *in.pos == '-') return in.fail("pip out of range");
+                return in.fail("expected a pip value");
+            }
+            const char *start = in.pos;
+            int value = 0;
+            while (in.pos != in.end && *in.pos >= '0' && *in.pos <= '9') {
+                value = value * 10 + (*in.pos - '0');
+                ++in.pos;
+                if (value > max_pip) {
+                    in.pos = start;
+                    return in.fail("pip out of range");
+                }
+            }
+            board.pips.push_back(static_cast<unsigned char>(value));
+            ++cols;
+            if (board.rows > 0 && cols > board.cols) {
+                in.pos = start;
+                return in.fail("row is longer than the first row");
+            }
+            if (!in.separator(']', more_pips, "expected ',' or ']' after a pip")) return false;
+        }
+
+        if (board.rows == 0) {
+            board.cols = cols;
+        } else if (cols != board.cols) {
+            --in.pos; // point at the ']' that closed the row early
+            return in.fail("row is shorter than the first row");
+        }
+        ++board.rows;
+        if (!in.separator(']', more_rows, "expected ',' or ']' after a row")) return false;
+    }
+
+    in.skip_whitespace();
+    if (in.pos != in.end) return in.fail("unexpected data after the board");
+    return true;
+}
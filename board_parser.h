@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * @file board_parser.h
+ * @brief Single-pass parser from a JSON array of pip rows straight into a flat board.
+ */
+
+/// Largest pip value a board may contain: what one FlatBoard byte holds. generate_board uses
+/// pips up to max(rows, cols) - 1, which GENERATED_BOARD_MAX_SIDE keeps within this bound.
+const int BOARD_MAX_PIP = 255;
+
+/**
+ * @struct FlatBoard
+ * @brief A rectangular board stored row-major in one buffer.
+ */
+struct FlatBoard {
+    int rows = 0;
+    int cols = 0;
+    std::vector<unsigned char> pips; ///< rows * cols values, row-major.
+
+    int at(int row, int col) const { return pips[static_cast<size_t>(row) * cols + col]; }
+
+    /// The nested-vector form the solver and printers take.
+    std::vector<std::vector<int>> to_rows() const;
+};
+
+/**
+ * @brief Copies a nested-vector board into @p board.
+ * @return false if @p rows is empty or ragged, or a pip lies outside [0, BOARD_MAX_PIP].
+ */
+bool flatten_board(const std::vector<std::vector<int>> &rows, FlatBoard &board);
+
+/**
+ * @struct BoardParseError
+ * @brief Why and where parse_board rejected its input.
+ */
+struct BoardParseError {
+    size_t offset = 0;   ///< Byte offset into the input of the offending character.
+    std::string message; ///< What was expected or wrong there.
+};
+
+/**
+ * @brief Parses `[[p, p, ...], [p, p, ...], ...]` into @p board in one pass over @p data.
+ *
+ * Only what a board can hold is accepted: a non-empty array of non-empty rows of equal length,
+ * each pip a plain decimal integer in [0, @p max_pip]. Whitespace is allowed between tokens.
+ * Nothing is allocated per row or per number.
+ *
+ * @return false on malformed input, with @p error pointing at the first offending byte.
+ */
+bool parse_board(const char *data, size_t size, FlatBoard &board, BoardParseError &error,
+                 int max_pip = BOARD_MAX_PIP);
+
+inline bool parse_board(const std::string &text, FlatBoard &board, BoardParseError &error,
+                        int max_pip = BOARD_MAX_PIP) {
+    return parse_board(text.data(), text.size(), board, error, max_pip);
+}
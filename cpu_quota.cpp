@@ -0,0 +1,98 @@
+#include "cpu_quota.h"
+
+#include <algorithm>
+#include <cmath>
+#include <ctime>
+#include <limits>
+
+/**
+ * @file cpu_quota.cpp
+ * @brief Implementation of the rolling CPU-time quotas.
+ */
+
+std::chrono::nanoseconds thread_cpu_time() {
+    timespec ts{};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec);
+}
+
+CpuQuota::CpuQuota(std::chrono::nanoseconds budget, std::chrono::seconds window)
+        : budget_(budget), window_(window),
+          slot_length_(std::max<clock::duration>(std::chrono::milliseconds(1), window / WINDOW_SLOTS)) {}
+
+int64_t CpuQuota::slot_of(clock::time_point when) const {
+    return static_cast<int64_t>(when.time_since_epoch() / slot_length_);
+}
+
+std::chrono::nanoseconds CpuQuota::total_locked(const Account &account, int64_t current, int64_t &oldest,
+                                                uint64_t *requests) const {
+    int64_t total = 0;
+    oldest = std::numeric_limits<int64_t>::max();
+    for (size_t i = 0; i < WINDOW_SLOTS; ++i) {
+        if (account.slot[i] <= current - static_cast<int64_t>(WINDOW_SLOTS) || account.used_ns[i] == 0) continue;
+        total += account.used_ns[i];
+        if (requests != nullptr) *requests += account.requests[i];
+        oldest = std::min(oldest, account.slot[i]);
+    }
+    return std::chrono::nanoseconds(total);
+}
+
+bool CpuQuota::admit(const std::string &account, int &retry_after, clock::time_point now) {
+    int64_t current = slot_of(now);
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = accounts_.find(account);
+    if (it == accounts_.end()) return true;
+
+    int64_t oldest;
+    if (total_locked(it->second, current, oldest) < budget_) return true;
+
+    // The oldest slot leaves the window at the start of slot oldest + WINDOW_SLOTS.
+    auto frees_at = clock::time_point((oldest + static_cast<int64_t>(WINDOW_SLOTS)) * slot_length_);
+    double seconds = std::chrono::duration<double>(frees_at - now).count();
+    retry_after = std::max(1, static_cast<int>(std::ceil(seconds)));
+    return false;
+}
+
+void CpuQuota::charge(const std::string &account, const std::string &username, std::chrono::nanoseconds used,
+                      clock::time_point now) {
+    int64_t current = slot_of(now);
+    size_t index = static_cast<size_t>(current) % WINDOW_SLOTS;
+    std::lock_guard<std::mutex> lock(mutex_);
+    Account &entry = accounts_[account];
+    entry.username = username;
+    if (entry.slot[index] != current) {
+        entry.slot[index] = current;
+        entry.used_ns[index] = 0;
+        entry.requests[index] = 0;
+    }
+    // Never record zero, which total_locked reads as an empty slot.
+    entry.used_ns[index] += std::max<int64_t>(1, used.count());
+    ++entry.requests[index];
+}
+
+std::vector<CpuQuota::Usage> CpuQuota::usage(clock::time_point now) {
+    int64_t current = slot_of(now);
+    std::vector<Usage> result;
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto it = accounts_.begin(); it != accounts_.end();) {
+        int64_t oldest;
+        uint64_t requests = 0;
+        std::chrono::nanoseconds used = total_locked(it->second, current, oldest, &requests);
+        if (used.count() == 0) {
+            // Nothing left inside the window: forget the account.
+            it = accounts_.erase(it);
+            continue;
+        }
+        result.push_back({it->first, it->second.username, used, requests});
+        ++it;
+    }
+    return result;
+}
+
+CpuCharge::CpuCharge(CpuQuota &quota, std::string account, std::string username)
+        : quota_(quota), account_(std::move(account)), username_(std::move(username)),
+          start_(thread_cpu_time()) {}
+
+CpuCharge::~CpuCharge() {
+    quota_.charge(account_, username_, thread_cpu_time() - start_);
+}
@@ -0,0 +1,112 @@
+#ifndef DOMINOREST_CPU_QUOTA_H
+#define DOMINOREST_CPU_QUOTA_H
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @file cpu_quota.h
+ * @brief Rolling-window quotas on the CPU time callers spend in the solver.
+ */
+
+/**
+ * @brief CPU time the calling thread has consumed so far (CLOCK_THREAD_CPUTIME_ID).
+ */
+std::chrono::nanoseconds thread_cpu_time();
+
+/**
+ * @class CpuQuota
+ * @brief Tracks CPU time per account over a rolling window and refuses work once the budget is spent.
+ *
+ * The window is split into WINDOW_SLOTS slots; an account's usage is the sum of its slots still
+ * inside the window, so old work ages out gradually instead of all at once. admit() is checked
+ * before work starts and charge() after it ends: a running request always finishes, and the
+ * account is refused only for the work that follows.
+ */
+class CpuQuota {
+public:
+    using clock = std::chrono::steady_clock;
+
+    /// One account's standing, as reported by usage().
+    struct Usage {
+        std::string account;
+        std::string username;
+        std::chrono::nanoseconds used;
+        uint64_t requests; ///< Requests charged inside the window.
+    };
+
+    /**
+     * @param budget CPU time each account may use per @p window.
+     * @param window Length of the rolling window.
+     */
+    CpuQuota(std::chrono::nanoseconds budget, std::chrono::seconds window);
+
+    /**
+     * @brief Checks whether @p account may start more work.
+     * @param retry_after On refusal, whole seconds until part of its usage leaves the window.
+     */
+    bool admit(const std::string &account, int &retry_after, clock::time_point now = clock::now());
+
+    /// Records @p used CPU time against @p account, owned by @p username.
+    void charge(const std::string &account, const std::string &username, std::chrono::nanoseconds used,
+                clock::time_point now = clock::now());
+
+    /// Every account with usage inside the window.
+    std::vector<Usage> usage(clock::time_point now = clock::now());
+
+    std::chrono::nanoseconds budget() const { return budget_; }
+
+    std::chrono::seconds window() const { return window_; }
+
+private:
+    static const size_t WINDOW_SLOTS = 60;
+
+    struct Account {
+        std::string username;
+        std::array<int64_t, WINDOW_SLOTS> used_ns{};
+        std::array<uint64_t, WINDOW_SLOTS> requests{};
+        std::array<int64_t, WINDOW_SLOTS> slot{}; ///< Absolute slot number each entry belongs to.
+    };
+
+    int64_t slot_of(clock::time_point when) const;
+
+    /// Sums the slots of @p account still inside the window; @p oldest receives the earliest one.
+    std::chrono::nanoseconds total_locked(const Account &account, int64_t current, int64_t &oldest,
+                                          uint64_t *requests = nullptr) const;
+
+    std::chrono::nanoseconds budget_;
+    std::chrono::seconds window_;
+    clock::duration slot_length_;
+    std::mutex mutex_;
+    std::unordered_map<std::string, Account> accounts_;
+};
+
+/**
+ * @class CpuCharge
+ * @brief Measures the calling thread's CPU time over its own lifetime and charges it on destruction.
+ *
+ * Must be destroyed on the thread that created it.
+ */
+class CpuCharge {
+public:
+    CpuCharge(CpuQuota &quota, std::string account, std::string username);
+
+    ~CpuCharge();
+
+    CpuCharge(const CpuCharge &) = delete;
+
+    CpuCharge &operator=(const CpuCharge &) = delete;
+
+private:
+    CpuQuota &quota_;
+    std::string account_;
+    std::string username_;
+    std::chrono::nanoseconds start_;
+};
+
+#endif //DOMINOREST_CPU_QUOTA_H
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <chrono>
 #include <string>
 #include <functional>
@@ -296,6 +297,30 @@ namespace crow
         {
             return compression_used_;
         }
+
+        /// zlib level (1-9, or Z_DEFAULT_COMPRESSION) for routes that don't set their own; 0 disables compression.
+        self_t& compression_level(int level)
+        {
+            comp_level_ = level;
+            return *this;
+        }
+
+        int compression_level() const
+        {
+            return comp_level_;
+        }
+
+        /// Bodies shorter than this are sent uncompressed: the saving would not pay for the CPU and the gzip framing.
+        self_t& compression_min_size(size_t size)
+        {
+            comp_min_size_ = size;
+            return *this;
+        }
+
+        size_t compression_min_size() const
+        {
+            return comp_min_size_;
+        }
 #endif
 
         /// Apply blueprints
@@ -552,6 +577,49 @@ namespace crow
 #endif
         }
 
+        /// Connections open on the server's busiest IO thread; 0 until the server is running.
+        unsigned int io_queue_length()
+        {
+            if (server_)
+                return server_->max_task_queue_length();
+#ifdef CROW_ENABLE_SSL
+            if (ssl_server_)
+                return ssl_server_->max_task_queue_length();
+#endif
+            return 0;
+        }
+
+        /// HTTP connections open on all of the server's IO threads; 0 until the server is running.
+        unsigned int open_connections()
+        {
+            if (server_)
+                return server_->open_connections();
+#ifdef CROW_ENABLE_SSL
+            if (ssl_server_)
+                return ssl_server_->open_connections();
+#endif
+            return 0;
+        }
+
+        /// Stop accepting connections and answer every further request with `Connection: close`,
+        /// leaving requests in progress to finish; call \ref stop() once they have.
+        void stop_accepting()
+        {
+            draining_ = true;
+            if (server_)
+                server_->stop_accepting();
+#ifdef CROW_ENABLE_SSL
+            if (ssl_server_)
+                ssl_server_->stop_accepting();
+#endif
+        }
+
+        /// Whether \ref stop_accepting() has been called
+        bool draining() const
+        {
+            return draining_;
+        }
+
     private:
         template<typename... Ts>
         std::tuple<Middlewares...> make_middleware_tuple(Ts&&... ts)
@@ -592,6 +660,8 @@ namespace crow
 #ifdef CROW_ENABLE_COMPRESSION
         compression::algorithm comp_algorithm_;
         bool compression_used_{false};
+        int comp_level_{Z_DEFAULT_COMPRESSION};
+        size_t comp_min_size_{1024};
 #endif
 
         std::chrono::milliseconds tick_interval_;
@@ -608,6 +678,7 @@ namespace crow
         std::unique_ptr<server_t> server_;
 
         std::vector<int> signals_{SIGINT, SIGTERM};
+        std::atomic<bool> draining_{false};
 
         bool server_started_{false};
         std::condition_variable cv_started_;
@@ -1,6 +1,9 @@
 #ifdef CROW_ENABLE_COMPRESSION
 #pragma once
 
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
 #include <string>
 #include <zlib.h>
 
@@ -19,40 +22,76 @@ namespace crow
             GZIP = 15 | 16,
         };
 
-        inline std::string compress_string(std::string const& str, algorithm algo)
+        /// Level meaning "not set here": a response defers to its route, a route to the App.
+        constexpr int INHERIT_LEVEL = -2;
+
+        namespace detail
         {
-            std::string compressed_str;
-            z_stream stream{};
-            // Initialize with the default values
-            if (::deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, algo, 8, Z_DEFAULT_STRATEGY) == Z_OK)
+            /// A deflate stream kept for the life of the thread and reset between bodies, rather than allocating
+            /// zlib's ~256 KiB of state with deflateInit2 and freeing it again for every response. Each stream keeps
+            /// the level it was created with: deflateParams right after deflateReset is unsafe on older zlib (1.2.11
+            /// flushes through the previous body's freed output buffer when the deflate function changes).
+            class deflate_stream
             {
-                char buffer[8192];
-
-                stream.avail_in = str.size();
-                // zlib does not take a const pointer. The data is not altered.
-                stream.next_in = const_cast<Bytef*>(reinterpret_cast<const Bytef*>(str.c_str()));
-
-                int code = Z_OK;
-                do
+            public:
+                ~deflate_stream()
                 {
-                    stream.avail_out = sizeof(buffer);
-                    stream.next_out = reinterpret_cast<Bytef*>(&buffer[0]);
+                    if (initialized_)
+                        ::deflateEnd(&stream_);
+                }
 
-                    code = ::deflate(&stream, Z_FINISH);
-                    // Successful and non-fatal error code returned by deflate when used with Z_FINISH flush
-                    if (code == Z_OK || code == Z_STREAM_END)
+                /// The stream, ready to compress a new body, or nullptr if zlib could not set it up.
+                z_stream* get(algorithm algo, int level)
+                {
+                    if (!initialized_)
                     {
-                        std::copy(&buffer[0], &buffer[sizeof(buffer) - stream.avail_out], std::back_inserter(compressed_str));
+                        if (::deflateInit2(&stream_, level, Z_DEFLATED, algo, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+                            return nullptr;
+                        initialized_ = true;
+                        return &stream_;
                     }
-
-                } while (code == Z_OK);
-
-                if (code != Z_STREAM_END)
-                    compressed_str.clear();
-
-                ::deflateEnd(&stream);
+                    if (::deflateReset(&stream_) != Z_OK)
+                        return nullptr;
+                    return &stream_;
+                }
+
+            private:
+                z_stream stream_{};
+                bool initialized_ = false;
+            };
+
+            /// The calling thread's stream for @p algo at @p level, or nullptr for a level zlib does not know.
+            /// Streams are created on first use, so only the levels the routes actually ask for cost memory.
+            inline deflate_stream* thread_deflate_stream(algorithm algo, int level)
+            {
+                if (level < Z_DEFAULT_COMPRESSION || level > Z_BEST_COMPRESSION)
+                    return nullptr;
+                thread_local deflate_stream deflate_streams[2][Z_BEST_COMPRESSION - Z_DEFAULT_COMPRESSION + 1];
+                return &deflate_streams[algo == GZIP ? 1 : 0][level - Z_DEFAULT_COMPRESSION];
             }
+        } // namespace detail
 
+        /// Compresses @p str with the calling thread's stream for @p algo. Returns an empty string on failure.
+        inline std::string compress_string(std::string const& str, algorithm algo, int level = Z_DEFAULT_COMPRESSION)
+        {
+            std::string compressed_str;
+            detail::deflate_stream* deflate = detail::thread_deflate_stream(algo, level);
+            z_stream* stream = deflate == nullptr ? nullptr : deflate->get(algo, level);
+            if (stream == nullptr)
+                return compressed_str;
+
+            // deflateBound is an upper limit for the whole output, so one Z_FINISH call completes the stream.
+            compressed_str.resize(::deflateBound(stream, str.size()));
+            stream->avail_in = str.size();
+            // zlib does not take a const pointer. The data is not altered.
+            stream->next_in = const_cast<Bytef*>(reinterpret_cast<const Bytef*>(str.data()));
+            stream->avail_out = compressed_str.size();
+            stream->next_out = reinterpret_cast<Bytef*>(&compressed_str[0]);
+
+            if (::deflate(stream, Z_FINISH) == Z_STREAM_END)
+                compressed_str.resize(compressed_str.size() - stream->avail_out);
+            else
+                compressed_str.clear();
             return compressed_str;
         }
 
@@ -93,6 +132,46 @@ namespace crow
 
             return inflated_string;
         }
+
+        /// Whether an Accept-Encoding header value admits @p coding: listed (or covered by "*") with a q-value above
+        /// zero. An explicit entry for @p coding wins over "*", so "*, gzip;q=0" still refuses gzip.
+        inline bool accepts_encoding(const std::string& accept_encoding, const std::string& coding)
+        {
+            auto trim = [](const std::string& text, size_t begin, size_t end) {
+                while (begin < end && (text[begin] == ' ' || text[begin] == '\t'))
+                    ++begin;
+                while (end > begin && (text[end - 1] == ' ' || text[end - 1] == '\t'))
+                    --end;
+                return text.substr(begin, end - begin);
+            };
+            int wildcard = -1; // -1 absent, otherwise whether "*" is acceptable
+            size_t start = 0;
+            while (start <= accept_encoding.size())
+            {
+                size_t end = accept_encoding.find(',', start);
+                if (end == std::string::npos)
+                    end = accept_encoding.size();
+                size_t params = accept_encoding.find(';', start);
+                std::string name = trim(accept_encoding, start, params < end ? params : end);
+                bool acceptable = true;
+                for (size_t semicolon = params; semicolon < end;)
+                {
+                    size_t next = std::min(accept_encoding.find(';', semicolon + 1), end);
+                    std::string param = trim(accept_encoding, semicolon + 1, next);
+                    if (param.size() >= 2 && (param[0] == 'q' || param[0] == 'Q') && param[1] == '=')
+                        acceptable = std::strtod(param.c_str() + 2, nullptr) > 0;
+                    semicolon = next;
+                }
+                if (name.size() == coding.size() && std::equal(name.begin(), name.end(), coding.begin(), [](char a, char b) {
+                        return std::tolower(static_cast<unsigned char>(a)) == std::tolower(static_cast<unsigned char>(b));
+                    }))
+                    return acceptable;
+                if (name == "*")
+                    wildcard = acceptable;
+                start = end + 1;
+            }
+            return wildcard == 1;
+        }
     } // namespace compression
 } // namespace crow
 
@@ -8,6 +8,8 @@
 #include <chrono>
 #include <vector>
 #include <memory>
+#include <fstream>
+#include <string>
 
 #include "crow/http_parser_merged.h"
 #include "crow/common.h"
@@ -66,6 +68,8 @@ namespace crow
 
         ~Connection()
         {
+            if (counted_open_)
+                queue_length_--;
 #ifdef CROW_ENABLE_DEBUG
             connectionCount--;
             CROW_LOG_DEBUG << "Connection (" << this << ") freed, total: " << connectionCount;
@@ -80,14 +84,15 @@ namespace crow
 
         void start()
         {
+            // Open from here until destruction; the server balances connections across IO threads by this count.
+            queue_length_++;
+            counted_open_ = true;
             auto self = this->shared_from_this();
             adaptor_.start([self](const asio::error_code& ec) {
                 if (!ec)
                 {
-                    self->start_deadline();
                     self->parser_.clear();
-
-                    self->do_read();
+                    self->process_input();
                 }
                 else
                 {
@@ -96,35 +101,22 @@ namespace crow
             });
         }
 
-        void handle_url()
-        {
-            routing_handle_result_ = handler_->handle_initial(req_, res);
-            // if no route is found for the request method, return the response without parsing or processing anything further.
-            if (!routing_handle_result_->rule_index)
-            {
-                parser_.done();
-                need_to_call_after_handlers_ = true;
-                complete_request();
-            }
-        }
-
         void handle_header()
         {
             // HTTP 1.1 Expect: 100-continue
             if (req_.http_ver_major == 1 && req_.http_ver_minor == 1 && get_header_value(req_.headers, "expect") == "100-continue")
             {
-                continue_requested = true;
-                buffers_.clear();
+                // Queued behind any responses still owed to earlier pipelined requests; process_input() writes it
+                // out before waiting for the body.
                 static std::string expect_100_continue = "HTTP/1.1 100 Continue\r\n\r\n";
-                buffers_.emplace_back(expect_100_continue.data(), expect_100_continue.size());
-                do_write();
+                output_.push_back(expect_100_continue);
             }
         }
 
         void handle()
         {
-            // TODO(EDev): cancel_deadline_timer should be looked into, it might be a good idea to add it to handle_url() and then restart the timer once everything passes
             cancel_deadline_timer();
+            awaiting_response_ = true;
             bool is_invalid_request = false;
             add_keep_alive_ = false;
 
@@ -136,8 +128,13 @@ namespace crow
             
             req_.remote_ip_address = adaptor_.remote_endpoint().address().to_string();
 
-            add_keep_alive_ = req_.keep_alive;
-            close_connection_ = req_.close_connection;
+            // A draining server answers what it has already read, then lets the connection go.
+            close_connection_ = req_.close_connection || handler_->draining();
+            add_keep_alive_ = req_.keep_alive && !close_connection_;
+
+            // Routing waits for the whole request: answering before the body is read would leave that body in the
+            // stream, where it would be taken for the next pipelined request.
+            routing_handle_result_ = handler_->handle_initial(req_, res);
 
             if (req_.check_version(1, 1)) // HTTP/1.1
             {
@@ -160,6 +157,14 @@ namespace crow
                         detail::middleware_call_helper<detail::middleware_call_criteria_only_global,
                                                        0, decltype(ctx_), decltype(*middlewares_)>({}, *middlewares_, req_, res, ctx_);
                         close_connection_ = true;
+                        upgraded_ = true;
+                        awaiting_response_ = false;
+                        // A read-ahead still pending on the socket would swallow the first frames meant for the new protocol.
+                        if (reading_)
+                        {
+                            asio::error_code ec;
+                            adaptor_.raw_socket().cancel(ec);
+                        }
                         handler_->handle_upgrade(req_, res, std::move(adaptor_));
                         return;
                     }
@@ -170,7 +175,7 @@ namespace crow
 
 
             need_to_call_after_handlers_ = false;
-            if (!is_invalid_request)
+            if (!is_invalid_request && routing_handle_result_->rule_index)
             {
                 res.complete_request_handler_ = nullptr;
                 auto self = this->shared_from_this();
@@ -189,8 +194,6 @@ namespace crow
                     };
                     need_to_call_after_handlers_ = true;
                     handler_->handle(req_, res, routing_handle_result_);
-                    if (add_keep_alive_)
-                        res.set_header("connection", "Keep-Alive");
                 }
                 else
                 {
@@ -199,11 +202,13 @@ namespace crow
             }
             else
             {
+                // No route: handle_initial already filled in the 404, 405 or OPTIONS answer.
+                need_to_call_after_handlers_ = !is_invalid_request;
                 complete_request();
             }
         }
 
-        /// Call the after handle middleware and send the write the response to the connection.
+        /// Call the after handle middleware and queue the response for writing.
         void complete_request()
         {
             CROW_LOG_INFO << "Response: " << this << ' ' << req_.raw_url << ' ' << res.code << ' ' << close_connection_;
@@ -223,28 +228,44 @@ namespace crow
 #ifdef CROW_ENABLE_COMPRESSION
             if (handler_->compression_used())
             {
+                int level = res.compression_level != compression::INHERIT_LEVEL ? res.compression_level : handler_->compression_level();
                 std::string accept_encoding = req_.get_header_value("Accept-Encoding");
-                if (!accept_encoding.empty() && res.compressed)
+                // Small bodies go out as they are: the saving would not pay for the CPU and the gzip framing.
+                if (res.compressed && level != 0 && res.body.size() >= handler_->compression_min_size() &&
+                    !res.headers.count("Content-Encoding"))
                 {
+                    // From here the body sent depends on Accept-Encoding, whichever way it goes for this client,
+                    // so a shared cache must not hand one client's form to another.
+                    std::string vary = res.get_header_value("Vary");
+                    if (vary.empty())
+                        res.set_header("Vary", "Accept-Encoding");
+                    else if (vary.find("Accept-Encoding") == std::string::npos)
+                        res.set_header("Vary", vary + ", Accept-Encoding");
+
+                    const char* encoding = nullptr;
                     switch (handler_->compression_algorithm())
                     {
                         case compression::DEFLATE:
-                            if (accept_encoding.find("deflate") != std::string::npos)
-                            {
-                                res.body = compression::compress_string(res.body, compression::algorithm::DEFLATE);
-                                res.set_header("Content-Encoding", "deflate");
-                            }
+                            if (compression::accepts_encoding(accept_encoding, "deflate"))
+                                encoding = "deflate";
                             break;
                         case compression::GZIP:
-                            if (accept_encoding.find("gzip") != std::string::npos)
-                            {
-                                res.body = compression::compress_string(res.body, compression::algorithm::GZIP);
-                                res.set_header("Content-Encoding", "gzip");
-                            }
+                            if (compression::accepts_encoding(accept_encoding, "gzip"))
+                                encoding = "gzip";
                             break;
                         default:
                             break;
                     }
+                    if (encoding)
+                    {
+                        std::string compressed_body = compression::compress_string(res.body, handler_->compression_algorithm(), level);
+                        // An empty result means zlib failed; incompressible bodies are not worth the header either.
+                        if (!compressed_body.empty() && compressed_body.size() < res.body.size())
+                        {
+                            res.body = std::move(compressed_body);
+                            res.set_header("Content-Encoding", encoding);
+                        }
+                    }
                 }
             }
 #endif
@@ -261,30 +282,32 @@ namespace crow
                 res.set_header("location", location);
             }
 
-            prepare_buffers();
-
-            if (res.is_static_type())
+            res.complete_request_handler_ = nullptr;
+            if (adaptor_.is_open())
             {
-                do_write_static();
+                queue_response();
             }
-            else
+            res.clear();
+            res.skip_body = false;
+            res.manual_length_header = false;
+            parser_.clear();
+            awaiting_response_ = false;
+
+            // When the handler answered asynchronously, pick up the requests that queued up behind this one. Posted
+            // rather than called, because response::end() is still on the stack and resets fields of res afterwards.
+            if (!dispatching_)
             {
-                do_write_general();
+                auto self = this->shared_from_this();
+                asio::post(adaptor_.get_io_service(), [self] {
+                    self->process_input();
+                });
             }
         }
 
     private:
-        void prepare_buffers()
+        /// Serializes res (status line, headers and body) onto the end of output_.
+        void queue_response()
         {
-            res.complete_request_handler_ = nullptr;
-            res.is_alive_helper_ = nullptr;
-
-            if (!adaptor_.is_open())
-            {
-                //CROW_LOG_DEBUG << this << " delete (socket is closed) " << is_reading << ' ' << is_writing;
-                //delete this;
-                return;
-            }
             // TODO(EDev): HTTP version in status codes should be dynamic
             // Keep in sync with common.h/status
             static std::unordered_map<int, std::string> statusCodes = {
@@ -333,9 +356,6 @@ namespace crow
 
             static const std::string seperator = ": ";
 
-            buffers_.clear();
-            buffers_.reserve(4 * (res.headers.size() + 5) + 3);
-
             if (!statusCodes.count(res.code))
             {
                 CROW_LOG_WARNING << this << " status code "
@@ -344,223 +364,225 @@ namespace crow
                 res.code = 500;
             }
 
-            auto& status = statusCodes.find(res.code)->second;
-            buffers_.emplace_back(status.data(), status.size());
+            // Static files are not read into memory: their headers are queued like any other response, and the file
+            // follows in file_chunk_size pieces once everything ahead of it is written (see queue_file_chunk()).
+            bool stream_file = false;
+            if (res.is_static_type() && res.file_info.statResult == 0 && !res.skip_body)
+            {
+                static_file_.open(res.file_info.path.c_str(), std::ios::in | std::ios::binary);
+                static_file_left_ = static_cast<size_t>(res.file_info.statbuf.st_size);
+                stream_file = static_file_.is_open();
+            }
 
+            auto& status = statusCodes.find(res.code)->second;
             if (res.code >= 400 && res.body.empty())
                 res.body = statusCodes[res.code].substr(9);
 
+            std::string head;
+            head.reserve(256);
+            head += status;
+
             for (auto& kv : res.headers)
             {
-                buffers_.emplace_back(kv.first.data(), kv.first.size());
-                buffers_.emplace_back(seperator.data(), seperator.size());
-                buffers_.emplace_back(kv.second.data(), kv.second.size());
-                buffers_.emplace_back(crlf.data(), crlf.size());
+                head += kv.first;
+                head += seperator;
+                head += kv.second;
+                head += crlf;
             }
 
             if (!res.manual_length_header && !res.headers.count("content-length"))
             {
-                content_length_ = std::to_string(res.body.size());
-                static std::string content_length_tag = "Content-Length: ";
-                buffers_.emplace_back(content_length_tag.data(), content_length_tag.size());
-                buffers_.emplace_back(content_length_.data(), content_length_.size());
-                buffers_.emplace_back(crlf.data(), crlf.size());
+                head += "Content-Length: ";
+                head += std::to_string(res.body.size());
+                head += crlf;
             }
             if (!res.headers.count("server"))
             {
-                static std::string server_tag = "Server: ";
-                buffers_.emplace_back(server_tag.data(), server_tag.size());
-                buffers_.emplace_back(server_name_.data(), server_name_.size());
-                buffers_.emplace_back(crlf.data(), crlf.size());
+                head += "Server: ";
+                head += server_name_;
+                head += crlf;
             }
             if (!res.headers.count("date"))
             {
-                static std::string date_tag = "Date: ";
-                date_str_ = get_cached_date_str();
-                buffers_.emplace_back(date_tag.data(), date_tag.size());
-                buffers_.emplace_back(date_str_.data(), date_str_.size());
-                buffers_.emplace_back(crlf.data(), crlf.size());
+                head += "Date: ";
+                head += get_cached_date_str();
+                head += crlf;
             }
             if (add_keep_alive_)
             {
-                static std::string keep_alive_tag = "Connection: Keep-Alive";
-                buffers_.emplace_back(keep_alive_tag.data(), keep_alive_tag.size());
-                buffers_.emplace_back(crlf.data(), crlf.size());
+                head += "Connection: Keep-Alive";
+                head += crlf;
             }
 
-            buffers_.emplace_back(crlf.data(), crlf.size());
-        }
-
-        void do_write_static()
-        {
-            asio::write(adaptor_.socket(), buffers_);
+            head += crlf;
 
-            if (res.file_info.statResult == 0)
+            // Small bodies share the header's buffer; large ones are moved in as a buffer of their own.
+            if (stream_file)
             {
-                std::ifstream is(res.file_info.path.c_str(), std::ios::in | std::ios::binary);
-                std::vector<asio::const_buffer> buffers{1};
-                char buf[16384];
-                is.read(buf, sizeof(buf));
-                while (is.gcount() > 0)
-                {
-                    buffers[0] = asio::buffer(buf, is.gcount());
-                    do_write_sync(buffers);
-                    is.read(buf, sizeof(buf));
-                }
+                output_.push_back(std::move(head));
+                // Nothing may be queued behind the headers until the whole file has gone out.
+                flush_requested_ = true;
             }
-            if (close_connection_)
+            else if (res.body.size() <= small_body_size)
             {
-                adaptor_.shutdown_readwrite();
-                adaptor_.close();
-                CROW_LOG_DEBUG << this << " from write (static)";
+                head += res.body;
+                output_.push_back(std::move(head));
+            }
+            else
+            {
+                output_.push_back(std::move(head));
+                output_.push_back(std::move(res.body));
+                // Don't hold a large response back waiting for more pipelined ones.
+                if (output_bytes() >= res_stream_threshold_)
+                    flush_requested_ = true;
             }
-
-            res.end();
-            res.clear();
-            buffers_.clear();
-            parser_.clear();
         }
 
-        void do_write_general()
+        /// Queues the next piece of the static file being sent; false, with the file closed, once all of it has gone.
+        bool queue_file_chunk()
         {
-            if (res.body.length() < res_stream_threshold_)
+            std::string chunk(std::min(file_chunk_size, static_file_left_), '\0');
+            static_file_.read(&chunk[0], static_cast<std::streamsize>(chunk.size()));
+            chunk.resize(static_cast<size_t>(static_file_.gcount()));
+            static_file_left_ -= chunk.size();
+            if (chunk.empty())
             {
-                res_body_copy_.swap(res.body);
-                buffers_.emplace_back(res_body_copy_.data(), res_body_copy_.size());
+                // A file that shrank since it was stat()ed leaves its Content-Length unmet; only closing ends the response.
+                if (static_file_left_ != 0)
+                    close_connection_ = true;
+                static_file_.close();
+                static_file_left_ = 0;
+                return false;
+            }
+            output_.push_back(std::move(chunk));
+            return true;
+        }
 
-                do_write();
+        size_t output_bytes() const
+        {
+            size_t total = 0;
+            for (auto& chunk : output_)
+                total += chunk.size();
+            return total;
+        }
 
-                if (need_to_start_read_after_complete_)
+        /// Answers buffered requests one at a time in arrival order, then writes everything they produced with a
+        /// single gathered write. Called whenever the connection can make progress: after a read, after a write,
+        /// and after an asynchronous response completes.
+        void process_input()
+        {
+            if (upgraded_ || !adaptor_.is_open())
+                return;
+
+            // Requests run strictly one after another (they share req_, res and ctx_), and not while a write is in
+            // flight, which lets queue_response() append to output_ freely.
+            dispatching_ = true;
+            size_t consumed = 0;
+            while (!awaiting_response_ && !writing_ && !close_connection_ && !flush_requested_ && consumed < input_.size())
+            {
+                int parsed = parser_.feed(input_.data() + consumed, static_cast<int>(input_.size() - consumed));
+                if (parsed < 0)
                 {
-                    need_to_start_read_after_complete_ = false;
-                    start_deadline();
-                    do_read();
+                    CROW_LOG_DEBUG << this << " from read(1) with description: \"" << http_errno_description(static_cast<http_errno>(parser_.http_errno)) << '\"';
+                    // Still send what earlier requests are owed, then hang up.
+                    close_connection_ = true;
+                    consumed = input_.size();
+                    break;
                 }
+                consumed += parsed;
+                if (!parser_.is_message_complete())
+                    break;
+                handle();
+                if (upgraded_)
+                    return;
             }
-            else
+            dispatching_ = false;
+            input_.erase(0, consumed);
+
+            if (!writing_ && !output_.empty())
+            {
+                do_write();
+            }
+
+            if (!writing_ && !awaiting_response_ && (close_connection_ || read_closed_))
             {
-                asio::write(adaptor_.socket(), buffers_); // Write the response start / headers
                 cancel_deadline_timer();
-                if (res.body.length() > 0)
-                {
-                    std::vector<asio::const_buffer> buffers{1};
-                    const uint8_t *data = reinterpret_cast<const uint8_t*>(res.body.data());
-                    size_t length = res.body.length();
-                    for(size_t transferred = 0; transferred < length;)
-                    {
-                        size_t to_transfer = CROW_MIN(16384UL, length-transferred);
-                        buffers[0] = asio::const_buffer(data+transferred, to_transfer);
-                        do_write_sync(buffers);
-                        transferred += to_transfer;
-                    }
-                }
-                if (close_connection_)
-                {
-                    adaptor_.shutdown_readwrite();
-                    adaptor_.close();
-                    CROW_LOG_DEBUG << this << " from write (res_stream)";
-                }
+                adaptor_.shutdown_readwrite();
+                adaptor_.close();
+                CROW_LOG_DEBUG << this << " from write(1)";
+                return;
+            }
 
-                res.end();
-                res.clear();
-                buffers_.clear();
-                parser_.clear();
+            if (!reading_ && !read_closed_ && !close_connection_ && input_.size() < max_buffered_input)
+            {
+                do_read();
+            }
+            // A write in flight is not timed out, however slowly the peer reads; its completion re-arms the deadline.
+            if (!awaiting_response_ && !writing_)
+            {
+                start_deadline();
             }
         }
 
         void do_read()
         {
+            reading_ = true;
             auto self = this->shared_from_this();
             adaptor_.socket().async_read_some(
               asio::buffer(buffer_),
               [self](const asio::error_code& ec, std::size_t bytes_transferred) {
-                  bool error_while_reading = true;
+                  self->reading_ = false;
+                  if (self->upgraded_)
+                      return;
                   if (!ec)
                   {
-                      bool ret = self->parser_.feed(self->buffer_.data(), bytes_transferred);
-                      if (ret && self->adaptor_.is_open())
-                      {
-                          error_while_reading = false;
-                      }
-                  }
-
-                  if (error_while_reading)
-                  {
-                      self->cancel_deadline_timer();
-                      self->parser_.done();
-                      self->adaptor_.shutdown_read();
-                      self->adaptor_.close();
-                      CROW_LOG_DEBUG << self << " from read(1) with description: \"" << http_errno_description(static_cast<http_errno>(self->parser_.http_errno)) << '\"';
-                  }
-                  else if (self->close_connection_)
-                  {
-                      self->cancel_deadline_timer();
-                      self->parser_.done();
-                      // adaptor will close after write
-                  }
-                  else if (!self->need_to_call_after_handlers_)
-                  {
-                      self->start_deadline();
-                      self->do_read();
+                      self->input_.append(self->buffer_.data(), bytes_transferred);
                   }
                   else
                   {
-                      // res will be completed later by user
-                      self->need_to_start_read_after_complete_ = true;
+                      // Finish answering whatever was already received, then close.
+                      self->read_closed_ = true;
+                      CROW_LOG_DEBUG << self << " from read(1) with description: \"" << ec.message() << '\"';
                   }
+                  self->process_input();
               });
         }
 
+        /// Writes every queued response with one gathered (writev) write.
         void do_write()
         {
+            cancel_deadline_timer();
+            writing_ = true;
+            flush_requested_ = false;
+            writing_output_.swap(output_);
+            buffers_.clear();
+            buffers_.reserve(writing_output_.size());
+            for (auto& chunk : writing_output_)
+                buffers_.emplace_back(chunk.data(), chunk.size());
+
             auto self = this->shared_from_this();
             asio::async_write(
               adaptor_.socket(), buffers_,
               [self](const asio::error_code& ec, std::size_t /*bytes_transferred*/) {
-                  self->res.clear();
-                  self->res_body_copy_.clear();                  
-                  if (!self->continue_requested)
-                  {
-                      self->parser_.clear();
-                  }
-                  else
+                  self->writing_ = false;
+                  self->buffers_.clear();
+                  self->writing_output_.clear();
+                  if (ec)
                   {
-                      self->continue_requested = false;
-                  }
-                  
-                  if (!ec)
-                  {
-                      if (self->close_connection_)
-                      {
-                          self->adaptor_.shutdown_write();
-                          self->adaptor_.close();
-                          CROW_LOG_DEBUG << self << " from write(1)";
-                      }
+                      CROW_LOG_DEBUG << self << " from write(2)";
+                      self->cancel_deadline_timer();
+                      self->adaptor_.close();
+                      return;
                   }
-                  else
+                  if (self->static_file_.is_open() && self->queue_file_chunk())
                   {
-                      CROW_LOG_DEBUG << self << " from write(2)";
+                      self->do_write();
+                      return;
                   }
+                  self->process_input();
               });
         }
 
-        inline void do_write_sync(std::vector<asio::const_buffer>& buffers)
-        {
-
-            asio::write(adaptor_.socket(), buffers, [&](asio::error_code ec, std::size_t) {
-                if (!ec)
-                {
-                    return false;
-                }
-                else
-                {
-                    CROW_LOG_ERROR << ec << " - happened while sending buffers";
-                    CROW_LOG_DEBUG << this << " from write (sync)(2)";
-                    return true;
-                }
-            });
-        }
-
         void cancel_deadline_timer()
         {
             CROW_LOG_DEBUG << this << " timer cancelled: " << &task_timer_ << ' ' << task_id_;
@@ -584,10 +606,18 @@ namespace crow
         }
 
     private:
+        /// Bodies up to this size are copied behind their headers instead of getting a buffer of their own.
+        static constexpr size_t small_body_size = 4096;
+        /// Received but unanswered bytes beyond which no more is read until requests are answered.
+        static constexpr size_t max_buffered_input = 65536;
+        /// Static files are written this much at a time.
+        static constexpr size_t file_chunk_size = 16384;
+
         Adaptor adaptor_;
         Handler* handler_;
 
         std::array<char, 4096> buffer_;
+        std::string input_; ///< Received bytes not yet parsed: the rest of the current request and any pipelined ones.
 
         HTTPParser<Connection> parser_;
         std::unique_ptr<routing_handle_result> routing_handle_result_;
@@ -597,18 +627,23 @@ namespace crow
         bool close_connection_ = false;
 
         const std::string& server_name_;
+        std::vector<std::string> output_;         ///< Serialized responses waiting for the next write, in order.
+        std::vector<std::string> writing_output_; ///< The responses the write in flight is sending.
         std::vector<asio::const_buffer> buffers_;
-
-        std::string content_length_;
-        std::string date_str_;
-        std::string res_body_copy_;
+        std::ifstream static_file_; ///< The static file being written out, while it is.
+        size_t static_file_left_{}; ///< Bytes of static_file_ still owed, per the size its Content-Length gave.
 
         detail::task_timer::identifier_type task_id_{};
 
-        bool continue_requested{};
         bool need_to_call_after_handlers_{};
-        bool need_to_start_read_after_complete_{};
         bool add_keep_alive_{};
+        bool awaiting_response_{}; ///< A request has been dispatched and its response is not complete yet.
+        bool dispatching_{};       ///< process_input() is running handlers.
+        bool reading_{};
+        bool writing_{};
+        bool read_closed_{};
+        bool upgraded_{};
+        bool flush_requested_{};
 
         std::tuple<Middlewares...>* middlewares_;
         detail::context<Middlewares...> ctx_;
@@ -619,6 +654,7 @@ namespace crow
         size_t res_stream_threshold_;
 
         std::atomic<unsigned int>& queue_length_;
+        bool counted_open_ = false;
     };
 
 } // namespace crow
@@ -130,6 +130,7 @@ enum http_connection_flags // This is basically 7 booleans placed into 1 integer
   CROW_XX(STRICT, "strict mode assertion failed")                                       \
   CROW_XX(UNKNOWN, "an unknown error occurred")                                         \
   CROW_XX(INVALID_TRANSFER_ENCODING, "request has invalid transfer-encoding")           \
+  CROW_XX(PAUSED, "parser is paused")                                                   \
 
 
 /* Define CHPE_* values for each errno value above */
@@ -41,6 +41,7 @@ namespace crow
         void* middleware_context{};
         void* middleware_container{};
         asio::io_service* io_service{};
+        const std::string* route{}; ///< The rule that matched, e.g. `/get_board_by_id/<int>`; null until routed.
 
         /// Construct an empty request. (sets the method to `GET`)
         request():
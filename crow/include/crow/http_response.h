@@ -20,6 +20,7 @@
 #include "crow/logging.h"
 #include "crow/mime_types.h"
 #include "crow/returnable.h"
+#include "crow/compression.h"
 
 
 namespace crow
@@ -43,6 +44,7 @@ namespace crow
 
 #ifdef CROW_ENABLE_COMPRESSION
         bool compressed = true; ///< If compression is enabled and this is false, the individual response will not be compressed.
+        int compression_level = compression::INHERIT_LEVEL; ///< zlib level for this response; INHERIT_LEVEL uses the route's or App's.
 #endif
         bool skip_body = false;            ///< Whether this is a response to a HEAD request.
         bool manual_length_header = false; ///< Whether crow should automatically add a "Content-Length" header.
@@ -170,6 +172,12 @@ namespace crow
             headers = std::move(r.headers);
             completed_ = r.completed_;
             file_info = std::move(r.file_info);
+#ifdef CROW_ENABLE_COMPRESSION
+            compressed = r.compressed;
+            // A handler's returned response usually leaves the level unset; keep the one its route applied.
+            if (r.compression_level != compression::INHERIT_LEVEL)
+                compression_level = r.compression_level;
+#endif
             return *this;
         }
 
@@ -186,6 +194,10 @@ namespace crow
             headers.clear();
             completed_ = false;
             file_info = static_file_info{};
+#ifdef CROW_ENABLE_COMPRESSION
+            compressed = true;
+            compression_level = compression::INHERIT_LEVEL;
+#endif
         }
 
         /// Return a "Temporary Redirect" response.
@@ -247,7 +259,10 @@ namespace crow
                 }
                 if (complete_request_handler_)
                 {
-                    complete_request_handler_();
+                    // The handler clears itself and may hold the last reference to the connection
+                    // that owns this response (when end() is called from a posted task), so run a copy.
+                    auto complete_request_handler = complete_request_handler_;
+                    complete_request_handler();
                     manual_length_header = false;
                     skip_body = false;
                 }
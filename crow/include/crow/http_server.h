@@ -8,6 +8,7 @@
 #ifdef CROW_ENABLE_SSL
 #include <asio/ssl.hpp>
 #endif
+#include <algorithm>
 #include <cstdint>
 #include <atomic>
 #include <future>
@@ -28,6 +29,7 @@ namespace crow
     {
     public:
         Server(Handler* handler, std::string bindaddr, uint16_t port, std::string server_name = std::string("crow/") + VERSION, std::tuple<Middlewares...>* middlewares = nullptr, uint16_t concurrency = 1, uint8_t timeout = 5, typename Adaptor::context* adaptor_ctx = nullptr):
+          task_queue_length_pool_(concurrency - 1),
           acceptor_(io_service_, tcp::endpoint(asio::ip::address::from_string(bindaddr), port)),
           signals_(io_service_),
           tick_timer_(io_service_),
@@ -37,7 +39,6 @@ namespace crow
           server_name_(server_name),
           port_(port),
           bindaddr_(bindaddr),
-          task_queue_length_pool_(concurrency_ - 1),
           middlewares_(middlewares),
           adaptor_ctx_(adaptor_ctx)
         {}
@@ -177,6 +178,16 @@ namespace crow
             io_service_.stop(); // Close main io_service
         }
 
+        /// Close the listening socket; connections already accepted are served until they close
+        void stop_accepting()
+        {
+            io_service_.post([this] {
+                shutting_down_ = true;
+                asio::error_code ec;
+                acceptor_.close(ec);
+            });
+        }
+
         /// Wait until the server has properly started
         void wait_for_start()
         {
@@ -185,6 +196,24 @@ namespace crow
                 cv_started_.wait(lock);
         }
 
+        /// Connections open on the busiest IO thread: the largest count pick_io_service_idx balances.
+        unsigned int max_task_queue_length() const
+        {
+            unsigned int longest = 0;
+            for (const auto& length : task_queue_length_pool_)
+                longest = (std::max)(longest, length.load(std::memory_order_relaxed));
+            return longest;
+        }
+
+        /// HTTP connections open across every IO thread.
+        unsigned int open_connections() const
+        {
+            unsigned int total = 0;
+            for (const auto& length : task_queue_length_pool_)
+                total += length.load(std::memory_order_relaxed);
+            return total;
+        }
+
         void signal_clear()
         {
             signals_.clear();
@@ -218,8 +247,6 @@ namespace crow
             {
                 uint16_t service_idx = pick_io_service_idx();
                 asio::io_service& is = *io_service_pool_[service_idx];
-                task_queue_length_pool_[service_idx]++;
-                CROW_LOG_DEBUG << &is << " {" << service_idx << "} queue length: " << task_queue_length_pool_[service_idx];
 
                 auto p = std::make_shared<Connection<Adaptor, Handler, Middlewares...>>(
                   is, handler_, server_name_, middlewares_,
@@ -227,7 +254,7 @@ namespace crow
 
                 acceptor_.async_accept(
                   p->socket(),
-                  [this, p, &is, service_idx](asio::error_code ec) {
+                  [this, p, &is](asio::error_code ec) {
                       if (!ec)
                       {
                           is.post(
@@ -235,11 +262,6 @@ namespace crow
                                 p->start();
                             });
                       }
-                      else
-                      {
-                          task_queue_length_pool_[service_idx]--;
-                          CROW_LOG_DEBUG << &is << " {" << service_idx << "} queue length: " << task_queue_length_pool_[service_idx];
-                      }
                       do_accept();
                   });
             }
@@ -254,6 +276,9 @@ namespace crow
         }
 
     private:
+        /// Connections open per IO thread. Declared first so that it outlives the connections the io_services
+        /// below still hold when they are destroyed, which count themselves out in their destructors.
+        std::vector<std::atomic<unsigned int>> task_queue_length_pool_;
         std::vector<std::unique_ptr<asio::io_service>> io_service_pool_;
         asio::io_service io_service_;
         std::vector<detail::task_timer*> task_timer_pool_;
@@ -273,7 +298,6 @@ namespace crow
         std::string server_name_;
         uint16_t port_;
         std::string bindaddr_;
-        std::vector<std::atomic<unsigned int>> task_queue_length_pool_;
 
         std::chrono::milliseconds tick_interval_;
         std::function<void()> tick_function_;
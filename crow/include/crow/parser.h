@@ -34,8 +34,6 @@ namespace crow
             self->req.url_params = query_string(self->req.raw_url);
             self->req.url = self->req.raw_url.substr(0, self->qs_point != 0 ? self->qs_point : std::string::npos);
 
-            self->process_url();
-
             return 0;
         }
         static int on_header_field(http_parser* self_, const char* at, size_t length)
@@ -95,8 +93,10 @@ namespace crow
         {
             HTTPParser* self = static_cast<HTTPParser*>(self_);
 
+            // Pause so that feed() returns right after this message: with pipelining, the rest of
+            // the buffer belongs to the next request and is only parsed once this one is answered.
             self->message_complete = true;
-            self->process_message();
+            self->http_errno = CHPE_PAUSED;
             return 0;
         }
         HTTPParser(Handler* handler):
@@ -105,12 +105,16 @@ namespace crow
             http_parser_init(this);
         }
 
-        // return false on error
         /// Parse a buffer into the different sections of an HTTP request.
-        bool feed(const char* buffer, int length)
+
+        ///
+        /// Parsing stops at the end of a complete message (see is_message_complete()); the bytes
+        /// after it are left for the next call, once clear() has been called.
+        /// \return the number of bytes consumed, or -1 on a parse error.
+        int feed(const char* buffer, int length)
         {
             if (message_complete)
-                return true;
+                return 0;
 
             const static http_parser_settings settings_{
               on_message_begin,
@@ -124,16 +128,27 @@ namespace crow
             };
 
             int nparsed = http_parser_execute(this, &settings_, buffer, length);
+            if (http_errno == CHPE_PAUSED)
+            {
+                http_errno = CHPE_OK;
+                return nparsed;
+            }
             if (http_errno != CHPE_OK)
             {
-                return false;
+                return -1;
             }
-            return nparsed == length;
+            return nparsed;
         }
 
         bool done()
         {
-            return feed(nullptr, 0);
+            return feed(nullptr, 0) >= 0;
+        }
+
+        /// Whether a whole request has been parsed into \ref req.
+        bool is_message_complete() const
+        {
+            return message_complete;
         }
 
         void clear()
@@ -147,21 +162,11 @@ namespace crow
             state = CROW_NEW_MESSAGE();
         }
 
-        inline void process_url()
-        {
-            handler_->handle_url();
-        }
-
         inline void process_header()
         {
             handler_->handle_header();
         }
 
-        inline void process_message()
-        {
-            handler_->handle();
-        }
-
         inline void set_connection_parameters()
         {
             req.http_ver_major = http_major;
@@ -156,6 +156,10 @@ namespace crow
 
         detail::middleware_indices mw_indices_;
 
+#ifdef CROW_ENABLE_COMPRESSION
+        int compression_level_{compression::INHERIT_LEVEL};
+#endif
+
         friend class Router;
         friend class Blueprint;
         template<typename T>
@@ -568,6 +572,15 @@ namespace crow
             static_cast<self_t*>(this)->mw_indices_.template push<App, Middlewares...>();
             return static_cast<self_t&>(*this);
         }
+
+#ifdef CROW_ENABLE_COMPRESSION
+        /// zlib level for this route's responses, overriding App::compression_level(); 0 disables compression.
+        self_t& compression_level(int level)
+        {
+            static_cast<self_t*>(this)->compression_level_ = level;
+            return static_cast<self_t&>(*this);
+        }
+#endif
     };
 
     /// A rule that can change its parameters during runtime.
@@ -1712,6 +1725,10 @@ namespace crow
             try
             {
                 auto& rule = rules[rule_index];
+                req.route = &rule->rule_;
+#ifdef CROW_ENABLE_COMPRESSION
+                res.compression_level = rule->compression_level_;
+#endif
                 handle_rule<App>(rule, req, res, found.r_params);
             }
             catch (...)
@@ -1744,7 +1761,7 @@ namespace crow
                     return;
                 }
 
-                res.complete_request_handler_ = [&rule, &ctx, &container, &req, &res, glob_completion_handler] {
+                res.complete_request_handler_ = [rule, &ctx, &container, &req, &res, glob_completion_handler] {
                     detail::middleware_call_criteria_dynamic<true> crit_bwd(rule->mw_indices_.indices());
 
                     detail::after_handlers_call_helper<
@@ -1,8 +1,115 @@
 #include "db_handler.h"
+#include "mmap_board_store.h"
+#include "metrics.h"
+#include "utils.h"
 #include "crow/logging.h"
+#include <algorithm>
+#include <deque>
+#include <memory>
 #include <iostream>
+#include <mutex>
 #include <sstream>
 
+/**
+ * @brief Upper bound on boards held by the in-process board cache.
+ */
+static const size_t BOARD_CACHE_CAPACITY = 4096;
+
+/**
+ * @brief Largest number of ids bound into one `WHERE ID IN (...)` statement.
+ *
+ * Stays under SQLITE_MAX_VARIABLE_NUMBER on every SQLite build (999 before 3.32).
+ */
+static const size_t MAX_IDS_PER_QUERY = 500;
+
+// Set when the append-only store is selected; every entry point below delegates to it.
+static std::unique_ptr<MmapBoardStore> mmap_store;
+
+// Stored boards never change once written (save_into_db only ever inserts), so cached entries
+// cannot go stale; eviction is plain FIFO.
+static std::mutex board_cache_mutex;
+static std::unordered_map<int, std::string> board_cache;
+static std::deque<int> board_cache_order;
+
+/// Latency of one kind of storage operation, on whichever backend is selected.
+static Histogram &storage_latency(const char *op) {
+    return metrics().histogram("dominorest_db_query_duration_seconds", "Time spent in board storage, by operation.",
+                               std::string("op=\"") + op + "\"");
+}
+
+static Counter &board_cache_hits() {
+    static Counter &hits = metrics().counter("dominorest_cache_lookups_total", "Cache lookups, by cache and result.",
+                                             "cache=\"board\",result=\"hit\"");
+    return hits;
+}
+
+static Counter &board_cache_misses() {
+    static Counter &misses = metrics().counter("dominorest_cache_lookups_total", "Cache lookups, by cache and result.",
+                                               "cache=\"board\",result=\"miss\"");
+    return misses;
+}
+
+static void board_cache_put_locked(int id, const std::string &board) {
+    auto inserted = board_cache.emplace(id, board);
+    if (!inserted.second) {
+        inserted.first->second = board;
+        return;
+    }
+    board_cache_order.push_back(id);
+    if (board_cache_order.size() > BOARD_CACHE_CAPACITY) {
+        board_cache.erase(board_cache_order.front());
+        board_cache_order.pop_front();
+    }
+}
+
+static void board_cache_put(int id, const std::string &board) {
+    std::lock_guard<std::mutex> lock(board_cache_mutex);
+    board_cache_put_locked(id, board);
+}
+
+static bool board_cache_get(int id, std::string &board) {
+    std::lock_guard<std::mutex> lock(board_cache_mutex);
+    auto it = board_cache.find(id);
+    if (it == board_cache.end()) {
+        board_cache_misses().add();
+        return false;
+    }
+    board_cache_hits().add();
+    board = it->second;
+    return true;
+}
+
+void clear_board_cache() {
+    std::lock_guard<std::mutex> lock(board_cache_mutex);
+    board_cache.clear();
+    board_cache_order.clear();
+}
+
+void close_storage() {
+    if (mmap_store) {
+        if (!mmap_store->flush()) CROW_LOG_ERROR << "Board store: flush failed at shutdown.";
+        mmap_store.reset();
+    }
+    clear_board_cache();
+    sqlite3_shutdown();
+}
+
+bool use_storage_backend(StorageBackend backend, const std::string &location) {
+    if (backend == StorageBackend::Sqlite) {
+        mmap_store.reset();
+        return true;
+    }
+    std::unique_ptr<MmapBoardStore> store(new MmapBoardStore(location));
+    if (!store->is_open()) {
+        CROW_LOG_ERROR << "Failed to open board store at " << location;
+        return false;
+    }
+    CROW_LOG_INFO << "Using board store at " << location << " with " << store->size() << " boards.";
+    mmap_store = std::move(store);
+    clear_board_cache();
+    return true;
+}
+
 int callback(void *data, int argc, char **argv, char **azColName) {
     auto *result = static_cast<std::string *>(data);
     if (argc > 0 && argv[0]) {
@@ -26,35 +133,249 @@ execute_sql(sqlite3 *db, const std::string &sql, int (*callback)(void *, int, ch
     }
 }
 
-int save_into_db(int cols, int rows, const std::string &board) {
-    int last_id = -1;
-    sqlite3 *db = open_database();
+uint64_t board_hash(int cols, int rows, const std::string &board) {
+    uint64_t hash = fnv1a(static_cast<uint32_t>(rows), fnv1a(static_cast<uint32_t>(cols)));
+    return fnv1a(board.data(), board.size(), hash);
+}
 
+/**
+ * @brief Creates the BOARD table and its indexes, migrating tables that predate the HASH column.
+ *
+ * Rows written before the migration keep a NULL hash; NULLs never collide in a unique index, so
+ * they stay addressable by id and are simply not deduplicated against.
+ */
+static void ensure_board_table(sqlite3 *db) {
     const char *create_sql = "CREATE TABLE IF NOT EXISTS BOARD(" \
                                  "ID INTEGER PRIMARY KEY AUTOINCREMENT," \
                                  "COLS INT NOT NULL," \
                                  "ROWS INT NOT NULL," \
-                                 "BOARD TEXT NOT NULL);";
+                                 "BOARD TEXT NOT NULL," \
+                                 "HASH INTEGER);";
     execute_sql(db, create_sql, nullptr, nullptr);
 
-    std::ostringstream oss;
-    oss << "INSERT INTO BOARD (COLS, ROWS, BOARD) VALUES ("
-        << cols << ", " << rows << ", '" << board << "');";
-    execute_sql(db, oss.str(), nullptr, nullptr);
+    sqlite3_stmt *probe = nullptr;
+    if (sqlite3_prepare_v2(db, "SELECT HASH FROM BOARD LIMIT 0;", -1, &probe, nullptr) != SQLITE_OK) {
+        execute_sql(db, "ALTER TABLE BOARD ADD COLUMN HASH INTEGER;", nullptr, nullptr);
+    }
+    sqlite3_finalize(probe);
+
+    execute_sql(db, "CREATE UNIQUE INDEX IF NOT EXISTS BOARD_HASH ON BOARD(HASH);", nullptr, nullptr);
+    execute_sql(db, "CREATE INDEX IF NOT EXISTS BOARD_ROWS_COLS_ID ON BOARD(ROWS, COLS, ID);", nullptr, nullptr);
+}
+
+/**
+ * @brief Looks up the id of a stored board by content hash.
+ * @return The id, 0 if no row has this hash, or -1 if the stored row differs (hash collision).
+ */
+static int find_board_by_hash(sqlite3 *db, uint64_t hash, const std::string &board) {
+    sqlite3_stmt *stmt = nullptr;
+    if (sqlite3_prepare_v2(db, "SELECT ID, BOARD FROM BOARD WHERE HASH = ?;", -1, &stmt, nullptr) != SQLITE_OK) {
+        CROW_LOG_ERROR << "SQL error: " << sqlite3_errmsg(db);
+        sqlite3_finalize(stmt);
+        return 0;
+    }
+    sqlite3_bind_int64(stmt, 1, static_cast<sqlite3_int64>(hash));
+
+    int id = 0;
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        const char *stored = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 1));
+        if (stored && board == stored) {
+            id = sqlite3_column_int(stmt, 0);
+        } else {
+            CROW_LOG_ERROR << "Board hash collision on " << hash << ", refusing to alias boards.";
+            id = -1;
+        }
+    }
+    sqlite3_finalize(stmt);
+    return id;
+}
+
+int save_into_db(int cols, int rows, const std::string &board) {
+    static Histogram &latency = storage_latency("save");
+    ScopedTimer timer(latency);
+    if (mmap_store) {
+        return mmap_store->append(cols, rows, board);
+    }
+
+    int last_id = -1;
+    sqlite3 *db = open_database();
+
+    ensure_board_table(db);
+
+    uint64_t hash = board_hash(cols, rows, board);
+    sqlite3_stmt *stmt = nullptr;
+    const char *insert_sql = "INSERT OR IGNORE INTO BOARD (COLS, ROWS, BOARD, HASH) VALUES (?, ?, ?, ?);";
+    if (sqlite3_prepare_v2(db, insert_sql, -1, &stmt, nullptr) == SQLITE_OK) {
+        sqlite3_bind_int(stmt, 1, cols);
+        sqlite3_bind_int(stmt, 2, rows);
+        sqlite3_bind_text(stmt, 3, board.data(), static_cast<int>(board.size()), SQLITE_STATIC);
+        sqlite3_bind_int64(stmt, 4, static_cast<sqlite3_int64>(hash));
+        if (sqlite3_step(stmt) != SQLITE_DONE) {
+            CROW_LOG_ERROR << "SQL error: " << sqlite3_errmsg(db);
+        }
+    } else {
+        CROW_LOG_ERROR << "SQL error: " << sqlite3_errmsg(db);
+    }
+    sqlite3_finalize(stmt);
 
     last_id = static_cast<int>(sqlite3_last_insert_rowid(db));
+    if (sqlite3_changes(db) == 0) {
+        // Identical board already stored: hand back its id instead of a new row.
+        int existing_id = find_board_by_hash(db, hash, board);
+        if (existing_id != 0) {
+            last_id = existing_id;
+        }
+    }
     sqlite3_close(db);
+    if (last_id > 0) {
+        board_cache_put(last_id, board);
+    }
     return last_id;
 }
 
 std::string get_board_by_id(int id) {
+    static Histogram &latency = storage_latency("get");
+    if (mmap_store) {
+        ScopedTimer timer(latency);
+        return mmap_store->get(id);
+    }
+
+    std::string result;
+    if (board_cache_get(id, result)) {
+        return result;
+    }
+    ScopedTimer timer(latency);
+
     sqlite3 *db = open_database();
 
     std::ostringstream oss;
     oss << "SELECT BOARD FROM BOARD WHERE ID = " << id << ";";
-    std::string result;
     execute_sql(db, oss.str(), callback, &result);
 
     sqlite3_close(db);
+    if (!result.empty()) {
+        board_cache_put(id, result);
+    }
     return result;
-}
\ No newline at end of file
+}
+
+std::unordered_map<int, std::string> get_boards_by_ids(const std::vector<int> &ids) {
+    static Histogram &latency = storage_latency("get_many");
+    std::unordered_map<int, std::string> found;
+    if (mmap_store) {
+        ScopedTimer timer(latency);
+        for (int id: ids) {
+            std::string board = mmap_store->get(id);
+            if (!board.empty()) found.emplace(id, std::move(board));
+        }
+        return found;
+    }
+
+    std::vector<int> misses;
+    {
+        std::lock_guard<std::mutex> lock(board_cache_mutex);
+        for (int id: ids) {
+            if (found.count(id)) continue;
+            auto it = board_cache.find(id);
+            if (it != board_cache.end()) {
+                found.emplace(id, it->second);
+            } else {
+                misses.push_back(id);
+            }
+        }
+    }
+    board_cache_hits().add(found.size());
+    board_cache_misses().add(misses.size());
+    if (misses.empty()) {
+        return found;
+    }
+    ScopedTimer timer(latency);
+    std::sort(misses.begin(), misses.end());
+    misses.erase(std::unique(misses.begin(), misses.end()), misses.end());
+
+    sqlite3 *db = open_database();
+    std::vector<std::pair<int, std::string>> loaded;
+    for (size_t begin = 0; begin < misses.size(); begin += MAX_IDS_PER_QUERY) {
+        size_t end = std::min(misses.size(), begin + MAX_IDS_PER_QUERY);
+
+        std::string sql = "SELECT ID, BOARD FROM BOARD WHERE ID IN (?";
+        for (size_t i = begin + 1; i < end; ++i) sql += ",?";
+        sql += ");";
+
+        sqlite3_stmt *stmt = nullptr;
+        if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+            CROW_LOG_ERROR << "SQL error: " << sqlite3_errmsg(db);
+            sqlite3_finalize(stmt);
+            break;
+        }
+        for (size_t i = begin; i < end; ++i) {
+            sqlite3_bind_int(stmt, static_cast<int>(i - begin + 1), misses[i]);
+        }
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            const char *board = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 1));
+            if (board) {
+                loaded.emplace_back(sqlite3_column_int(stmt, 0), board);
+            }
+        }
+        sqlite3_finalize(stmt);
+    }
+    sqlite3_close(db);
+
+    std::lock_guard<std::mutex> lock(board_cache_mutex);
+    for (auto &entry: loaded) {
+        board_cache_put_locked(entry.first, entry.second);
+        found.emplace(entry.first, std::move(entry.second));
+    }
+    return found;
+}
+
+int list_boards(int rows, int cols, int after_id, int limit,
+                const std::function<void(int id, int rows, int cols, const char *board)> &visit) {
+    static Histogram &latency = storage_latency("list");
+    ScopedTimer timer(latency);
+    if (mmap_store) {
+        return mmap_store->list(rows, cols, after_id, limit, visit);
+    }
+
+    sqlite3 *db = open_database();
+    ensure_board_table(db);
+
+    bool filtered = rows > 0 && cols > 0;
+    const char *sql = filtered
+                      ? "SELECT ID, ROWS, COLS, BOARD FROM BOARD WHERE ROWS = ? AND COLS = ? AND ID > ? "
+                        "ORDER BY ID LIMIT ?;"
+                      : "SELECT ID, ROWS, COLS, BOARD FROM BOARD WHERE ID > ? ORDER BY ID LIMIT ?;";
+    sqlite3_stmt *stmt = nullptr;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        CROW_LOG_ERROR << "SQL error: " << sqlite3_errmsg(db);
+        sqlite3_finalize(stmt);
+        sqlite3_close(db);
+        return -1;
+    }
+
+    int param = 1;
+    if (filtered) {
+        sqlite3_bind_int(stmt, param++, rows);
+        sqlite3_bind_int(stmt, param++, cols);
+    }
+    sqlite3_bind_int(stmt, param++, after_id);
+    sqlite3_bind_int(stmt, param, limit);
+
+    int count = 0;
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        visit(sqlite3_column_int(stmt, 0),
+              sqlite3_column_int(stmt, 1),
+              sqlite3_column_int(stmt, 2),
+              reinterpret_cast<const char *>(sqlite3_column_text(stmt, 3)));
+        ++count;
+    }
+    if (rc != SQLITE_DONE) {
+        CROW_LOG_ERROR << "SQL error: " << sqlite3_errmsg(db);
+        count = -1;
+    }
+
+    sqlite3_finalize(stmt);
+    sqlite3_close(db);
+    return count;
+}
@@ -1,15 +1,91 @@
 #ifndef DOMINOREST_DB_HANDLER_H
 #define DOMINOREST_DB_HANDLER_H
 
+#include <cstdint>
+#include <functional>
 #include <string>
+#include <unordered_map>
+#include <vector>
 #include <sqlite3.h>
 
 static const char *DB_PATH = "test.db";
 
+/**
+ * @brief Where boards are persisted.
+ */
+enum class StorageBackend {
+    Sqlite, ///< The BOARD table in DB_PATH (default).
+    Mmap    ///< Append-only segment files, see mmap_board_store.h.
+};
+
+/**
+ * @brief Selects the storage backend behind save_into_db, get_board_by_id, get_boards_by_ids and list_boards.
+ *
+ * Must be called at startup, before any request is served.
+ *
+ * @param backend The backend to use.
+ * @param location For StorageBackend::Mmap, the directory holding the store; ignored for SQLite.
+ * @return false if the backend could not be opened; the previous backend stays selected.
+ */
+bool use_storage_backend(StorageBackend backend, const std::string &location = "");
+
+/**
+ * @brief Content hash of a stored board.
+ *
+ * FNV-1a over the board dimensions and its canonical JSON text (the exact bytes stored in
+ * the BOARD column). Identical boards always map to the same key, which is what the HASH
+ * column's unique index deduplicates on.
+ */
+uint64_t board_hash(int cols, int rows, const std::string &board);
+
+/**
+ * @brief Stores a board, or returns the id of the identical board already stored.
+ */
 int save_into_db(int cols, int rows, const std::string &board);
 
 std::string get_board_by_id(int id);
 
+/**
+ * @brief Fetches many boards in one pass.
+ *
+ * Ids held by the in-process board cache are answered from it; the rest are read with one
+ * `WHERE ID IN (...)` statement per chunk of ids and then cached.
+ *
+ * @param ids The ids to fetch; duplicates are allowed.
+ * @return Stored board JSON by id. Ids that do not exist are absent from the map.
+ */
+std::unordered_map<int, std::string> get_boards_by_ids(const std::vector<int> &ids);
+
+/**
+ * @brief Drops every cached board, for when the database file is replaced underneath the process.
+ */
+void clear_board_cache();
+
+/**
+ * @brief Flushes and closes the storage backend at shutdown, once no request can touch it.
+ *
+ * The board store's segments are synced to disk before it is unmapped. SQLite connections are
+ * opened and closed by each operation, so none is left open; SQLite itself is shut down last.
+ */
+void close_storage();
+
+/**
+ * @brief Visits one keyset page of stored boards in id order.
+ *
+ * Served from the (ROWS, COLS, ID) index when both dimensions are given, from the primary key
+ * otherwise. Rows are handed to @p visit straight from the SQLite cursor, so memory use is
+ * bounded by a single row regardless of table size.
+ *
+ * @param rows Row filter, or 0 for any.
+ * @param cols Column filter, or 0 for any.
+ * @param after_id Only boards with a larger id are visited.
+ * @param limit Maximum number of boards to visit.
+ * @param visit Called with id, rows, cols and the stored board JSON.
+ * @return Number of boards visited, or -1 on SQL error.
+ */
+int list_boards(int rows, int cols, int after_id, int limit,
+                const std::function<void(int id, int rows, int cols, const char *board)> &visit);
+
 sqlite3 *open_database();
 
 void
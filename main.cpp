@@ -5,6 +5,22 @@
 #include "utils.h"
 #include "db_handler.h"
 #include "auth_handler.h"
+#include "auth_middleware.h"
+#include "rate_limiter.h"
+#include "admission_control.h"
+#include "cpu_quota.h"
+#include "board_parser.h"
+#include "board_codec.h"
+#include "solve_service.h"
+#include "solve_routes.h"
+#include "solve_channel.h"
+#include "server_config.h"
+#include "shutdown.h"
+#include "metrics.h"
+#include "request_metrics.h"
+#include "async_log.h"
+#include "phase_timings.h"
+#include <algorithm>
 #include <sstream>
 #include <vector>
 #include <openssl/sha.h>
@@ -12,6 +28,12 @@
 #include <iostream>
 #include <iomanip>
 #include <chrono>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <optional>
+#include <thread>
+#include <unordered_map>
 
 /**
  * @file main.cpp
@@ -20,86 +42,203 @@
  * Sets up the Crow server and routes for solving domino puzzles.
  */
 
+/**
+ * The server application. Middleware runs in this order: RequestMetrics on every request, then
+ * rate limits, so refused callers cost no more than a cached credential lookup, then admission
+ * control shedding load once the server is saturated, then AuthMiddleware on the routes that
+ * require credentials.
+ */
+using DominoApp = crow::App<RequestMetrics, CheapRateLimit, ExpensiveRateLimit, CheapAdmission, ExpensiveAdmission,
+                            AuthMiddleware>;
+
 /**
  * @brief Sets up the web server routes.
  * @param app The Crow application instance.
  */
-void setup_routes(crow::SimpleApp &app);
+void setup_routes(DominoApp &app);
 
 /**
- * @brief Solves the domino puzzle given a board configuration.
- * @param board The 2D array representing the domino puzzle board.
- * @return A Crow response object with the solution or an error message.
+ * @brief Registers the /metrics series that are read from elsewhere at scrape time: in-flight
+ * counts, queue depths and load shedding. Counters and histograms recorded on the request path
+ * register themselves where they are recorded.
  */
-crow::response solve_domino_puzzle(const std::vector<std::vector<int> > &board);
+static void register_server_metrics(DominoApp &app, const AsyncLogHandler &log_handler) {
+    MetricsRegistry &registry = metrics();
+    registry.gauge("dominorest_http_requests_in_flight", "HTTP requests started and not yet answered.", "",
+                   [] { return static_cast<double>(requests_in_flight()); });
+    registry.gauge("dominorest_io_queue_length", "HTTP connections open on the busiest IO thread.", "",
+                   [&app] { return static_cast<double>(app.io_queue_length()); });
+    registry.gauge("dominorest_http_connections_open", "HTTP connections open on all IO threads.", "",
+                   [&app] { return static_cast<double>(app.open_connections()); });
+    for (RouteCost cost: {RouteCost::Cheap, RouteCost::Expensive}) {
+        std::string label = cost == RouteCost::Cheap ? "cost=\"cheap\"" : "cost=\"expensive\"";
+        registry.gauge("dominorest_admitted_in_flight", "Requests admission control let in and not yet released.",
+                       label, [cost] { return static_cast<double>(load_shedder().in_flight(cost)); });
+        registry.counter("dominorest_shed_requests_total", "Requests admission control refused with 503.",
+                         label, [cost] { return static_cast<double>(load_shedder().shed(cost)); });
+    }
+    registry.gauge("dominorest_pool_queue_depth", "Tasks waiting for a pool thread.", "pool=\"compute\"",
+                   [] { return static_cast<double>(compute_pool().queue_depth()); });
+    registry.gauge("dominorest_pool_queue_depth", "Tasks waiting for a pool thread.", "pool=\"hashing\"",
+                   [] { return static_cast<double>(hashing_pool().queue_depth()); });
+    registry.gauge("dominorest_pool_running", "Tasks running on a pool thread.", "pool=\"compute\"",
+                   [] { return static_cast<double>(compute_pool().running()); });
+    registry.gauge("dominorest_pool_running", "Tasks running on a pool thread.", "pool=\"hashing\"",
+                   [] { return static_cast<double>(hashing_pool().running()); });
+    registry.gauge("dominorest_solves_running", "Solves in progress, over HTTP and websocket channels.", "",
+                   [] { return static_cast<double>(running_solves().size()); });
+    registry.counter("dominorest_solves_joined_total", "Solve requests answered by an identical solve in flight.",
+                     "", [] { return static_cast<double>(solve_flights().joined()); });
+    registry.counter("dominorest_log_dropped_total", "Log lines dropped because a thread's log buffer was full.", "",
+                     [&log_handler] { return static_cast<double>(log_handler.dropped()); });
+    registry.counter("dominorest_log_suppressed_total", "Repeated log lines written only as a count.", "",
+                     [&log_handler] { return static_cast<double>(log_handler.suppressed()); });
+}
 
-int main() {
-    crow::SimpleApp app;
-    setup_routes(app);
-    app.port(18080).multithreaded().run();
-    // Destroy the mutex
+/// Requests admitted and tasks queued or running on the pools, i.e. work a shutdown waits for.
+static size_t work_in_flight() {
+    return load_shedder().in_flight(RouteCost::Cheap) + load_shedder().in_flight(RouteCost::Expensive) +
+           compute_pool().running() + compute_pool().queue_depth() +
+           hashing_pool().running() + hashing_pool().queue_depth();
 }
 
-namespace domino_solver {
-    bool convert_json_to_board(std::vector<std::vector<int> > &board, const crow::json::rvalue &x) {
-        try {
-            size_t rows = x.size();
-            board.resize(rows);
+int main(int argc, char **argv) {
+    // SIGINT and SIGTERM start a graceful shutdown on the thread waiting for them, set up below.
+    block_shutdown_signals();
+    // Log lines are written by a background thread. Constructed before the pools and the app, the
+    // handler outlives them, and its thread is started after the signals are blocked.
+    static AsyncLogHandler log_handler;
+    crow::logger::setHandler(&log_handler);
+    ServerConfig config;
+    std::string config_error;
+    if (argc > 1 && (std::strcmp(argv[1], "--help") == 0 || std::strcmp(argv[1], "-h") == 0)) {
+        std::cout << "Usage: " << argv[0] << " [options]\n" << server_config_usage();
+        return 0;
+    }
+    if (!load_server_config(argc, argv, config, config_error)) {
+        std::cerr << argv[0] << ": " << config_error << "\n" << server_config_usage();
+        return 2;
+    }
+    // The pools are created on first use, so they must be sized before any route can run.
+    configure_compute_pool(config.compute_threads, config.compute_queue);
+    configure_hashing_pool(config.hashing_threads, config.hashing_queue);
+    AdmissionLimits limits = default_admission_limits(config.compute_threads);
+    if (config.max_expensive_in_flight != 0) limits.max_expensive_in_flight = config.max_expensive_in_flight;
+    load_shedder().configure(limits);
+
+    // DOMINOREST_STORAGE=mmap switches board storage to the append-only store in DOMINOREST_STORE_DIR.
+    const char *storage = std::getenv("DOMINOREST_STORAGE");
+    if (storage != nullptr && std::string(storage) == "mmap") {
+        const char *store_dir = std::getenv("DOMINOREST_STORE_DIR");
+        if (!use_storage_backend(StorageBackend::Mmap, store_dir != nullptr ? store_dir : "boards.store")) {
+            return 1;
+        }
+    }
+
+    // DOMINOREST_TOKEN_SECRET switches to signed tokens any instance sharing the secret accepts.
+    const char *token_secret = std::getenv("DOMINOREST_TOKEN_SECRET");
+    if (token_secret != nullptr && *token_secret != '\0') {
+        const char *key_id = std::getenv("DOMINOREST_TOKEN_KEY_ID");
+        const char *previous_secret = std::getenv("DOMINOREST_TOKEN_PREVIOUS_SECRET");
+        use_signed_tokens(key_id != nullptr ? static_cast<uint32_t>(std::strtoul(key_id, nullptr, 10)) : 1,
+                          token_secret, previous_secret != nullptr ? previous_secret : "");
+    }
 
-            for (size_t i = 0; i < rows; ++i) {
-                const auto &row = x[i];
-                size_t cols = row.size();
-                board[i].resize(cols);
+    // DOMINOREST_ADMIN_KEY enables the /admin endpoints for callers sending it as Admin-Key.
+    const char *admin_key = std::getenv("DOMINOREST_ADMIN_KEY");
+    if (admin_key != nullptr) {
+        use_admin_key(admin_key);
+    }
 
-                for (size_t j = 0; j < cols; ++j) {
-                    board[i][j] = row[j].i();
-                }
-            }
-        } catch (const std::exception &e) {
-            CROW_LOG_ERROR << "Failed to convert JSON to board: " << e.what();
-            return false;
-        }
-        return true;
+    DominoApp app;
+    setup_routes(app);
+    register_server_metrics(app, log_handler);
+    // Advances the login token timer wheels, reclaiming tokens whose TOKEN_TTL has passed.
+    app.tick(std::chrono::seconds(1), expire_credentials);
+    // Shed expensive work first as connections pile up on the IO threads or solves back up in the pool.
+    load_shedder().watch([&app] { return static_cast<size_t>(app.io_queue_length()); },
+                         [] { return compute_pool().queue_depth(); });
+    // gzip for clients that accept it; routes pick their own level, bodies under 1 KiB are left alone.
+    app.use_compression(crow::compression::GZIP).compression_min_size(1024);
+    // Crow counts the acceptor among its threads, so N IO threads need a concurrency of N + 1.
+    size_t io_threads = config.io_threads != 0 ? config.io_threads
+                                               : std::max(2u, std::thread::hardware_concurrency()) - 1;
+
+    app.signal_clear();
+    DrainTimeouts timeouts;
+    timeouts.grace = std::chrono::seconds(config.drain_seconds);
+    std::thread shutdown([&app, timeouts] {
+        int signal = wait_for_shutdown_signal();
+        CROW_LOG_INFO << "Received signal " << signal << ", draining.";
+        app.wait_for_server_start();
+        drain({[&app] {
+                   app.stop_accepting();
+                   load_shedder().drain();
+               },
+               work_in_flight,
+               [] { return running_solves().cancel_all(); },
+               [&app] { return static_cast<size_t>(app.open_connections()); },
+               [&app] { app.stop(); }},
+              timeouts);
+    });
+    app.port(config.port).concurrency(static_cast<uint16_t>(io_threads + 1)).run();
+    shutdown.join();
+
+    // Storage may only be closed under nothing still using it; a forced stop leaves it to the OS.
+    if (work_in_flight() == 0) {
+        close_storage();
+    } else {
+        CROW_LOG_ERROR << "Exiting with " << work_in_flight() << " requests unfinished; storage left open.";
     }
 }
 
 /**
- * @brief Route for solving the domino puzzle.
+ * @brief Admin route reporting solver CPU usage per account over the quota window.
  *
- * This route accepts a POST request with a JSON body representing the domino puzzle board.
- * The board is a 2D array of integers. The function attempts to solve the puzzle and returns
- * the solution or an error message.
+ * Requires the Admin-Key header. Dev keys are reported by their first 8 characters only.
  */
-crow::response solve_route(const crow::request &req) {
-//    std::string token = req.get_header_value("Authorization");
-//    std::string dev_key = req.get_header_value("Dev-Key");
-//
-//    if (!authenticate(token) && !verifyDevKey(dev_key)) {
-//        CROW_LOG_ERROR << "Unauthorized: Invalid or missing token/dev-key.";
-//        return crow::response(401, "Unauthorized: Invalid or missing token/dev-key.");
-//    }
-
-    auto x = crow::json::load(req.body);
-    if (!x) {
-        CROW_LOG_ERROR << "Unable to parse JSON.";
-        return crow::response(400, "Bad Request: Unable to parse JSON.");
+crow::response cpu_usage_route(const crow::request &req) {
+    if (!verifyAdminKey(req.get_header_value("Admin-Key"))) {
+        CROW_LOG_ERROR << "Forbidden: Invalid or missing admin key.";
+        return crow::response(403, "Forbidden: Invalid or missing admin key.");
     }
 
-    std::vector<std::vector<int>> board;
-    if (!domino_solver::convert_json_to_board(board, x)) {
-        CROW_LOG_ERROR << "Failed to convert JSON to board.";
-        return crow::response(400, "Bad Request: Invalid board dimensions or row length.");
+    std::vector<crow::json::wvalue> accounts;
+    for (const CpuQuota::Usage &usage: solver_quota().usage()) {
+        crow::json::wvalue entry;
+        const std::string dev_key_prefix = "dev_key:";
+        bool is_dev_key = usage.account.compare(0, dev_key_prefix.size(), dev_key_prefix) == 0;
+        entry["account"] = is_dev_key ? usage.account.substr(0, dev_key_prefix.size() + 8) : usage.account;
+        entry["user"] = usage.username;
+        entry["cpu_seconds"] = std::chrono::duration<double>(usage.used).count();
+        entry["requests"] = usage.requests;
+        accounts.push_back(std::move(entry));
     }
 
-    return solve_domino_puzzle(board);
+    crow::json::wvalue dto;
+    dto["quota_cpu_seconds"] = std::chrono::duration<double>(solver_quota().budget()).count();
+    dto["window_seconds"] = solver_quota().window().count();
+    dto["accounts"] = std::move(accounts);
+    return crow::response{dto};
+}
+
+/**
+ * @brief Route serving every metric in the Prometheus text format (see metrics.h).
+ */
+crow::response metrics_route() {
+    crow::response res(200, metrics().render());
+    res.set_header("Content-Type", METRICS_CONTENT_TYPE);
+    return res;
 }
 
 /**
  * @brief Route for generating a domino puzzle board.
  *
- * This route accepts a GET request with 'rows' and 'cols' parameters in the URL.
+ * This route accepts a GET request with 'rows' and 'cols' parameters in the URL, neither over
+ * GENERATED_BOARD_MAX_SIDE, so that every board it hands out can be sent back to /solve.
  * The function generates a random domino puzzle board of the specified size and returns
- * it as a JSON array.
+ * it as a JSON array, or as a packed board with the id in a Board-Id header when the client
+ * accepts application/octet-stream.
  */
 crow::response generate_board_route(const crow::request &req) {
     try {
@@ -119,29 +258,49 @@ crow::response generate_board_route(const crow::request &req) {
             return crow::response(400, "Bad Request: 'rows' and 'cols' must be positive integers.");
         }
 
+        if (rows > GENERATED_BOARD_MAX_SIDE || cols > GENERATED_BOARD_MAX_SIDE) {
+            std::string message = "Bad Request: 'rows' and 'cols' must be at most " +
+                                  std::to_string(GENERATED_BOARD_MAX_SIDE) + ".";
+            CROW_LOG_ERROR << message;
+            return crow::response(400, message);
+        }
+
         if (rows * cols % 2 != 0) {
             CROW_LOG_ERROR << "Bad Request: Size of board must be even.";
             return crow::response(400, "Bad Request: Size of board must be even.");
         }
 
-        auto board = generate_board(rows, cols);
-        crow::json::wvalue dto;
-        for (size_t i = 0; i < board.size(); ++i) {
-            for (size_t j = 0; j < board[i].size(); ++j) {
-                dto["board"][i][j] = board[i][j];
-            }
+        std::vector<std::vector<int>> board;
+        {
+            PhaseTimer phase(RequestPhase::Generate);
+            board = generate_board(rows, cols);
+        }
+        FlatBoard flat;
+        std::string board_json;
+        bool packed;
+        {
+            PhaseTimer phase(RequestPhase::Render);
+            packed = accepts_packed(req) && rows <= 0xFFFF && cols <= 0xFFFF && flatten_board(board, flat);
+            // One serialization serves as both the stored payload and the response's board field.
+            board_json = board_to_json_string(board);
+        }
+        int board_id;
+        {
+            PhaseTimer phase(RequestPhase::Db);
+            board_id = save_into_db(cols, rows, board_json);
         }
-
-        std::string string_board = dto["board"].dump();
-        int board_id = save_into_db(cols, rows, string_board);
-
-        dto["id"] = board_id;
 
         if (board_id == -1) {
             CROW_LOG_ERROR << "Internal Server Error: Failed to save board.";
             return crow::response(500, "Internal Server Error: Failed to save board.");
         }
-        return crow::response{dto};
+        PhaseTimer phase(RequestPhase::Render);
+        if (packed) {
+            crow::response res = packed_response(encode_packed_board(flat));
+            res.set_header("Board-Id", std::to_string(board_id));
+            return res;
+        }
+        return crow::response("json", board_response_json(board_json, board_id));
     } catch (const std::invalid_argument &e) {
         CROW_LOG_ERROR << "Bad Request: 'rows' and 'cols' must be integers.";
         return crow::response(400, "Bad Request: 'rows' and 'cols' must be integers.");
@@ -177,13 +336,22 @@ crow::response generate_all_boards_route(const crow::request &req) {
             return crow::response(400, "Bad Request: Size of board must be even.");
         }
 
-        const std::vector<std::vector<std::vector<int>>> &allBoards = generate_all_boards(cols, rows);
-        auto board = generate_board(rows, cols);
+        std::vector<std::vector<std::vector<int>>> allBoards;
+        {
+            PhaseTimer phase(RequestPhase::Generate);
+            allBoards = generate_all_boards(cols, rows);
+        }
         crow::json::wvalue dto;
         for (size_t i = 0; i < allBoards.size(); ++i) {
-            int board_id = save_into_db(cols, rows, board_to_json_string(allBoards[i]));
-            dto["boards"][i]["id"] = board_id;
+            std::string board_json;
+            {
+                PhaseTimer phase(RequestPhase::Render);
+                board_json = board_to_json_string(allBoards[i]);
+            }
+            PhaseTimer phase(RequestPhase::Db);
+            dto["boards"][i]["id"] = save_into_db(cols, rows, board_json);
         }
+        PhaseTimer phase(RequestPhase::Render);
         return crow::response{dto};
     } catch (const std::invalid_argument &e) {
         CROW_LOG_ERROR << "Bad Request: 'rows' and 'cols' must be integers.";
@@ -197,58 +365,262 @@ crow::response generate_all_boards_route(const crow::request &req) {
     }
 }
 
-crow::response get_board_by_id_route(int board_id) {
-    std::string board_json = get_board_by_id(board_id);
+/**
+ * @brief Route returning a stored board: its JSON text, or the packed board when the client
+ * accepts application/octet-stream.
+ */
+crow::response get_board_by_id_route(const crow::request &req, int board_id) {
+    std::string board_json;
+    {
+        PhaseTimer phase(RequestPhase::Db);
+        board_json = get_board_by_id(board_id);
+    }
     if (board_json.empty()) {
         CROW_LOG_ERROR << "Not Found: Board does not exist.";
         return crow::response(404, "Not Found: Board does not exist.");
     }
+    if (accepts_packed(req)) {
+        PhaseTimer phase(RequestPhase::Render);
+        FlatBoard board;
+        BoardParseError error;
+        if (!parse_board(board_json, board, error) || board.rows > 0xFFFF || board.cols > 0xFFFF) {
+            CROW_LOG_ERROR << "Internal Server Error: Stored board " << board_id << " cannot be packed.";
+            return crow::response(500, "Internal Server Error: Stored board cannot be packed.");
+        }
+        return packed_response(encode_packed_board(board));
+    }
     return crow::response{board_json};
 }
 
-void setup_routes(crow::SimpleApp &app) {
-    CROW_ROUTE(app, "/register").methods(crow::HTTPMethod::Post)(register_route);
-    CROW_ROUTE(app, "/login").methods(crow::HTTPMethod::Post)(login_route);
-    CROW_ROUTE(app, "/solve").methods(crow::HTTPMethod::Post)(solve_route);
-    CROW_ROUTE(app, "/generate_board").methods(crow::HTTPMethod::Get)(generate_board_route);
-    CROW_ROUTE(app, "/get_board_by_id/<int>").methods(crow::HTTPMethod::Get)(get_board_by_id_route);
-    CROW_ROUTE(app, "/generate_all_boards").methods(crow::HTTPMethod::Get)(generate_all_boards_route);
-    CROW_ROUTE(app, "/create_dev_key").methods(crow::HTTPMethod::Post)(create_dev_key_route);
+/**
+ * @brief Largest page /boards will return, whatever 'limit' asks for.
+ */
+static const int MAX_BOARDS_PER_PAGE = 1000;
+
+/**
+ * @brief Reads an optional non-negative integer query parameter.
+ * @return false if the parameter is present but is not a non-negative integer.
+ */
+static bool read_int_param(const crow::request &req, const char *name, int &value) {
+    const char *raw = req.url_params.get(name);
+    if (raw == nullptr) return true;
+    try {
+        size_t consumed = 0;
+        int parsed = std::stoi(raw, &consumed);
+        if (raw[consumed] != '\0' || parsed < 0) return false;
+        value = parsed;
+        return true;
+    } catch (const std::exception &e) {
+        return false;
+    }
 }
 
-crow::response solve_domino_puzzle(const std::vector<std::vector<int> > &board) {
-    int rows = board.size();
-    int cols = board.empty() ? 0 : board[0].size();
+/**
+ * @brief Route for listing stored boards.
+ *
+ * GET /boards?rows=&cols=&after_id=&limit= returns up to 'limit' boards with an id greater than
+ * 'after_id', in id order. Pagination is keyset-based: pass the returned 'next_after_id' back as
+ * 'after_id' to fetch the next page ('next_after_id' is null on the last page). The page is written
+ * into the body row by row as the cursor advances, so cost is independent of how deep the page is.
+ */
+crow::response list_boards_route(const crow::request &req) {
+    int rows = 0, cols = 0, after_id = 0, limit = 100;
+    if (!read_int_param(req, "rows", rows) || !read_int_param(req, "cols", cols) ||
+        !read_int_param(req, "after_id", after_id) || !read_int_param(req, "limit", limit)) {
+        CROW_LOG_ERROR << "Bad Request: 'rows', 'cols', 'after_id' and 'limit' must be non-negative integers.";
+        return crow::response(400, "Bad Request: 'rows', 'cols', 'after_id' and 'limit' must be non-negative integers.");
+    }
+    if ((rows == 0) != (cols == 0)) {
+        CROW_LOG_ERROR << "Bad Request: 'rows' and 'cols' must be given together.";
+        return crow::response(400, "Bad Request: 'rows' and 'cols' must be given together.");
+    }
+    limit = std::min(std::max(limit, 1), MAX_BOARDS_PER_PAGE);
+
+    std::string body = "{\"boards\":[";
+    int last_id = after_id;
+    // Rows are appended as the cursor yields them, so the db phase includes writing the page.
+    PhaseTimer phase(RequestPhase::Db);
+    int count = list_boards(rows, cols, after_id, limit, [&](int id, int board_rows, int board_cols, const char *board) {
+        if (last_id != after_id) body += ',';
+        body += "{\"id\":";
+        body += std::to_string(id);
+        body += ",\"rows\":";
+        body += std::to_string(board_rows);
+        body += ",\"cols\":";
+        body += std::to_string(board_cols);
+        body += ",\"board\":";
+        body += board;
+        body += '}';
+        last_id = id;
+    });
+    if (count < 0) {
+        CROW_LOG_ERROR << "Internal Server Error: Failed to list boards.";
+        return crow::response(500, "Internal Server Error: Failed to list boards.");
+    }
 
-    std::vector placement(rows, std::vector<int>(cols, -1));
+    body += "],\"next_after_id\":";
+    body += count == limit ? std::to_string(last_id) : "null";
+    body += '}';
+    return crow::response("json", body);
+}
 
-    int maxPips = find_max_pips(board);
-    std::vector<Domino> dominos = generate_dominos(maxPips + 1);
+/**
+ * @brief Parses a comma-separated list of board ids such as "1,2,3".
+ * @return false if any element is not a non-negative integer.
+ */
+static bool parse_id_list(const std::string &raw, std::vector<int> &ids) {
+    size_t start = 0;
+    while (start <= raw.size()) {
+        size_t end = raw.find(',', start);
+        if (end == std::string::npos) end = raw.size();
+        std::string item = raw.substr(start, end - start);
+        try {
+            size_t consumed = 0;
+            int id = std::stoi(item, &consumed);
+            if (consumed != item.size() || id < 0) return false;
+            ids.push_back(id);
+        } catch (const std::exception &e) {
+            return false;
+        }
+        start = end + 1;
+    }
+    return true;
+}
+
+/**
+ * @brief Route for fetching many boards at once.
+ *
+ * Accepts either GET /boards?ids=1,2,3 or POST /boards with a {"ids": [1, 2, 3]} body. All ids are
+ * resolved in one pass (see get_boards_by_ids) and the stored board JSON is spliced directly into a
+ * single response body, in request order. Ids that do not exist are listed under "missing".
+ */
+crow::response get_boards_route(const crow::request &req) {
+    std::vector<int> ids;
+    if (req.method == crow::HTTPMethod::Post) {
+        auto x = crow::json::load(req.body);
+        if (!x || !x.has("ids") || x["ids"].t() != crow::json::type::List) {
+            CROW_LOG_ERROR << "Bad Request: Body must be a JSON object with an 'ids' list.";
+            return crow::response(400, "Bad Request: Body must be a JSON object with an 'ids' list.");
+        }
+        try {
+            for (const auto &id: x["ids"]) {
+                ids.push_back(static_cast<int>(id.i()));
+            }
+        } catch (const std::exception &e) {
+            CROW_LOG_ERROR << "Bad Request: 'ids' must be integers.";
+            return crow::response(400, "Bad Request: 'ids' must be integers.");
+        }
+    } else if (!parse_id_list(req.url_params.get("ids"), ids)) {
+        CROW_LOG_ERROR << "Bad Request: 'ids' must be a comma-separated list of integers.";
+        return crow::response(400, "Bad Request: 'ids' must be a comma-separated list of integers.");
+    }
 
-    std::ostringstream output;
-    output << "Domino Board:" << std::endl;
-    print_board_with_solution(board, placement, false, output);
+    if (ids.size() > static_cast<size_t>(MAX_BOARDS_PER_PAGE)) {
+        CROW_LOG_ERROR << "Bad Request: Too many ids requested.";
+        return crow::response(400, "Bad Request: At most " + std::to_string(MAX_BOARDS_PER_PAGE) + " ids per request.");
+    }
 
-    output << std::endl << "Dominos:" << std::endl;
-    print_dominos(dominos, output, maxPips + 1);
+    std::unordered_map<int, std::string> boards;
+    {
+        PhaseTimer phase(RequestPhase::Db);
+        boards = get_boards_by_ids(ids);
+    }
 
-    // time
-    auto start = std::chrono::high_resolution_clock::now();
-    bool solved = PuzzleSolver::solve_puzzle(board, placement, dominos, 0, 0);
-    // time
-    auto end = std::chrono::high_resolution_clock::now();
-    std::chrono::duration<double> elapsed = end - start;
-    output << "Time to solve: " << std::fixed << std::setprecision(8) << elapsed.count() << " seconds" << std::endl;
+    PhaseTimer phase(RequestPhase::Render);
+    std::string body = "{\"boards\":[";
+    std::string missing;
+    size_t reserved = 32;
+    for (const auto &entry: boards) reserved += entry.second.size() + 24;
+    body.reserve(reserved);
+
+    bool first = true;
+    for (int id: ids) {
+        auto it = boards.find(id);
+        if (it == boards.end()) {
+            if (!missing.empty()) missing += ',';
+            missing += std::to_string(id);
+            continue;
+        }
+        if (!first) body += ',';
+        first = false;
+        body += "{\"id\":";
+        body += std::to_string(id);
+        body += ",\"board\":";
+        body += it->second;
+        body += '}';
+    }
+    body += "],\"missing\":[";
+    body += missing;
+    body += "]}";
+    return crow::response("json", body);
+}
 
-    if (solved) {
-        output << std::endl << "Solution:" << std::endl;
-        print_board_with_solution(board, placement, true, output);
-        CROW_LOG_INFO << "Solution found for the domino puzzle.";
-        return crow::response{output.str()};
-    } else {
-        output << std::endl << "No solution exists." << std::endl;
-        CROW_LOG_INFO << "No solution exists for the domino puzzle.";
-        return crow::response{output.str()};
+/**
+ * @brief Dispatches /boards to the multi-get or the listing handler.
+ */
+crow::response boards_route(const crow::request &req) {
+    if (req.method == crow::HTTPMethod::Post || req.url_params.get("ids") != nullptr) {
+        return get_boards_route(req);
     }
+    return list_boards_route(req);
 }
 
+/**
+ * @brief Runs @p route on compute_pool(), completing @p res from there (see respond_from_pool), with
+ * its phases timed there (see timed_phases).
+ *
+ * The request is copied into the task, so nothing in it is read on the IO thread's behalf later.
+ */
+static void on_compute_pool(crow::response (*route)(const crow::request &), const crow::request &req,
+                            crow::response &res) {
+    respond_from_pool(compute_pool(), req, res, [route, req] { return timed_phases(req, [&] { return route(req); }); });
+}
+
+void setup_routes(DominoApp &app) {
+    CROW_ROUTE(app, "/register").methods(crow::HTTPMethod::Post)(register_route_async);
+    CROW_ROUTE(app, "/login").methods(crow::HTTPMethod::Post)(login_route_async);
+    // Solve responses are produced at the end of an expensive request already, so they get the cheapest level;
+    // text renderings repeat so much that it still shrinks them several times over.
+    CROW_ROUTE(app, "/solve").methods(crow::HTTPMethod::Post).compression_level(Z_BEST_SPEED)
+            .CROW_MIDDLEWARES(app, ExpensiveRateLimit, ExpensiveAdmission, AuthMiddleware)(
+                    [&app](const crow::request &req, crow::response &res) {
+                        AuthMiddleware::context auth = app.get_context<AuthMiddleware>(req);
+                        respond_from_pool_async(compute_pool(), req, res, [req, auth](const Respond &respond) {
+                            PhaseTimings timings;
+                            std::optional<crow::response> answer = solve_route(req, auth, respond);
+                            if (!answer) return; // joined an identical solve, which answers it when it lands
+                            timings.report(req.route, *answer);
+                            respond(std::move(*answer));
+                        });
+                    });
+    // Many solves over one connection, answered out of order with progress frames; see solve_channel.h.
+    CROW_WEBSOCKET_ROUTE(app, "/ws/solve").max_payload(SOLVE_CHANNEL_MAX_FRAME)
+            .onaccept(accept_solve_channel)
+            .onopen(open_solve_channel)
+            .onmessage(solve_channel_message)
+            .onclose(close_solve_channel);
+    // Priced as a lookup per caller, but admitted as expensive work: it runs on compute_pool, and a
+    // flood of it admitted as cheap would fill the backlog that ExpensiveAdmission refuses /solve on.
+    CROW_ROUTE(app, "/generate_board").methods(crow::HTTPMethod::Get)
+            .CROW_MIDDLEWARES(app, CheapRateLimit, ExpensiveAdmission)(
+                    [](const crow::request &req, crow::response &res) {
+                        on_compute_pool(generate_board_route, req, res);
+                    });
+    CROW_ROUTE(app, "/get_board_by_id/<int>").methods(crow::HTTPMethod::Get)
+            .CROW_MIDDLEWARES(app, CheapRateLimit, CheapAdmission)([](const crow::request &req, int board_id) {
+                return timed_phases(req, [&] { return get_board_by_id_route(req, board_id); });
+            });
+    CROW_ROUTE(app, "/boards").methods(crow::HTTPMethod::Get, crow::HTTPMethod::Post)
+            .CROW_MIDDLEWARES(app, CheapRateLimit, CheapAdmission)([](const crow::request &req) {
+                return timed_phases(req, [&] { return boards_route(req); });
+            });
+    CROW_ROUTE(app, "/generate_all_boards").methods(crow::HTTPMethod::Get).compression_level(Z_BEST_COMPRESSION)
+            .CROW_MIDDLEWARES(app, ExpensiveRateLimit, ExpensiveAdmission)(
+                    [](const crow::request &req, crow::response &res) {
+                        on_compute_pool(generate_all_boards_route, req, res);
+                    });
+    CROW_ROUTE(app, "/create_dev_key").methods(crow::HTTPMethod::Post)(create_dev_key_route);
+    CROW_ROUTE(app, "/logout").methods(crow::HTTPMethod::Post)(logout_route);
+    CROW_ROUTE(app, "/admin/cpu_usage").methods(crow::HTTPMethod::Get)(cpu_usage_route);
+    CROW_ROUTE(app, "/metrics").methods(crow::HTTPMethod::Get)(metrics_route);
+}
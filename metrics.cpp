@@ -0,0 +1,194 @@
+#include "metrics.h"
+
+#include <cstdio>
+
+/**
+ * @file metrics.cpp
+ * @brief Implementation of the metrics and their Prometheus rendering.
+ */
+
+size_t metric_slot() {
+    static std::atomic<size_t> next{0};
+    thread_local size_t slot = next.fetch_add(1, std::memory_order_relaxed) % METRIC_SLOTS;
+    return slot;
+}
+
+uint64_t Counter::value() const {
+    uint64_t total = 0;
+    for (const Slot &slot: slots_) total += slot.value.load(std::memory_order_relaxed);
+    return total;
+}
+
+Histogram::Histogram() : slots_(new Slot[METRIC_SLOTS]) {}
+
+uint64_t Histogram::bucket_bound(size_t index) {
+    if (index < 2) return index + 1;
+    size_t octave = index / 2;
+    return index % 2 == 0 ? 3ULL << (octave - 1) : 1ULL << (octave + 1);
+}
+
+size_t Histogram::bucket_index(uint64_t micros) {
+    if (micros <= 2) return micros == 0 ? 0 : micros - 1;
+    // (2^octave, 2^(octave + 1)] splits at 1.5 * 2^octave into buckets 2 * octave and 2 * octave + 1.
+    size_t octave = 63 - __builtin_clzll(micros - 1);
+    size_t index = 2 * octave + (micros <= 3ULL << (octave - 1) ? 0 : 1);
+    return index < FINITE_BUCKETS ? index : FINITE_BUCKETS;
+}
+
+void Histogram::record(std::chrono::nanoseconds elapsed) {
+    uint64_t nanos = elapsed.count() > 0 ? static_cast<uint64_t>(elapsed.count()) : 0;
+    Slot &slot = slots_[metric_slot()];
+    slot.counts[bucket_index((nanos + 999) / 1000)].fetch_add(1, std::memory_order_relaxed);
+    slot.sum_nanos.fetch_add(nanos, std::memory_order_relaxed);
+}
+
+Histogram::Snapshot Histogram::snapshot() const {
+    Snapshot snapshot;
+    for (size_t s = 0; s < METRIC_SLOTS; ++s) {
+        for (size_t i = 0; i < BUCKETS; ++i) {
+            uint64_t count = slots_[s].counts[i].load(std::memory_order_relaxed);
+            snapshot.counts[i] += count;
+            snapshot.count += count;
+        }
+        snapshot.sum_nanos += slots_[s].sum_nanos.load(std::memory_order_relaxed);
+    }
+    return snapshot;
+}
+
+MetricsRegistry::Series &MetricsRegistry::series(const std::string &name, const std::string &help, Type type,
+                                                 const std::string &labels) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Family *family = nullptr;
+    for (auto &existing: families_) {
+        if (existing->name == name) family = existing.get();
+    }
+    if (family == nullptr) {
+        families_.emplace_back(new Family{name, help, type, {}});
+        family = families_.back().get();
+    }
+    for (auto &existing: family->series) {
+        if (existing->labels == labels) return *existing;
+    }
+    family->series.emplace_back(new Series{labels, nullptr, nullptr, nullptr});
+    Series &created = *family->series.back();
+    if (type == Type::Counter) created.counter.reset(new Counter());
+    if (type == Type::Histogram) created.histogram.reset(new Histogram());
+    return created;
+}
+
+Counter &MetricsRegistry::counter(const std::string &name, const std::string &help, const std::string &labels) {
+    return *series(name, help, Type::Counter, labels).counter;
+}
+
+Histogram &MetricsRegistry::histogram(const std::string &name, const std::string &help, const std::string &labels) {
+    return *series(name, help, Type::Histogram, labels).histogram;
+}
+
+void MetricsRegistry::counter(const std::string &name, const std::string &help, const std::string &labels,
+                              std::function<double()> read) {
+    Series &counter = series(name, help, Type::Counter, labels);
+    std::lock_guard<std::mutex> lock(mutex_);
+    counter.read = std::move(read);
+}
+
+void MetricsRegistry::gauge(const std::string &name, const std::string &help, const std::string &labels,
+                            std::function<double()> read) {
+    Series &gauge = series(name, help, Type::Gauge, labels);
+    std::lock_guard<std::mutex> lock(mutex_);
+    gauge.read = std::move(read);
+}
+
+/// Appends `name{labels,extra} value\n`, leaving out empty parts of the label set.
+static void append_sample(std::string &out, const std::string &name, const std::string &labels,
+                          const std::string &extra, const char *value) {
+    out += name;
+    if (!labels.empty() || !extra.empty()) {
+        out += '{';
+        out += labels;
+        if (!labels.empty() && !extra.empty()) out += ',';
+        out += extra;
+        out += '}';
+    }
+    out += ' ';
+    out += value;
+    out += '\n';
+}
+
+std::string MetricsRegistry::render() const {
+    // The `le` labels are the same for every histogram, so they are formatted once.
+    static const std::vector<std::string> bounds = [] {
+        std::vector<std::string> formatted;
+        char text[32];
+        for (size_t i = 0; i < Histogram::FINITE_BUCKETS; ++i) {
+            std::snprintf(text, sizeof(text), "le=\"%.9g\"", Histogram::bucket_bound(i) / 1e6);
+            formatted.emplace_back(text);
+        }
+        formatted.emplace_back("le=\"+Inf\"");
+        return formatted;
+    }();
+    static const char *const type_names[] = {"counter", "gauge", "histogram"};
+
+    // Families and series are never removed, so the pointers stay valid once the lock is released.
+    // Read functions run unlocked: one may register a metric of its own on first use.
+    std::vector<std::pair<const Family *, std::vector<std::pair<const Series *, std::function<double()>>>>> listed;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto &family: families_) {
+            listed.emplace_back(family.get(), std::vector<std::pair<const Series *, std::function<double()>>>());
+            for (const auto &series: family->series) listed.back().second.emplace_back(series.get(), series->read);
+        }
+    }
+
+    std::string out;
+    char value[32];
+    for (const auto &entry: listed) {
+        const Family *family = entry.first;
+        out += "# HELP " + family->name + ' ' + family->help + '\n';
+        out += "# TYPE " + family->name + ' ' + type_names[static_cast<int>(family->type)] + '\n';
+        for (const auto &listed_series: entry.second) {
+            const Series *series = listed_series.first;
+            const std::function<double()> &read = listed_series.second;
+            if (read) {
+                std::snprintf(value, sizeof(value), "%.15g", read());
+                append_sample(out, family->name, series->labels, "", value);
+            } else if (series->counter) {
+                std::snprintf(value, sizeof(value), "%llu", static_cast<unsigned long long>(series->counter->value()));
+                append_sample(out, family->name, series->labels, "", value);
+            } else if (series->histogram) {
+                Histogram::Snapshot snapshot = series->histogram->snapshot();
+                uint64_t cumulative = 0;
+                for (size_t i = 0; i < Histogram::BUCKETS; ++i) {
+                    cumulative += snapshot.counts[i];
+                    std::snprintf(value, sizeof(value), "%llu", static_cast<unsigned long long>(cumulative));
+                    append_sample(out, family->name + "_bucket", series->labels, bounds[i], value);
+                }
+                std::snprintf(value, sizeof(value), "%.9f", snapshot.sum_nanos / 1e9);
+                append_sample(out, family->name + "_sum", series->labels, "", value);
+                std::snprintf(value, sizeof(value), "%llu", static_cast<unsigned long long>(cumulative));
+                append_sample(out, family->name + "_count", series->labels, "", value);
+            }
+        }
+    }
+    return out;
+}
+
+MetricsRegistry &metrics() {
+    static MetricsRegistry registry;
+    return registry;
+}
+
+std::string label_value(const std::string &value) {
+    std::string quoted = "\"";
+    for (char c: value) {
+        if (c == '\\' || c == '"') {
+            quoted += '\\';
+            quoted += c;
+        } else if (c == '\n') {
+            quoted += "\\n";
+        } else {
+            quoted += c;
+        }
+    }
+    quoted += '"';
+    return quoted;
+}
@@ -0,0 +1,169 @@
+#ifndef DOMINOREST_METRICS_H
+#define DOMINOREST_METRICS_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * @file metrics.h
+ * @brief Counters and latency histograms cheap enough for every request, rendered for Prometheus.
+ *
+ * Every metric keeps one cache line per thread slot (see metric_slot), so threads recording at
+ * the same time never contend for a line; a scrape adds the slots up. Recording is a relaxed
+ * atomic add on a line only the calling thread normally touches.
+ */
+
+/// Thread slots per metric. Threads beyond this share slots, which stays correct, only slower.
+const size_t METRIC_SLOTS = 32;
+
+/// The calling thread's slot, assigned round-robin on first use.
+size_t metric_slot();
+
+/**
+ * @class Counter
+ * @brief A monotonically increasing count.
+ */
+class Counter {
+public:
+    void add(uint64_t n = 1) { slots_[metric_slot()].value.fetch_add(n, std::memory_order_relaxed); }
+
+    /// The sum over every slot.
+    uint64_t value() const;
+
+private:
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> value{0};
+    };
+    std::array<Slot, METRIC_SLOTS> slots_;
+};
+
+/**
+ * @class Histogram
+ * @brief A latency distribution in log-linear buckets, HDR style: two per power of two.
+ *
+ * Bucket i holds durations up to bucket_bound(i) microseconds: 1, 2, 3, 4, 6, 8, 12, 16, ...
+ * up to 2^27 µs (about 134 s), then everything longer. Each bound is within 50% of the one
+ * before it, which is all a latency percentile needs, and finding a bucket takes a couple of
+ * bit operations.
+ */
+class Histogram {
+public:
+    /// Finite buckets, plus one for everything longer.
+    static constexpr size_t FINITE_BUCKETS = 54;
+    static constexpr size_t BUCKETS = FINITE_BUCKETS + 1;
+
+    Histogram();
+
+    void record(std::chrono::nanoseconds elapsed);
+
+    /// Upper bound of bucket @p index in microseconds; @p index < FINITE_BUCKETS.
+    static uint64_t bucket_bound(size_t index);
+
+    /// The bucket a duration of @p micros microseconds falls in.
+    static size_t bucket_index(uint64_t micros);
+
+    struct Snapshot {
+        std::array<uint64_t, BUCKETS> counts{}; ///< Per bucket, not cumulative.
+        uint64_t count = 0;
+        uint64_t sum_nanos = 0;
+    };
+
+    /// The sum over every slot. Taken while others record, so count may lag sum slightly.
+    Snapshot snapshot() const;
+
+private:
+    struct alignas(64) Slot {
+        std::array<std::atomic<uint64_t>, BUCKETS> counts{};
+        std::atomic<uint64_t> sum_nanos{0};
+    };
+    std::unique_ptr<Slot[]> slots_;
+};
+
+/**
+ * @class ScopedTimer
+ * @brief Records the time from its construction to its destruction into a Histogram.
+ */
+class ScopedTimer {
+public:
+    explicit ScopedTimer(Histogram &histogram) : histogram_(histogram), start_(std::chrono::steady_clock::now()) {}
+
+    ~ScopedTimer() { histogram_.record(std::chrono::steady_clock::now() - start_); }
+
+    ScopedTimer(const ScopedTimer &) = delete;
+
+    ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+private:
+    Histogram &histogram_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+/**
+ * @class MetricsRegistry
+ * @brief Names the metrics and renders them in the Prometheus text exposition format.
+ *
+ * Metrics are registered once, typically into a function-local static, and live as long as the
+ * registry. Registering a name and label set again returns the metric already registered, so
+ * several call sites can share one series. @p labels is the inside of the braces, e.g.
+ * `op="save"`; label values must be escaped with label_value() if they are not literals.
+ */
+class MetricsRegistry {
+public:
+    Counter &counter(const std::string &name, const std::string &help, const std::string &labels = "");
+
+    /// A count kept elsewhere, such as the requests a LoadShedder refused, read at scrape time.
+    void counter(const std::string &name, const std::string &help, const std::string &labels,
+                 std::function<double()> read);
+
+    Histogram &histogram(const std::string &name, const std::string &help, const std::string &labels = "");
+
+    /// A value read at scrape time, such as a queue depth.
+    void gauge(const std::string &name, const std::string &help, const std::string &labels,
+               std::function<double()> read);
+
+    /// Every metric, families in registration order. Histograms are reported in seconds.
+    std::string render() const;
+
+private:
+    enum class Type {
+        Counter, Gauge, Histogram
+    };
+
+    struct Series {
+        std::string labels;
+        std::unique_ptr<Counter> counter;
+        std::unique_ptr<Histogram> histogram;
+        std::function<double()> read; ///< For gauges, and counters kept elsewhere.
+    };
+
+    struct Family {
+        std::string name;
+        std::string help;
+        Type type;
+        std::vector<std::unique_ptr<Series>> series;
+    };
+
+    Series &series(const std::string &name, const std::string &help, Type type, const std::string &labels);
+
+    mutable std::mutex mutex_;
+    std::vector<std::unique_ptr<Family>> families_;
+};
+
+/// The registry /metrics renders.
+MetricsRegistry &metrics();
+
+/// @p value quoted for use as a label value, with `\`, `"` and newlines escaped.
+std::string label_value(const std::string &value);
+
+/// The content type of MetricsRegistry::render's output.
+const char *const METRICS_CONTENT_TYPE = "text/plain; version=0.0.4; charset=utf-8";
+
+#endif //DOMINOREST_METRICS_H
@@ -0,0 +1,313 @@
+#include "mmap_board_store.h"
+#include "db_handler.h"
+#include "crow/logging.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * @file mmap_board_store.cpp
+ * @brief Implementation of the append-only, memory-mapped board store.
+ */
+
+/// Upper bound on stored boards; the index is mapped at this size once so it never moves.
+static const size_t MAX_INDEX_ENTRIES = size_t(1) << 26;
+/// Upper bound on segment files; segment mappings live in a fixed array for the same reason.
+static const size_t MAX_SEGMENTS = 4096;
+/// The index file is grown in steps of this many bytes.
+static const size_t INDEX_GROWTH = size_t(1) << 20;
+static const uint32_t RECORD_MAGIC = 0x42444d44; // "DMDB"
+
+struct MmapBoardStore::RecordHeader {
+    uint32_t magic;
+    uint32_t id;
+    uint32_t cols;
+    uint32_t rows;
+    uint32_t length; ///< Payload bytes, excluding the trailing NUL.
+    uint32_t size;   ///< Whole record including header and padding, a multiple of 8.
+    uint64_t hash;   ///< board_hash() of the payload; doubles as the record checksum.
+};
+
+struct MmapBoardStore::IndexEntry {
+    uint64_t offset;
+    uint32_t segment;
+    uint32_t size; ///< Zero marks an unused slot.
+};
+
+static bool write_fully(int fd, const void *data, size_t size, off_t offset) {
+    const char *bytes = static_cast<const char *>(data);
+    while (size > 0) {
+        ssize_t written = pwrite(fd, bytes, size, offset);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        bytes += written;
+        size -= static_cast<size_t>(written);
+        offset += written;
+    }
+    return true;
+}
+
+MmapBoardStore::MmapBoardStore(const std::string &dir, size_t segment_size, bool durable)
+        : dir_(dir), segment_size_(segment_size), durable_(durable),
+          segments_(new std::atomic<const char *>[MAX_SEGMENTS]) {
+    for (size_t i = 0; i < MAX_SEGMENTS; ++i) segments_[i].store(nullptr);
+
+    std::error_code ec;
+    std::filesystem::create_directories(dir_, ec);
+    if (ec) {
+        CROW_LOG_ERROR << "Board store: cannot create " << dir_ << ": " << ec.message();
+        return;
+    }
+    if (!open_index()) return;
+
+    for (uint32_t segment = 0; segment < MAX_SEGMENTS; ++segment) {
+        char name[32];
+        std::snprintf(name, sizeof(name), "/segment-%05u.dat", segment);
+        if (!std::filesystem::exists(dir_ + name)) break;
+        if (!open_segment(segment, false)) return;
+    }
+    if (segment_fds_.empty() && !open_segment(0, true)) return;
+
+    open_ = true;
+    recover();
+}
+
+MmapBoardStore::~MmapBoardStore() {
+    if (open_) flush();
+    for (size_t i = 0; i < segment_fds_.size(); ++i) {
+        munmap(const_cast<char *>(segments_[i].load()), segment_size_);
+        close(segment_fds_[i]);
+    }
+    if (index_) munmap(const_cast<char *>(index_), MAX_INDEX_ENTRIES * sizeof(IndexEntry));
+    if (index_fd_ != -1) close(index_fd_);
+}
+
+bool MmapBoardStore::is_open() const {
+    return open_;
+}
+
+bool MmapBoardStore::open_index() {
+    std::string path = dir_ + "/index.dat";
+    index_fd_ = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    struct stat st{};
+    if (index_fd_ == -1 || fstat(index_fd_, &st) != 0) {
+        CROW_LOG_ERROR << "Board store: cannot open " << path << ": " << std::strerror(errno);
+        return false;
+    }
+    index_file_size_ = static_cast<size_t>(st.st_size);
+
+    // Map the whole addressable index once. Pages past the end of the file are never read:
+    // readers stop at count_, and the file is grown before count_ moves past its end.
+    void *map = mmap(nullptr, MAX_INDEX_ENTRIES * sizeof(IndexEntry), PROT_READ, MAP_SHARED, index_fd_, 0);
+    if (map == MAP_FAILED) {
+        CROW_LOG_ERROR << "Board store: cannot map " << path << ": " << std::strerror(errno);
+        return false;
+    }
+    index_ = static_cast<const char *>(map);
+    return true;
+}
+
+bool MmapBoardStore::open_segment(uint32_t segment, bool create) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "/segment-%05u.dat", segment);
+    std::string path = dir_ + name;
+
+    int fd = ::open(path.c_str(), O_RDWR | (create ? O_CREAT : 0), 0644);
+    struct stat st{};
+    if (fd == -1 || fstat(fd, &st) != 0) {
+        CROW_LOG_ERROR << "Board store: cannot open " << path << ": " << std::strerror(errno);
+        if (fd != -1) close(fd);
+        return false;
+    }
+    if (static_cast<size_t>(st.st_size) < segment_size_ && ftruncate(fd, static_cast<off_t>(segment_size_)) != 0) {
+        CROW_LOG_ERROR << "Board store: cannot size " << path << ": " << std::strerror(errno);
+        close(fd);
+        return false;
+    }
+
+    void *map = mmap(nullptr, segment_size_, PROT_READ, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        CROW_LOG_ERROR << "Board store: cannot map " << path << ": " << std::strerror(errno);
+        close(fd);
+        return false;
+    }
+    segment_fds_.push_back(fd);
+    segments_[segment].store(static_cast<const char *>(map), std::memory_order_release);
+    return true;
+}
+
+const MmapBoardStore::IndexEntry &MmapBoardStore::entry(int id) const {
+    return reinterpret_cast<const IndexEntry *>(index_)[id - 1];
+}
+
+const MmapBoardStore::RecordHeader *MmapBoardStore::record(const IndexEntry &entry) const {
+    const char *segment = segments_[entry.segment].load(std::memory_order_acquire);
+    return reinterpret_cast<const RecordHeader *>(segment + entry.offset);
+}
+
+void MmapBoardStore::recover() {
+    size_t capacity = std::min(MAX_INDEX_ENTRIES, index_file_size_ / sizeof(IndexEntry));
+    int recovered = 0;
+    for (size_t i = 0; i < capacity; ++i) {
+        int id = static_cast<int>(i + 1);
+        const IndexEntry &e = entry(id);
+        if (e.size == 0) break;
+
+        bool valid = e.segment < segment_fds_.size() &&
+                     e.size >= sizeof(RecordHeader) &&
+                     e.offset + e.size <= segment_size_;
+        const RecordHeader *header = valid ? record(e) : nullptr;
+        valid = valid &&
+                header->magic == RECORD_MAGIC &&
+                header->id == static_cast<uint32_t>(id) &&
+                header->size == e.size &&
+                sizeof(RecordHeader) + header->length < e.size;
+        if (valid) {
+            std::string payload(reinterpret_cast<const char *>(header + 1), header->length);
+            valid = board_hash(static_cast<int>(header->cols), static_cast<int>(header->rows), payload) == header->hash;
+        }
+        if (!valid) {
+            CROW_LOG_WARNING << "Board store: discarding torn tail from id " << id;
+            break;
+        }
+
+        ids_by_hash_[header->hash] = id;
+        write_segment_ = e.segment;
+        write_offset_ = e.offset + e.size;
+        recovered = id;
+    }
+
+    // Zero out every slot past the recovered prefix so a later crash cannot resurrect it.
+    size_t tail_begin = static_cast<size_t>(recovered) * sizeof(IndexEntry);
+    if (tail_begin < index_file_size_) {
+        std::vector<char> zeros(index_file_size_ - tail_begin, 0);
+        write_fully(index_fd_, zeros.data(), zeros.size(), static_cast<off_t>(tail_begin));
+    }
+    if (recovered == 0) {
+        write_segment_ = 0;
+        write_offset_ = 0;
+    }
+    count_.store(recovered, std::memory_order_release);
+}
+
+int MmapBoardStore::append(int cols, int rows, const std::string &board) {
+    if (!open_) return -1;
+    uint64_t hash = board_hash(cols, rows, board);
+
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    auto existing = ids_by_hash_.find(hash);
+    if (existing != ids_by_hash_.end()) {
+        if (get(existing->second) == board) return existing->second;
+        CROW_LOG_ERROR << "Board hash collision on " << hash << ", refusing to alias boards.";
+        return -1;
+    }
+
+    // Header, payload and a NUL terminator, padded so the next header stays 8-byte aligned.
+    size_t size = (sizeof(RecordHeader) + board.size() + 1 + 7) & ~size_t(7);
+    if (size > segment_size_) {
+        CROW_LOG_ERROR << "Board store: board of " << board.size() << " bytes does not fit in a segment.";
+        return -1;
+    }
+    int id = count_.load(std::memory_order_relaxed) + 1;
+    if (static_cast<size_t>(id) > MAX_INDEX_ENTRIES) {
+        CROW_LOG_ERROR << "Board store: index is full.";
+        return -1;
+    }
+    if (write_offset_ + size > segment_size_) {
+        // After recovery the next segment may already exist (its records were discarded).
+        bool have_next = write_segment_ + 1 < segment_fds_.size();
+        if (!have_next && (write_segment_ + 1 >= MAX_SEGMENTS || !open_segment(write_segment_ + 1, true))) {
+            return -1;
+        }
+        ++write_segment_;
+        write_offset_ = 0;
+    }
+
+    std::vector<char> buffer(size, 0);
+    RecordHeader header{RECORD_MAGIC, static_cast<uint32_t>(id), static_cast<uint32_t>(cols),
+                        static_cast<uint32_t>(rows), static_cast<uint32_t>(board.size()),
+                        static_cast<uint32_t>(size), hash};
+    std::memcpy(buffer.data(), &header, sizeof(header));
+    std::memcpy(buffer.data() + sizeof(header), board.data(), board.size());
+
+    int segment_fd = segment_fds_[write_segment_];
+    if (!write_fully(segment_fd, buffer.data(), size, static_cast<off_t>(write_offset_))) {
+        CROW_LOG_ERROR << "Board store: record write failed: " << std::strerror(errno);
+        return -1;
+    }
+
+    size_t entry_offset = static_cast<size_t>(id - 1) * sizeof(IndexEntry);
+    if (entry_offset + sizeof(IndexEntry) > index_file_size_) {
+        size_t grown = index_file_size_ + INDEX_GROWTH;
+        if (ftruncate(index_fd_, static_cast<off_t>(grown)) != 0) {
+            CROW_LOG_ERROR << "Board store: cannot grow index: " << std::strerror(errno);
+            return -1;
+        }
+        index_file_size_ = grown;
+    }
+    if (durable_ && fdatasync(segment_fd) != 0) {
+        CROW_LOG_ERROR << "Board store: fdatasync failed: " << std::strerror(errno);
+        return -1;
+    }
+
+    // The record must be on its way to disk before the entry that points at it.
+    IndexEntry e{write_offset_, write_segment_, static_cast<uint32_t>(size)};
+    if (!write_fully(index_fd_, &e, sizeof(e), static_cast<off_t>(entry_offset))) {
+        CROW_LOG_ERROR << "Board store: index write failed: " << std::strerror(errno);
+        return -1;
+    }
+    if (durable_ && fdatasync(index_fd_) != 0) {
+        CROW_LOG_ERROR << "Board store: fdatasync failed: " << std::strerror(errno);
+        return -1;
+    }
+
+    write_offset_ += size;
+    ids_by_hash_[hash] = id;
+    count_.store(id, std::memory_order_release);
+    return id;
+}
+
+std::string MmapBoardStore::get(int id) const {
+    if (id < 1 || id > count_.load(std::memory_order_acquire)) return "";
+    const RecordHeader *header = record(entry(id));
+    return std::string(reinterpret_cast<const char *>(header + 1), header->length);
+}
+
+int MmapBoardStore::list(int rows, int cols, int after_id, int limit,
+                         const std::function<void(int id, int rows, int cols, const char *board)> &visit) const {
+    bool filtered = rows > 0 && cols > 0;
+    int count = count_.load(std::memory_order_acquire);
+    int visited = 0;
+    for (int id = std::max(after_id, 0) + 1; id <= count && visited < limit; ++id) {
+        const RecordHeader *header = record(entry(id));
+        if (filtered && (header->rows != static_cast<uint32_t>(rows) || header->cols != static_cast<uint32_t>(cols))) {
+            continue;
+        }
+        // Records keep a NUL after the payload, so the mapping can be handed out as a C string.
+        visit(id, static_cast<int>(header->rows), static_cast<int>(header->cols),
+              reinterpret_cast<const char *>(header + 1));
+        ++visited;
+    }
+    return visited;
+}
+
+int MmapBoardStore::size() const {
+    return count_.load(std::memory_order_acquire);
+}
+
+bool MmapBoardStore::flush() {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    bool ok = true;
+    for (int fd: segment_fds_) ok = fdatasync(fd) == 0 && ok;
+    if (index_fd_ != -1) ok = fdatasync(index_fd_) == 0 && ok;
+    return ok;
+}
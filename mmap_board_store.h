@@ -0,0 +1,107 @@
+#ifndef DOMINOREST_MMAP_BOARD_STORE_H
+#define DOMINOREST_MMAP_BOARD_STORE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @file mmap_board_store.h
+ * @brief Append-only, memory-mapped board storage, selectable instead of SQLite.
+ *
+ * Boards are written once and never updated, so they are appended as packed records to
+ * fixed-size segment files. A dense index file maps id to (segment, offset). Both the index and
+ * every segment are mapped into memory once, so a lookup by id is two memory reads and no
+ * system calls.
+ *
+ * Crash recovery: a record is written before its index entry, and every record carries its own
+ * id, size and content hash. On open the index is replayed from id 1 and stops at the first entry
+ * whose record does not check out; that entry and everything after it are discarded, and the
+ * write position rewinds to the end of the last good record. A crash can therefore lose the last
+ * few appends, but never exposes a torn board.
+ */
+class MmapBoardStore {
+public:
+    /// Size of each segment file. Segments are created sparse, so unused space costs nothing on disk.
+    static const size_t DEFAULT_SEGMENT_SIZE = size_t(64) << 20;
+
+    /**
+     * @brief Opens the store in @p dir, creating it if needed, and runs recovery.
+     * @param dir Directory holding index.dat and the segment files.
+     * @param segment_size Capacity of each segment; must match the size the store was created with.
+     * @param durable Whether every append is fdatasync'ed before it is acknowledged.
+     */
+    explicit MmapBoardStore(const std::string &dir, size_t segment_size = DEFAULT_SEGMENT_SIZE,
+                            bool durable = false);
+
+    ~MmapBoardStore();
+
+    MmapBoardStore(const MmapBoardStore &) = delete;
+
+    MmapBoardStore &operator=(const MmapBoardStore &) = delete;
+
+    /// @return false if the directory or its files could not be opened or mapped.
+    bool is_open() const;
+
+    /**
+     * @brief Appends a board, or returns the id of the identical board already stored.
+     * @return The board id, or -1 on error.
+     */
+    int append(int cols, int rows, const std::string &board);
+
+    /// @return The stored board JSON, or an empty string if @p id does not exist.
+    std::string get(int id) const;
+
+    /// Same contract as list_boards() in db_handler.h; filtered listings scan ids in order.
+    int list(int rows, int cols, int after_id, int limit,
+             const std::function<void(int id, int rows, int cols, const char *board)> &visit) const;
+
+    /// @return Number of boards stored; ids run from 1 to size().
+    int size() const;
+
+    /// Writes index and segments through to disk.
+    bool flush();
+
+private:
+    struct RecordHeader;
+    struct IndexEntry;
+
+    bool open_index();
+
+    bool open_segment(uint32_t segment, bool create);
+
+    void recover();
+
+    const RecordHeader *record(const IndexEntry &entry) const;
+
+    const IndexEntry &entry(int id) const;
+
+    std::string dir_;
+    size_t segment_size_;
+    bool durable_;
+    bool open_ = false;
+
+    int index_fd_ = -1;
+    size_t index_file_size_ = 0;
+    const char *index_ = nullptr;
+
+    // Readers only touch segments_ and the index mapping; both are fixed-address for the store's
+    // lifetime and published through count_, so lookups take no lock.
+    std::unique_ptr<std::atomic<const char *>[]> segments_;
+    std::vector<int> segment_fds_;
+    std::atomic<int> count_{0};
+
+    // Writer state, guarded by write_mutex_.
+    std::mutex write_mutex_;
+    uint32_t write_segment_ = 0;
+    size_t write_offset_ = 0;
+    std::unordered_map<uint64_t, int> ids_by_hash_;
+};
+
+#endif //DOMINOREST_MMAP_BOARD_STORE_H
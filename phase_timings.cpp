@@ -0,0 +1,82 @@
+#include "phase_timings.h"
+#include "metrics.h"
+
+#include <cstdio>
+#include <unordered_map>
+
+/**
+ * @file phase_timings.cpp
+ * @brief Implementation of the per-request phase timings.
+ */
+
+static thread_local PhaseTimings *current_timings = nullptr;
+
+const char *phase_name(RequestPhase phase) {
+    static const char *const names[REQUEST_PHASES] = {"parse", "preprocess", "search", "generate", "render", "db"};
+    return names[static_cast<size_t>(phase)];
+}
+
+/// @p route's histogram for @p phase (route null when unrouted), cached per thread like RequestMetrics'
+/// series; each is registered the first time the phase runs, so routes only list the phases they have.
+static Histogram &phase_histogram(const std::string *route, size_t phase) {
+    thread_local std::unordered_map<const std::string *, std::array<Histogram *, REQUEST_PHASES>> known;
+    Histogram *&histogram = known[route][phase];
+    if (histogram == nullptr) {
+        std::string labels = "route=" + label_value(route != nullptr ? *route : "unmatched") + ",phase=\"" +
+                             phase_name(static_cast<RequestPhase>(phase)) + "\"";
+        histogram = &metrics().histogram("dominorest_request_phase_seconds",
+                                         "Time requests spent in each phase, by route.", labels);
+    }
+    return *histogram;
+}
+
+PhaseTimings::PhaseTimings() : outer_(current_timings) {
+    current_timings = this;
+}
+
+PhaseTimings::~PhaseTimings() {
+    current_timings = outer_;
+}
+
+PhaseTimings *PhaseTimings::current() {
+    return current_timings;
+}
+
+void PhaseDurations::add(RequestPhase phase, std::chrono::steady_clock::duration elapsed) {
+    size_t index = static_cast<size_t>(phase);
+    elapsed_[index] += elapsed;
+    ran_[index] = true;
+}
+
+void PhaseDurations::add(const PhaseDurations &other) {
+    for (size_t i = 0; i < REQUEST_PHASES; ++i) {
+        if (other.ran_[i]) add(static_cast<RequestPhase>(i), other.elapsed_[i]);
+    }
+}
+
+std::chrono::steady_clock::duration PhaseDurations::elapsed(RequestPhase phase) const {
+    return elapsed_[static_cast<size_t>(phase)];
+}
+
+std::string PhaseDurations::server_timing() const {
+    std::string header;
+    char duration[32];
+    for (size_t i = 0; i < REQUEST_PHASES; ++i) {
+        if (!ran_[i]) continue;
+        if (!header.empty()) header += ", ";
+        header += phase_name(static_cast<RequestPhase>(i));
+        std::snprintf(duration, sizeof(duration), ";dur=%.3f",
+                      std::chrono::duration<double, std::milli>(elapsed_[i]).count());
+        header += duration;
+    }
+    return header;
+}
+
+void PhaseDurations::report(const std::string *route, crow::response &res) const {
+    std::string header = server_timing();
+    if (header.empty()) return;
+    res.set_header("Server-Timing", header);
+    for (size_t i = 0; i < REQUEST_PHASES; ++i) {
+        if (ran_[i]) phase_histogram(route, i).record(elapsed_[i]);
+    }
+}
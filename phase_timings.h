@@ -0,0 +1,123 @@
+#ifndef DOMINOREST_PHASE_TIMINGS_H
+#define DOMINOREST_PHASE_TIMINGS_H
+
+#include "crow.h"
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <string>
+
+/**
+ * @file phase_timings.h
+ * @brief Where a request's time went, reported in a Server-Timing header and on /metrics.
+ */
+
+/// The phases a request's time is split into. Time outside every phase is left unattributed.
+enum class RequestPhase {
+    Parse,      ///< Reading the board out of the request body.
+    Preprocess, ///< Building the domino set for the board.
+    Search,     ///< The solver's search, or waiting for an identical solve already running.
+    Generate,   ///< Generating random boards.
+    Render,     ///< Serializing the answer.
+    Db,         ///< Board storage, cache lookups included.
+};
+
+const size_t REQUEST_PHASES = 6;
+
+/// The phase's name in Server-Timing and in the `phase` label.
+const char *phase_name(RequestPhase phase);
+
+/**
+ * @class PhaseDurations
+ * @brief The time one request has spent in each phase so far.
+ *
+ * A plain value, so a request's phases can be carried to the thread that finishes it.
+ */
+class PhaseDurations {
+public:
+    void add(RequestPhase phase, std::chrono::steady_clock::duration elapsed);
+
+    /// Adds every phase that ran in @p other.
+    void add(const PhaseDurations &other);
+
+    /// Time spent in @p phase so far; zero if it never ran.
+    std::chrono::steady_clock::duration elapsed(RequestPhase phase) const;
+
+    /// `parse;dur=0.042, search;dur=12.5`: the phases that ran, in milliseconds.
+    std::string server_timing() const;
+
+    /// Sets the Server-Timing header on @p res and records each phase that ran under @p route
+    /// (crow::request::route; null for unrouted requests).
+    void report(const std::string *route, crow::response &res) const;
+
+private:
+    std::array<std::chrono::steady_clock::duration, REQUEST_PHASES> elapsed_{};
+    std::array<bool, REQUEST_PHASES> ran_{};
+};
+
+/**
+ * @class PhaseTimings
+ * @brief The PhaseDurations the calling thread's timers add to.
+ *
+ * Constructing one makes it the thread's current timings, which PhaseTimer adds to, until it is
+ * destroyed; timings nest, the innermost being current. Routes whose work hops threads construct
+ * theirs on the thread doing the work (see timed_phases).
+ */
+class PhaseTimings : public PhaseDurations {
+public:
+    PhaseTimings();
+
+    ~PhaseTimings();
+
+    PhaseTimings(const PhaseTimings &) = delete;
+
+    PhaseTimings &operator=(const PhaseTimings &) = delete;
+
+    /// The calling thread's current timings, or null outside any request.
+    static PhaseTimings *current();
+
+private:
+    PhaseTimings *outer_;
+};
+
+/**
+ * @class PhaseTimer
+ * @brief Adds the time from its construction to its destruction to the current PhaseTimings.
+ *
+ * Without current timings it does nothing, not even read the clock, so library code can be
+ * timed unconditionally.
+ */
+class PhaseTimer {
+public:
+    explicit PhaseTimer(RequestPhase phase) : timings_(PhaseTimings::current()), phase_(phase) {
+        if (timings_ != nullptr) start_ = std::chrono::steady_clock::now();
+    }
+
+    ~PhaseTimer() {
+        if (timings_ != nullptr) timings_->add(phase_, std::chrono::steady_clock::now() - start_);
+    }
+
+    PhaseTimer(const PhaseTimer &) = delete;
+
+    PhaseTimer &operator=(const PhaseTimer &) = delete;
+
+private:
+    PhaseTimings *timings_;
+    RequestPhase phase_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+/**
+ * @brief Runs @p route with PhaseTimings current, then reports them on the response it returns.
+ *
+ * Call it on the thread that does the work, i.e. inside the task a route hands to a pool.
+ */
+template<typename Route>
+crow::response timed_phases(const crow::request &req, Route &&route) {
+    PhaseTimings timings;
+    crow::response res = route();
+    timings.report(req.route, res);
+    return res;
+}
+
+#endif //DOMINOREST_PHASE_TIMINGS_H
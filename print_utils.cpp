@@ -1,5 +1,8 @@
 #include "print_utils.h"
+#include "utils.h"
 
+#include <charconv>
+#include <cstring>
 #include <vector>
 #include <sstream>
 
@@ -8,6 +11,70 @@
  * @brief Implementation of utility functions for printing the domino puzzle board and solutions.
  */
 
+/// Writes @p text at @p out and returns the position after it.
+static char *put(char *out, const char *text, size_t length) {
+    std::memcpy(out, text, length);
+    return out + length;
+}
+
+static char *put_int(char *out, int value) {
+    // The buffer is sized exactly beforehand, so to_chars always has room.
+    return std::to_chars(out, out + 11, value).ptr;
+}
+
+/// Writes one horizontal border or separator: "+" then, per column, a wall or a gap, then "+\n".
+static char *put_border(char *out, int cols, const std::vector<int> *upper, const std::vector<int> *lower) {
+    for (int j = 0; j < cols; ++j) {
+        bool wall = upper == nullptr || lower == nullptr || (*upper)[j] != (*lower)[j];
+        out = put(out, wall ? "+---" : "+   ", 4);
+    }
+    return put(out, "+\n", 2);
+}
+
+size_t board_render_size(const std::vector<std::vector<int> > &board) {
+    int rows = board.size();
+    int cols = rows == 0 ? 0 : board[0].size();
+    // rows + 1 borders of "+---" per column plus "+\n", and per cell "| " or "  ", the pip and " ".
+    size_t size = static_cast<size_t>(rows + 1) * (cols * 4 + 2);
+    for (const auto &row: board) {
+        size += 2; // "|\n"
+        for (int j = 0; j < cols; ++j) size += 3 + decimal_width(row[j]);
+    }
+    return size;
+}
+
+void render_board_with_solution(const std::vector<std::vector<int> > &board,
+                                const std::vector<std::vector<int> > &placement,
+                                bool showSolution,
+                                std::string &output) {
+    int rows = board.size();
+    int cols = board[0].size(); // Assuming all rows are of equal length
+
+    size_t start = output.size();
+    output.resize(start + board_render_size(board));
+    char *out = &output[start];
+
+    out = put_border(out, cols, nullptr, nullptr);
+    for (int i = 0; i < rows; ++i) {
+        for (int j = 0; j < cols; ++j) {
+            bool wall = j == 0 || (showSolution && placement[i][j] != placement[i][j - 1]);
+            out = put(out, wall ? "| " : "  ", 2);
+            out = put_int(out, board[i][j]);
+            *out++ = ' ';
+        }
+        out = put(out, "|\n", 2);
+
+        // Inter-row separator, walls only where the solution splits two cells; or the bottom border.
+        bool separator = i < rows - 1;
+        if (separator && !showSolution) {
+            for (int j = 0; j < cols; ++j) out = put(out, "+   ", 4);
+            out = put(out, "+\n", 2);
+        } else {
+            out = put_border(out, cols, separator ? &placement[i] : nullptr, separator ? &placement[i + 1] : nullptr);
+        }
+    }
+}
+
 /**
  * @brief Prints the domino board with an optional solution overlay.
  *
@@ -24,37 +91,42 @@ void print_board_with_solution(const std::vector<std::vector<int> > &board,
                                const std::vector<std::vector<int> > &placement,
                                bool showSolution,
                                std::ostringstream &output) {
-    int rows = board.size();
-    int cols = board[0].size(); // Assuming all rows are of equal length
+    std::string text;
+    render_board_with_solution(board, placement, showSolution, text);
+    output << text;
+}
 
-    // Top border
-    for (int j = 0; j < cols; ++j) output << "+---";
-    output << "+" << "\n";
+void render_dominos(const std::vector<Domino> &dominos, int rows, std::string &output) {
+    if (rows <= 0) return;
 
-    for (int i = 0; i < rows; ++i) {
-        for (int j = 0; j < cols; ++j) {
-            // Handle placement visibility for solution
-            if (showSolution) {
-                output << ((j == 0 || placement[i][j] != placement[i][j - 1]) ? "| " : "  ");
-            } else {
-                output << ((j == 0) ? "| " : "  ");
-            }
-            output << board[i][j] << " ";
-        }
-        output << "|" << "\n"; // Right border
+    // Bucket the dominos by side2 in one pass (a stable counting sort), sizing the output as we go.
+    std::vector<size_t> first(rows + 1, 0);
+    size_t size = rows; // one "\n" per row
+    for (const Domino &domino: dominos) {
+        if (domino.side2 < 0 || domino.side2 >= rows) continue;
+        ++first[domino.side2 + 1];
+        size += 4 + decimal_width(domino.side1) + decimal_width(domino.side2); // "[a|b] "
+    }
+    for (int i = 0; i < rows; ++i) first[i + 1] += first[i];
+    std::vector<const Domino *> ordered(first[rows]);
+    std::vector<size_t> next(first.begin(), first.end() - 1);
+    for (const Domino &domino: dominos) {
+        if (domino.side2 < 0 || domino.side2 >= rows) continue;
+        ordered[next[domino.side2]++] = &domino;
+    }
 
-        // Inter-row separator or bottom border
-        for (int j = 0; j < cols; ++j) {
-            output << "+";
-            if (i < rows - 1) {
-                // If not the last row
-                output << ((showSolution && placement[i][j] != placement[i + 1][j]) ? "---" : "   ");
-            } else {
-                // Last row, always draw bottom border
-                output << "---";
-            }
+    size_t start = output.size();
+    output.resize(start + size);
+    char *out = &output[start];
+    for (int i = 0; i < rows; ++i) {
+        for (size_t k = first[i]; k < first[i + 1]; ++k) {
+            *out++ = '[';
+            out = put_int(out, ordered[k]->side1);
+            *out++ = '|';
+            out = put_int(out, ordered[k]->side2);
+            out = put(out, "] ", 2);
         }
-        output << "+" << "\n";
+        *out++ = '\n';
     }
 }
 
@@ -68,13 +140,7 @@ void print_board_with_solution(const std::vector<std::vector<int> > &board,
  * @param output The output stream to write the dominos representation.
  */
 void print_dominos(const std::vector<Domino> &dominos, std::ostringstream &output, int rows) {
-    for (int i = 0; i < rows; ++i) {
-        for (const Domino &domino: dominos) {
-            if (domino.side2 == i) {
-                output << "[" << domino.side1 << "|" << domino.side2 << "] ";
-            }
-        }
-
-        output << "\n";
-    }
+    std::string text;
+    render_dominos(dominos, rows, text);
+    output << text;
 }
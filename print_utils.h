@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstddef>
+#include <string>
 #include <vector>
 #include <sstream>
 #include "domino.h"
@@ -27,3 +29,25 @@ void print_board_with_solution(const std::vector<std::vector<int>>& board,
  * @param output The output stream to write the dominos representation.
  */
 void print_dominos(const std::vector<Domino>& dominos, std::ostringstream &output, int rows);
+
+/**
+ * @brief Exact number of characters render_board_with_solution appends for @p board.
+ */
+size_t board_render_size(const std::vector<std::vector<int>>& board);
+
+/**
+ * @brief Appends the same text as print_board_with_solution to @p output.
+ *
+ * The output is sized exactly up front and written in place, so rendering makes a single
+ * allocation (none if @p output already has the capacity).
+ */
+void render_board_with_solution(const std::vector<std::vector<int>>& board,
+                                const std::vector<std::vector<int>>& placement,
+                                bool showSolution,
+                                std::string &output);
+
+/**
+ * @brief Appends the same text as print_dominos to @p output, grouping the dominos by
+ *        side2 in one pass instead of one scan per row.
+ */
+void render_dominos(const std::vector<Domino>& dominos, int rows, std::string &output);
@@ -10,6 +10,34 @@
  * @brief Implementation of PuzzleSolver class methods.
  */
 
+/// Nodes visited between clock reads while a progress callback is set; a power of two.
+static const uint64_t PROGRESS_CHECK_NODES = 4096;
+
+bool SolveContext::visit() {
+    // Only the solving thread writes nodes, so a load and a store suffice where fetch_add would lock the bus.
+    uint64_t visited = nodes.load(std::memory_order_relaxed) + 1;
+    nodes.store(visited, std::memory_order_relaxed);
+    if (cancelled.load(std::memory_order_relaxed)) return false;
+
+    if (on_progress && (visited & (PROGRESS_CHECK_NODES - 1)) == 0) {
+        auto now = std::chrono::steady_clock::now();
+        if (next_progress_ == std::chrono::steady_clock::time_point{}) {
+            next_progress_ = now + progress_interval;
+        } else if (now >= next_progress_) {
+            on_progress(*this);
+            next_progress_ = now + progress_interval;
+        }
+    }
+    return true;
+}
+
+void SolveContext::placed(int change) {
+    int current = depth.load(std::memory_order_relaxed) + change;
+    depth.store(current, std::memory_order_relaxed);
+    if (current > max_depth.load(std::memory_order_relaxed)) max_depth.store(current, std::memory_order_relaxed);
+    if (change < 0) backtracks.store(backtracks.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
 // Mutex for shared data protection
 pthread_mutex_t mutex;
 // Shared variable to stop threads when solution is found
@@ -83,38 +111,45 @@ bool PuzzleSolver::can_place(const std::vector<std::vector<int>> &board,
  * It uses backtracking to explore all possible placements until a solution is found or all options are exhausted.
  *
  * @param board The game board.
- * @param placement The array to record the placement of each domino.
+ * @param placement Receives, for each cell, the index in @p dominos of the domino covering it.
  * @param dominoes The array of all dominos available for the puzzle.
  * @param x The current x-coordinate (row) being considered.
  * @param y The current y-coordinate (column) being considered.
- * @return true if the puzzle is solved, false if no solution is found.
+ * @param context Optional progress counters and cancellation flag, checked at every node.
+ * @return true if the puzzle is solved, false if no solution is found or the context was cancelled.
  */
 bool PuzzleSolver::solve_puzzle(const std::vector<std::vector<int>> &board,
                                 std::vector<std::vector<int>> &placement,
                                 std::vector<Domino> &dominos,
-                                int x, int y) {
+                                int x, int y,
+                                SolveContext *context) {
+    if (context != nullptr && !context->visit()) return false;
+
     int rows = board.size();
     int cols = board[0].size();
 
     if (x >= rows) return true; // Reached the end of the board
 
     if (y >= cols) {
-        return solve_puzzle(board, placement, dominos, x + 1, 0); // Move to the next row
+        return solve_puzzle(board, placement, dominos, x + 1, 0, context); // Move to the next row
     }
 
     if (placement[x][y] != -1) {
-        return solve_puzzle(board, placement, dominos, x, y + 1); // Skip filled cell
+        return solve_puzzle(board, placement, dominos, x, y + 1, context); // Skip filled cell
     }
 
-    for (Domino &domino: dominos) {
+    for (size_t index = 0; index < dominos.size(); ++index) {
+        Domino &domino = dominos[index];
         if (domino.used) continue;
 
         // Try horizontal placement
         if (can_place(board, placement, domino, x, y, true)) {
             domino.used = true;
-            placement[x][y] = placement[x][y +
-                                           1] = domino.side1; // Use domino index or a unique identifier instead of side1
-            if (solve_puzzle(board, placement, dominos, x, y + 2)) return true;
+            // The domino's index identifies it, so both halves of a piece (and only they) share a value.
+            placement[x][y] = placement[x][y + 1] = static_cast<int>(index);
+            if (context != nullptr) context->placed(1);
+            if (solve_puzzle(board, placement, dominos, x, y + 2, context)) return true;
+            if (context != nullptr) context->placed(-1);
             placement[x][y] = placement[x][y + 1] = -1;
             domino.used = false;
         }
@@ -122,9 +157,10 @@ bool PuzzleSolver::solve_puzzle(const std::vector<std::vector<int>> &board,
         // Try vertical placement
         if (can_place(board, placement, domino, x, y, false)) {
             domino.used = true;
-            placement[x][y] = placement[x +
-                                        1][y] = domino.side1; // Use domino index or a unique identifier instead of side1
-            if (solve_puzzle(board, placement, dominos, x, y + 1)) return true;
+            placement[x][y] = placement[x + 1][y] = static_cast<int>(index);
+            if (context != nullptr) context->placed(1);
+            if (solve_puzzle(board, placement, dominos, x, y + 1, context)) return true;
+            if (context != nullptr) context->placed(-1);
             placement[x][y] = placement[x + 1][y] = -1;
             domino.used = false;
         }
@@ -1,6 +1,10 @@
 #pragma once
 
 #include "domino.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
 #include <vector>
 /**
  * @file puzzle_solver.h
@@ -15,6 +19,37 @@ struct ThreadData {
     int y;
 };
 
+/**
+ * @struct SolveContext
+ * @brief Progress and cancellation shared between a running solve and the threads watching it.
+ *
+ * The solving thread is the only writer of nodes and depth; any thread may read them, or set
+ * cancelled to make solve_puzzle unwind and return false at the next node it visits.
+ */
+struct SolveContext {
+    std::atomic<bool> cancelled{false};
+    std::atomic<uint64_t> nodes{0};      ///< Search nodes visited so far.
+    std::atomic<int> depth{0};           ///< Dominos currently placed.
+    std::atomic<int> max_depth{0};       ///< Most dominos placed at once so far.
+    std::atomic<uint64_t> backtracks{0}; ///< Placements taken back because nothing fit after them.
+
+    /// If set, called on the solving thread about every progress_interval while the search runs.
+    std::function<void(const SolveContext &)> on_progress;
+    std::chrono::steady_clock::duration progress_interval = std::chrono::milliseconds(250);
+
+    /**
+     * @brief Counts one node and reports progress when it is due.
+     * @return false once the solve has been cancelled.
+     */
+    bool visit();
+
+    /// Records a domino placed (+1) or taken back (-1, a backtrack).
+    void placed(int change);
+
+private:
+    std::chrono::steady_clock::time_point next_progress_{};
+};
+
 /**
  * @class PuzzleSolver
  * @brief Provides static methods for solving the domino puzzle.
@@ -40,16 +75,18 @@ public:
     /**
      * @brief Attempts to solve the domino puzzle.
      * @param board The game board.
-     * @param placement The placement of dominos on the board.
+     * @param placement Receives, for each cell, the index in @p dominoes of the domino covering it (-1 while empty).
      * @param dominoes The array of all dominos to be placed.
      * @param x The current row being considered in the solution.
      * @param y The current column being considered in the solution.
-     * @return true if a solution is found, false otherwise.
+     * @param context If non-null, receives the search's progress and can cancel it.
+     * @return true if a solution is found, false otherwise (including when cancelled).
      */
     static bool solve_puzzle(const std::vector<std::vector<int> > &board,
                              std::vector<std::vector<int> > &placement,
                              std::vector<Domino> &dominos,
-                             int x, int y);
+                             int x, int y,
+                             SolveContext *context = nullptr);
 
     static void* solve_puzzle_thread(void* arg);
 
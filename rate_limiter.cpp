@@ -0,0 +1,69 @@
+#include "rate_limiter.h"
+#include "auth_middleware.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+/**
+ * @file rate_limiter.cpp
+ * @brief Implementation of the lock-free token buckets.
+ */
+
+/// Low bits of a bucket word hold the fill level; the rest hold the refill time plus one.
+static const int LEVEL_BITS = 24;
+static const uint64_t LEVEL_MASK = (uint64_t(1) << LEVEL_BITS) - 1;
+
+/// One request's worth of milli-tokens.
+static const uint64_t TOKEN = 1000;
+
+RateLimiter::RateLimiter(double rate, double burst)
+        : slots_(new std::atomic<uint64_t>[SLOTS]), epoch_(clock::now()) {
+    for (size_t i = 0; i < SLOTS; ++i) slots_[i].store(0, std::memory_order_relaxed);
+    configure(rate, burst);
+}
+
+void RateLimiter::configure(double rate, double burst) {
+    rate_ = std::max(rate, 0.001);
+    capacity_ = std::min(static_cast<uint64_t>(std::max(burst, 1.0) * TOKEN), LEVEL_MASK);
+}
+
+bool RateLimiter::try_acquire(const std::string &key, int &retry_after, clock::time_point now) {
+    auto &slot = slots_[std::hash<std::string>{}(key) % SLOTS];
+    uint64_t now_ms = static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::milliseconds>(now - epoch_).count());
+
+    uint64_t old = slot.load(std::memory_order_relaxed);
+    while (true) {
+        uint64_t level = capacity_; // an untouched slot (0) is a full bucket
+        uint64_t stamp = now_ms;
+        if (old != 0) {
+            uint64_t last_ms = (old >> LEVEL_BITS) - 1;
+            // Another thread may have stamped a later time; never move the stamp backwards.
+            stamp = std::max(now_ms, last_ms);
+            uint64_t elapsed = now_ms > last_ms ? now_ms - last_ms : 0;
+            double refilled = static_cast<double>(old & LEVEL_MASK) + static_cast<double>(elapsed) * rate_;
+            level = std::min(capacity_, static_cast<uint64_t>(refilled));
+        }
+
+        if (level < TOKEN) {
+            double seconds = static_cast<double>(TOKEN - level) / (rate_ * 1000.0);
+            retry_after = std::max(1, static_cast<int>(std::ceil(seconds)));
+            return false;
+        }
+
+        uint64_t next = ((stamp + 1) << LEVEL_BITS) | (level - TOKEN);
+        if (slot.compare_exchange_weak(old, next, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+            return true;
+        }
+    }
+}
+
+std::string rate_limit_key(const crow::request &req) {
+    if (req.get_header_value("Authorization").empty() && req.get_header_value("Dev-Key").empty()) {
+        return req.remote_ip_address;
+    }
+    AuthMiddleware::context auth;
+    if (!authorize_request(req, auth)) return req.remote_ip_address;
+    return auth.dev_key.empty() ? "user:" + auth.username : "dev_key:" + auth.dev_key;
+}
@@ -0,0 +1,98 @@
+#ifndef DOMINOREST_RATE_LIMITER_H
+#define DOMINOREST_RATE_LIMITER_H
+
+#include "crow.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+/**
+ * @file rate_limiter.h
+ * @brief Lock-free token buckets and the Crow middleware that enforces them per caller.
+ */
+
+/**
+ * @class RateLimiter
+ * @brief Token buckets keyed by caller, each a single atomic word updated by compare-and-swap.
+ *
+ * A bucket packs its last refill time (ms, 40 bits) and its fill level (milli-tokens, 24 bits) into
+ * one uint64_t, so admitting a request is a load, some arithmetic and one CAS, with no lock. Buckets
+ * live in a fixed table indexed by the key's hash: memory stays bounded however many distinct keys
+ * callers invent, at the cost of two keys that collide sharing a budget.
+ */
+class RateLimiter {
+public:
+    using clock = std::chrono::steady_clock;
+
+    /**
+     * @param rate Tokens added per second.
+     * @param burst Bucket capacity, i.e. requests admitted back to back after a quiet period.
+     */
+    RateLimiter(double rate, double burst);
+
+    /// Changes the limits; call before the limiter is shared between threads.
+    void configure(double rate, double burst);
+
+    /**
+     * @brief Takes one token from @p key's bucket.
+     * @param retry_after On refusal, whole seconds until a token will be available (at least 1).
+     * @return true if the request is admitted.
+     */
+    bool try_acquire(const std::string &key, int &retry_after, clock::time_point now = clock::now());
+
+private:
+    static const size_t SLOTS = 1 << 15;
+
+    std::unique_ptr<std::atomic<uint64_t>[]> slots_;
+    double rate_;       ///< Milli-tokens per millisecond (equal to tokens per second).
+    uint64_t capacity_; ///< Milli-tokens.
+    clock::time_point epoch_;
+};
+
+/// Which budget a route draws from.
+enum class RouteCost {
+    Cheap,    ///< Lookups: /get_board_by_id, /boards; /generate_board's rate budget.
+    Expensive ///< Compute pool work: /solve, /generate_all_boards; /generate_board's admission.
+};
+
+/**
+ * @brief The bucket @p req draws from: the account of a credential that verifies, else the IP address.
+ *
+ * Credentials are checked (through AuthMiddleware's per-thread cache) before they choose a bucket,
+ * so a caller inventing a new Dev-Key or token for every request still shares one bucket per address.
+ * Login tokens are keyed by their user, so logging in again does not bring a fresh budget either.
+ */
+std::string rate_limit_key(const crow::request &req);
+
+/**
+ * @struct RateLimit
+ * @brief Crow middleware answering 429 with Retry-After once a caller's bucket for @p Cost is empty.
+ *
+ * Callers are identified by rate_limit_key(). It runs before the handler, so refused requests never
+ * reach JSON parsing.
+ */
+template<RouteCost Cost>
+struct RateLimit : crow::ILocalMiddleware {
+    struct context {};
+
+    RateLimiter limiter{Cost == RouteCost::Cheap ? 100.0 : 5.0, Cost == RouteCost::Cheap ? 200.0 : 10.0};
+
+    void before_handle(crow::request &req, crow::response &res, context &) {
+        int retry_after = 0;
+        if (!limiter.try_acquire(rate_limit_key(req), retry_after)) {
+            CROW_LOG_WARNING << "Too Many Requests: Rate limit exceeded.";
+            res = crow::response(429, "Too Many Requests: Rate limit exceeded.");
+            res.set_header("Retry-After", std::to_string(retry_after));
+            res.end();
+        }
+    }
+
+    void after_handle(crow::request &, crow::response &, context &) {}
+};
+
+using CheapRateLimit = RateLimit<RouteCost::Cheap>;
+using ExpensiveRateLimit = RateLimit<RouteCost::Expensive>;
+
+#endif //DOMINOREST_RATE_LIMITER_H
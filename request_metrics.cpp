@@ -0,0 +1,75 @@
+#include "request_metrics.h"
+
+#include <array>
+#include <unordered_map>
+
+/**
+ * @file request_metrics.cpp
+ * @brief Implementation of the per-route request metrics.
+ */
+
+namespace {
+    /// One route's series: responses per status class (1xx to 5xx) and latency.
+    struct RouteSeries {
+        std::array<Counter *, 5> responses;
+        Histogram *latency;
+    };
+
+    Counter &started() {
+        static Counter &counter = metrics().counter("dominorest_http_requests_started_total",
+                                                    "HTTP requests whose handling has started.");
+        return counter;
+    }
+
+    Counter &finished() {
+        static Counter &counter = metrics().counter("dominorest_http_requests_finished_total",
+                                                    "HTTP requests whose response has completed.");
+        return counter;
+    }
+
+    RouteSeries register_route(const std::string &route) {
+        static const char *const classes[] = {"1xx", "2xx", "3xx", "4xx", "5xx"};
+        std::string label = "route=" + label_value(route);
+        RouteSeries series;
+        for (size_t i = 0; i < series.responses.size(); ++i) {
+            series.responses[i] = &metrics().counter("dominorest_http_requests_total",
+                                                     "HTTP requests answered, by route and status class.",
+                                                     label + ",status=\"" + classes[i] + "\"");
+        }
+        series.latency = &metrics().histogram("dominorest_http_request_duration_seconds",
+                                              "Time from routing a request to completing its response.", label);
+        return series;
+    }
+
+    /// The series for @p route (null when unrouted), looked up in the calling thread's own map,
+    /// so the registry's lock is only taken the first time a thread sees a route.
+    const RouteSeries &route_series(const std::string *route) {
+        thread_local std::unordered_map<const std::string *, RouteSeries> known;
+        auto it = known.find(route);
+        if (it == known.end()) {
+            it = known.emplace(route, register_route(route != nullptr ? *route : "unmatched")).first;
+        }
+        return it->second;
+    }
+}
+
+void RequestMetrics::before_handle(crow::request &, crow::response &, context &ctx) {
+    started().add();
+    ctx.start = std::chrono::steady_clock::now();
+}
+
+void RequestMetrics::after_handle(crow::request &req, crow::response &res, context &ctx) {
+    const RouteSeries &series = route_series(req.route);
+    int status_class = res.code / 100;
+    if (status_class >= 1 && status_class <= 5) series.responses[status_class - 1]->add();
+    // Crow answers requests it cannot route without calling before_handle; those were never started.
+    if (ctx.start == std::chrono::steady_clock::time_point{}) return;
+    series.latency->record(std::chrono::steady_clock::now() - ctx.start);
+    finished().add();
+}
+
+size_t requests_in_flight() {
+    // Finished first: a request finishing between the two reads then shows as still in flight, never as -1.
+    uint64_t done = finished().value();
+    return static_cast<size_t>(started().value() - done);
+}
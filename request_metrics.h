@@ -0,0 +1,35 @@
+#ifndef DOMINOREST_REQUEST_METRICS_H
+#define DOMINOREST_REQUEST_METRICS_H
+
+#include "crow.h"
+#include "metrics.h"
+#include <chrono>
+
+/**
+ * @file request_metrics.h
+ * @brief Crow middleware counting and timing every HTTP request per route, for /metrics.
+ */
+
+/**
+ * @struct RequestMetrics
+ * @brief Records each response under its route and status class, and how long it took.
+ *
+ * A global middleware, listed first on the app so its clock starts before any other middleware
+ * runs. Requests are labelled with the rule that matched (`/get_board_by_id/<int>`, not the
+ * URL), so the number of series stays bounded; unrouted requests share the label `unmatched`.
+ * after_handle runs when the response completes, so work finished on a pool is included.
+ */
+struct RequestMetrics {
+    struct context {
+        std::chrono::steady_clock::time_point start;
+    };
+
+    void before_handle(crow::request &req, crow::response &res, context &ctx);
+
+    void after_handle(crow::request &req, crow::response &res, context &ctx);
+};
+
+/// Requests RequestMetrics has seen start but not finish.
+size_t requests_in_flight();
+
+#endif //DOMINOREST_REQUEST_METRICS_H
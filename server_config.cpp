@@ -0,0 +1,115 @@
+#include "server_config.h"
+
+#include <cerrno>
+#include <cstring>
+#include <limits>
+
+/**
+ * @file server_config.cpp
+ * @brief Implementation of the startup configuration.
+ */
+
+namespace {
+    /// One setting: its flag, its variable, and where and within which bounds it is stored.
+    struct Option {
+        const char *flag;
+        const char *env;
+        const char *help;
+        size_t min;
+        size_t max;
+        size_t ServerConfig::*field;
+        uint16_t ServerConfig::*port_field;
+    };
+
+    const size_t MAX_THREADS = 1024;
+
+    const Option OPTIONS[] = {
+            {"--port", "DOMINOREST_PORT", "TCP port to listen on (18080)", 1, 65535, nullptr, &ServerConfig::port},
+            {"--io-threads", "DOMINOREST_IO_THREADS", "HTTP IO threads (cores - 1)", 1, MAX_THREADS,
+             &ServerConfig::io_threads, nullptr},
+            {"--compute-threads", "DOMINOREST_COMPUTE_THREADS", "threads solving and generating boards (cores)",
+             1, MAX_THREADS, &ServerConfig::compute_threads, nullptr},
+            {"--compute-queue", "DOMINOREST_COMPUTE_QUEUE", "tasks waiting for a compute thread (256)",
+             1, std::numeric_limits<uint32_t>::max(), &ServerConfig::compute_queue, nullptr},
+            {"--hashing-threads", "DOMINOREST_HASHING_THREADS", "threads hashing passwords (cores / 4)",
+             1, MAX_THREADS, &ServerConfig::hashing_threads, nullptr},
+            {"--hashing-queue", "DOMINOREST_HASHING_QUEUE", "tasks waiting for a hashing thread (128)",
+             1, std::numeric_limits<uint32_t>::max(), &ServerConfig::hashing_queue, nullptr},
+            {"--max-expensive-in-flight", "DOMINOREST_MAX_EXPENSIVE_IN_FLIGHT",
+             "expensive requests admitted at once (2 x compute threads)",
+             1, std::numeric_limits<uint32_t>::max(), &ServerConfig::max_expensive_in_flight, nullptr},
+            {"--drain-seconds", "DOMINOREST_DRAIN_SECONDS",
+             "seconds in-flight work may run after SIGTERM before solves are cancelled (30)",
+             0, 3600, &ServerConfig::drain_seconds, nullptr},
+    };
+
+    /// Parses @p text as a decimal in [option.min, option.max] and stores it.
+    bool apply(const Option &option, const char *source, const char *text, ServerConfig &config, std::string &error) {
+        errno = 0;
+        char *end = nullptr;
+        unsigned long long value = std::strtoull(text, &end, 10);
+        if (*text == '\0' || *text == '-' || *end != '\0' || errno == ERANGE || value < option.min ||
+            value > option.max) {
+            error = std::string(source) + " must be a number from " + std::to_string(option.min) + " to " +
+                    std::to_string(option.max) + ", got '" + text + "'";
+            return false;
+        }
+        if (option.port_field != nullptr) {
+            config.*option.port_field = static_cast<uint16_t>(value);
+        } else {
+            config.*option.field = static_cast<size_t>(value);
+        }
+        return true;
+    }
+}
+
+bool load_server_config(int argc, const char *const *argv, ServerConfig &config, std::string &error,
+                        const std::function<const char *(const char *)> &env) {
+    for (const Option &option: OPTIONS) {
+        const char *value = env(option.env);
+        if (value != nullptr && !apply(option, option.env, value, config, error)) return false;
+    }
+
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        const char *equals = std::strchr(arg, '=');
+        size_t name_length = equals != nullptr ? static_cast<size_t>(equals - arg) : std::strlen(arg);
+
+        const Option *match = nullptr;
+        for (const Option &option: OPTIONS) {
+            if (std::strlen(option.flag) == name_length && std::strncmp(option.flag, arg, name_length) == 0) {
+                match = &option;
+                break;
+            }
+        }
+        if (match == nullptr) {
+            error = std::string("unknown option '") + arg + "'";
+            return false;
+        }
+
+        const char *value = equals != nullptr ? equals + 1 : nullptr;
+        if (value == nullptr) {
+            if (i + 1 >= argc) {
+                error = std::string(match->flag) + " needs a value";
+                return false;
+            }
+            value = argv[++i];
+        }
+        if (!apply(*match, match->flag, value, config, error)) return false;
+    }
+    return true;
+}
+
+std::string server_config_usage() {
+    std::string usage = "Options (each can also be set through the environment variable shown):\n";
+    for (const Option &option: OPTIONS) {
+        usage += "  ";
+        usage += option.flag;
+        usage += "=N\t";
+        usage += option.help;
+        usage += "\t[";
+        usage += option.env;
+        usage += "]\n";
+    }
+    return usage;
+}
@@ -0,0 +1,49 @@
+#ifndef DOMINOREST_SERVER_CONFIG_H
+#define DOMINOREST_SERVER_CONFIG_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <string>
+
+/**
+ * @file server_config.h
+ * @brief Startup settings for the listener and the thread pools, from flags and the environment.
+ */
+
+/**
+ * @struct ServerConfig
+ * @brief How many threads do what, and how much work may wait for them.
+ *
+ * IO threads only accept, parse and write HTTP; solving and board generation run on the compute
+ * pool and PBKDF2 on the hashing pool, so a saturated compute pool never delays a lookup. Counts
+ * of 0 mean "size to the machine" (see each pool's accessor).
+ */
+struct ServerConfig {
+    uint16_t port = 18080;
+    size_t io_threads = 0;              ///< HTTP IO threads; 0 for one fewer than the cores (at least 1).
+    size_t compute_threads = 0;         ///< compute_pool() threads; 0 for one per core.
+    size_t compute_queue = 256;         ///< Tasks waiting for compute_pool() before 503s.
+    size_t hashing_threads = 0;         ///< hashing_pool() threads; 0 for a quarter of the cores.
+    size_t hashing_queue = 128;         ///< Tasks waiting for hashing_pool() before 503s.
+    size_t max_expensive_in_flight = 0; ///< Admission limit on expensive requests; 0 for twice the compute threads.
+    size_t drain_seconds = 30;          ///< How long in-flight work may run after SIGTERM before solves are cancelled.
+};
+
+/**
+ * @brief Fills @p config from the environment, then from command line flags, which take precedence.
+ *
+ * Every setting has a flag and a variable, e.g. `--compute-threads=8` (or `--compute-threads 8`)
+ * and DOMINOREST_COMPUTE_THREADS=8; server_config_usage() lists them.
+ *
+ * @param env Looks a variable up; std::getenv unless a test substitutes its own.
+ * @return false with @p error set on an unknown flag or a value that is not a number in range.
+ */
+bool load_server_config(int argc, const char *const *argv, ServerConfig &config, std::string &error,
+                        const std::function<const char *(const char *)> &env = std::getenv);
+
+/// The flags and variables load_server_config accepts, for --help.
+std::string server_config_usage();
+
+#endif //DOMINOREST_SERVER_CONFIG_H
@@ -0,0 +1,104 @@
+#ifndef DOMINOREST_SHARDED_MAP_H
+#define DOMINOREST_SHARDED_MAP_H
+
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+/**
+ * @file sharded_map.h
+ * @brief A hash map split into independently locked shards.
+ */
+
+/**
+ * @class ShardedMap
+ * @brief Concurrent hash map: each key lives in one of @p ShardCount shards, each behind its own
+ * reader/writer lock.
+ *
+ * Readers of different shards never touch the same lock, and readers of the same shard share it,
+ * so lookups scale with cores as long as writes are comparatively rare. Every operation is atomic
+ * with respect to its key; size() is a sum over shards and only approximate under concurrent writes.
+ */
+template<typename Key, typename Value, typename Hash = std::hash<Key>, size_t ShardCount = 32>
+class ShardedMap {
+public:
+    /// @return false, leaving the map unchanged, if @p key is already present.
+    bool insert(const Key &key, Value value) {
+        Shard &shard = shard_for(key);
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        return shard.map.emplace(key, std::move(value)).second;
+    }
+
+    void assign(const Key &key, Value value) {
+        Shard &shard = shard_for(key);
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        shard.map[key] = std::move(value);
+    }
+
+    /// Copies the value for @p key into @p value. @return false if @p key is absent.
+    bool find(const Key &key, Value &value) const {
+        const Shard &shard = shard_for(key);
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        auto it = shard.map.find(key);
+        if (it == shard.map.end()) return false;
+        value = it->second;
+        return true;
+    }
+
+    bool contains(const Key &key) const {
+        const Shard &shard = shard_for(key);
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        return shard.map.count(key) != 0;
+    }
+
+    bool erase(const Key &key) {
+        Shard &shard = shard_for(key);
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        return shard.map.erase(key) != 0;
+    }
+
+    size_t size() const {
+        size_t total = 0;
+        for (const Shard &shard: shards_) {
+            std::shared_lock<std::shared_mutex> lock(shard.mutex);
+            total += shard.map.size();
+        }
+        return total;
+    }
+
+    void clear() {
+        for (Shard &shard: shards_) {
+            std::unique_lock<std::shared_mutex> lock(shard.mutex);
+            shard.map.clear();
+        }
+    }
+
+private:
+    // Padded to a cache line so neighbouring shards' locks do not false-share.
+    struct alignas(64) Shard {
+        mutable std::shared_mutex mutex;
+        std::unordered_map<Key, Value, Hash> map;
+    };
+
+    Shard &shard_for(const Key &key) {
+        return shards_[shard_index(key)];
+    }
+
+    const Shard &shard_for(const Key &key) const {
+        return shards_[shard_index(key)];
+    }
+
+    static size_t shard_index(const Key &key) {
+        // Take high bits of a multiplicative mix so the shard choice is independent of the
+        // low bits the per-shard unordered_map buckets on.
+        unsigned long long mixed = static_cast<unsigned long long>(Hash{}(key)) * 0x9E3779B97F4A7C15ULL;
+        return static_cast<size_t>(mixed >> 40) % ShardCount;
+    }
+
+    std::array<Shard, ShardCount> shards_;
+};
+
+#endif //DOMINOREST_SHARDED_MAP_H
@@ -0,0 +1,66 @@
+#include "shutdown.h"
+
+#include "crow.h"
+#include <csignal>
+#include <pthread.h>
+#include <thread>
+
+/**
+ * @file shutdown.cpp
+ * @brief Implementation of the graceful shutdown sequence.
+ */
+
+static sigset_t shutdown_signals() {
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    return signals;
+}
+
+void block_shutdown_signals() {
+    sigset_t signals = shutdown_signals();
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+}
+
+int wait_for_shutdown_signal() {
+    sigset_t signals = shutdown_signals();
+    int signal = 0;
+    while (sigwait(&signals, &signal) != 0) {
+    }
+    return signal;
+}
+
+bool wait_until(const std::function<bool()> &done, std::chrono::milliseconds timeout,
+                std::chrono::milliseconds poll) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (!done()) {
+        if (std::chrono::steady_clock::now() >= deadline) return false;
+        std::this_thread::sleep_for(poll);
+    }
+    return true;
+}
+
+bool drain(const DrainSteps &steps, const DrainTimeouts &timeouts) {
+    auto idle = [&steps] { return steps.in_flight() == 0; };
+
+    steps.stop_accepting();
+    CROW_LOG_INFO << "Shutting down: no longer accepting connections, " << steps.in_flight()
+                  << " requests in flight.";
+
+    bool finished = wait_until(idle, timeouts.grace);
+    if (!finished) {
+        size_t cancelled = steps.cancel_solves();
+        CROW_LOG_WARNING << "Shutting down: grace period over, cancelled " << cancelled << " running solves.";
+        finished = wait_until(idle, timeouts.cancelled);
+        if (!finished) {
+            CROW_LOG_ERROR << "Shutting down: " << steps.in_flight() << " requests still in flight, stopping anyway.";
+        }
+    }
+
+    if (!wait_until([&steps] { return steps.open_connections() == 0; }, timeouts.flush)) {
+        CROW_LOG_INFO << "Shutting down: closing " << steps.open_connections() << " open connections.";
+    }
+    steps.stop();
+    return finished;
+}
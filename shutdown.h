@@ -0,0 +1,66 @@
+#ifndef DOMINOREST_SHUTDOWN_H
+#define DOMINOREST_SHUTDOWN_H
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+
+/**
+ * @file shutdown.h
+ * @brief Graceful shutdown: stop taking work, let what is running finish, cancel what will not.
+ */
+
+/**
+ * @brief Blocks SIGINT and SIGTERM in the calling thread and in every thread it starts afterwards.
+ *
+ * Call it first thing in main, before any pool or server thread exists, so that the signals are
+ * only ever received by wait_for_shutdown_signal().
+ */
+void block_shutdown_signals();
+
+/// Waits for SIGINT or SIGTERM, which block_shutdown_signals() must have blocked, and returns it.
+int wait_for_shutdown_signal();
+
+/**
+ * @brief Polls @p done every @p poll until it holds or @p timeout passes.
+ * @return Whether @p done held.
+ */
+bool wait_until(const std::function<bool()> &done, std::chrono::milliseconds timeout,
+                std::chrono::milliseconds poll = std::chrono::milliseconds(20));
+
+/**
+ * @struct DrainSteps
+ * @brief What drain() does to the server, and what it watches.
+ */
+struct DrainSteps {
+    std::function<void()> stop_accepting;     ///< Close the listener and refuse new expensive work.
+    std::function<size_t()> in_flight;        ///< Requests and pool tasks not yet finished.
+    std::function<size_t()> cancel_solves;    ///< Cancel every running solve; returns how many were.
+    std::function<size_t()> open_connections; ///< Connections whose responses may still be unwritten.
+    std::function<void()> stop;               ///< Stop the IO threads.
+};
+
+/**
+ * @struct DrainTimeouts
+ * @brief How long each phase of drain() may take.
+ */
+struct DrainTimeouts {
+    std::chrono::milliseconds grace{30000};    ///< For in-flight work to finish on its own.
+    std::chrono::milliseconds cancelled{5000}; ///< For cancelled solves to unwind and answer.
+    std::chrono::milliseconds flush{1000};     ///< For answered connections to be written and closed.
+};
+
+/**
+ * @brief Shuts the server down in order.
+ *
+ * New connections are refused first; requests already read are still answered, with
+ * `Connection: close`. Once nothing is in flight, or the grace period passes, the solves still
+ * running are cancelled, and their callers answered, through their SolveContext. Connections
+ * then get a moment to write out what they were given before the IO threads stop.
+ *
+ * @return true if everything in flight finished; false if work was still running when the
+ * IO threads were stopped.
+ */
+bool drain(const DrainSteps &steps, const DrainTimeouts &timeouts);
+
+#endif //DOMINOREST_SHUTDOWN_H
@@ -0,0 +1,111 @@
+#include "signed_token.h"
+
+#include "crow.h"
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+#include <cstring>
+
+/**
+ * @file signed_token.cpp
+ * @brief Implementation of the HMAC-SHA256 token signer.
+ */
+
+/// kind (1) + key id (4) + expiry (8).
+static const size_t PAYLOAD_HEADER_SIZE = 13;
+
+static void put_be(std::string &out, uint64_t value, int bytes) {
+    for (int shift = (bytes - 1) * 8; shift >= 0; shift -= 8) {
+        out.push_back(static_cast<char>((value >> shift) & 0xFF));
+    }
+}
+
+static uint64_t get_be(const std::string &in, size_t offset, int bytes) {
+    uint64_t value = 0;
+    for (int i = 0; i < bytes; ++i) {
+        value = (value << 8) | static_cast<unsigned char>(in[offset + i]);
+    }
+    return value;
+}
+
+static void hmac_sha256(const std::string &secret, const std::string &payload, TokenKey &mac) {
+    unsigned int length = 0;
+    HMAC(EVP_sha256(), secret.data(), static_cast<int>(secret.size()),
+         reinterpret_cast<const unsigned char *>(payload.data()), payload.size(), mac.data(), &length);
+}
+
+static bool decode_part(const std::string &text, std::string &out) {
+    // crow's decoder indexes back from the end, so it needs at least one full quantum.
+    if (text.size() < 4) return false;
+    out = crow::utility::base64decode(text, text.size());
+    return true;
+}
+
+TokenSigner::TokenSigner(uint32_t key_id, std::string secret, std::chrono::seconds max_lifetime)
+        : key_id_(key_id), revoked_(max_lifetime) {
+    secrets_[key_id] = std::move(secret);
+}
+
+void TokenSigner::add_verification_key(uint32_t key_id, std::string secret) {
+    secrets_[key_id] = std::move(secret);
+}
+
+std::string TokenSigner::issue(TokenKind kind, const std::string &username,
+                               std::chrono::system_clock::time_point expires) const {
+    std::string payload;
+    payload.reserve(PAYLOAD_HEADER_SIZE + username.size());
+    payload.push_back(static_cast<char>(kind));
+    put_be(payload, key_id_, 4);
+    put_be(payload, static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::seconds>(expires.time_since_epoch()).count()), 8);
+    payload += username;
+
+    TokenKey mac;
+    hmac_sha256(secrets_.at(key_id_), payload, mac);
+    return crow::utility::base64encode_urlsafe(payload, payload.size()) + "." +
+           crow::utility::base64encode_urlsafe(mac.data(), mac.size());
+}
+
+bool TokenSigner::authentic(const std::string &token, TokenClaims &claims, TokenKey &mac) const {
+    size_t dot = token.find('.');
+    if (dot == std::string::npos) return false;
+
+    std::string payload, signature;
+    if (!decode_part(token.substr(0, dot), payload) || !decode_part(token.substr(dot + 1), signature)) {
+        return false;
+    }
+    if (payload.size() < PAYLOAD_HEADER_SIZE || signature.size() != mac.size()) return false;
+
+    claims.key_id = static_cast<uint32_t>(get_be(payload, 1, 4));
+    auto secret = secrets_.find(claims.key_id);
+    if (secret == secrets_.end()) return false;
+
+    hmac_sha256(secret->second, payload, mac);
+    if (CRYPTO_memcmp(mac.data(), signature.data(), mac.size()) != 0) return false;
+
+    claims.kind = static_cast<TokenKind>(payload[0]);
+    claims.expires = static_cast<int64_t>(get_be(payload, 5, 8));
+    claims.username = payload.substr(PAYLOAD_HEADER_SIZE);
+    return true;
+}
+
+bool TokenSigner::verify(const std::string &token, TokenKind kind, TokenClaims &claims,
+                         std::chrono::system_clock::time_point now) const {
+    TokenKey mac;
+    if (!authentic(token, claims, mac) || claims.kind != kind) return false;
+    int64_t now_seconds = std::chrono::duration_cast<std::chrono::seconds>(now.time_since_epoch()).count();
+    if (claims.expires <= now_seconds) return false;
+    return !revoked_.contains(mac);
+}
+
+bool TokenSigner::revoke(const std::string &token) {
+    TokenClaims claims;
+    TokenKey mac;
+    if (!authentic(token, claims, mac)) return false;
+    revoked_.insert(mac, claims.username);
+    return true;
+}
+
+void TokenSigner::expire_revocations() {
+    revoked_.expire();
+}
@@ -0,0 +1,82 @@
+#ifndef DOMINOREST_SIGNED_TOKEN_H
+#define DOMINOREST_SIGNED_TOKEN_H
+
+#include "token_store.h"
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+/**
+ * @file signed_token.h
+ * @brief Self-contained HMAC-SHA256 tokens that any node sharing the secret can verify.
+ */
+
+/**
+ * @brief What a signed token grants; a token of one kind never verifies as the other.
+ */
+enum class TokenKind : unsigned char {
+    Session = 's', ///< Issued by login_route, sent as Authorization.
+    DevKey = 'd'   ///< Issued by create_dev_key_route, sent as Dev-Key.
+};
+
+/**
+ * @brief The fields a signed token carries.
+ */
+struct TokenClaims {
+    TokenKind kind;
+    uint32_t key_id;
+    int64_t expires; ///< Seconds since the Unix epoch.
+    std::string username;
+};
+
+/**
+ * @class TokenSigner
+ * @brief Issues and verifies tokens of the form base64(payload) "." base64(HMAC-SHA256(payload)).
+ *
+ * The payload is kind (1 byte), key id (4 bytes) and expiry (8 bytes, both big-endian), followed by
+ * the user name. Verification is pure CPU: it needs only the secret named by the key id, so a token
+ * issued by one instance is accepted by every instance configured with the same keys. The only state
+ * is a revocation set, keyed by MAC, whose entries are reclaimed once the longest token lifetime has
+ * passed; revocations are local to the instance that recorded them.
+ *
+ * Keys must be added before the signer is shared between threads.
+ */
+class TokenSigner {
+public:
+    /**
+     * @param key_id Id of the key new tokens are signed with.
+     * @param secret The signing secret for @p key_id.
+     * @param max_lifetime Longest lifetime of any token issued; revocations are kept this long.
+     */
+    TokenSigner(uint32_t key_id, std::string secret, std::chrono::seconds max_lifetime);
+
+    /// Accepts tokens signed with @p secret under @p key_id, e.g. the key being rotated out.
+    void add_verification_key(uint32_t key_id, std::string secret);
+
+    std::string issue(TokenKind kind, const std::string &username,
+                      std::chrono::system_clock::time_point expires) const;
+
+    /**
+     * @brief Checks the signature, kind, expiry and revocation of @p token.
+     * @return true if valid; @p claims then holds its fields.
+     */
+    bool verify(const std::string &token, TokenKind kind, TokenClaims &claims,
+                std::chrono::system_clock::time_point now = std::chrono::system_clock::now()) const;
+
+    /// Rejects @p token from now on. @return false if it is not a token this signer can verify.
+    bool revoke(const std::string &token);
+
+    /// Drops revocations of tokens that have expired anyway.
+    void expire_revocations();
+
+private:
+    /// Splits @p token and checks its MAC; @p mac receives the MAC bytes.
+    bool authentic(const std::string &token, TokenClaims &claims, TokenKey &mac) const;
+
+    uint32_t key_id_;
+    std::unordered_map<uint32_t, std::string> secrets_;
+    TokenStore revoked_;
+};
+
+#endif //DOMINOREST_SIGNED_TOKEN_H
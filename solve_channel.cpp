@@ -0,0 +1,316 @@
+#include "solve_channel.h"
+
+#include "admission_control.h"
+#include "board_codec.h"
+#include "cpu_quota.h"
+#include <exception>
+#include <utility>
+#include <vector>
+
+/**
+ * @file solve_channel.cpp
+ * @brief Implementation of the /ws/solve websocket channel.
+ */
+
+/// Bytes of request id in front of a binary frame.
+static const size_t CHANNEL_ID_BYTES = 4;
+
+static std::string invalid_board_message(const BoardParseError &error) {
+    return "Bad Request: Invalid board: " + error.message + " at offset " + std::to_string(error.offset) + ".";
+}
+
+static bool parse_binary_frame(const std::string &data, ChannelRequest &request, std::string &error) {
+    if (data.size() < CHANNEL_ID_BYTES) {
+        error = "Bad Request: Binary frames start with a 4-byte request id.";
+        return false;
+    }
+    for (size_t i = 0; i < CHANNEL_ID_BYTES; ++i) {
+        request.binary_id = (request.binary_id << 8) | static_cast<unsigned char>(data[i]);
+    }
+    request.id = std::to_string(request.binary_id);
+    request.binary = true;
+
+    BoardParseError parse_error;
+    if (!decode_packed_board(data.data() + CHANNEL_ID_BYTES, data.size() - CHANNEL_ID_BYTES, request.board,
+                             parse_error)) {
+        parse_error.offset += CHANNEL_ID_BYTES;
+        error = invalid_board_message(parse_error);
+        return false;
+    }
+    return true;
+}
+
+static bool parse_text_frame(const std::string &data, ChannelRequest &request, std::string &error) {
+    auto frame = crow::json::load(data);
+    if (!frame || frame.t() != crow::json::type::Object || !frame.has("id")) {
+        error = "Bad Request: Frame must be a JSON object with an 'id'.";
+        return false;
+    }
+
+    const auto &id = frame["id"];
+    if (id.t() == crow::json::type::String) {
+        request.id = crow::json::wvalue(std::string(id.s())).dump();
+    } else if (id.t() == crow::json::type::Number && id.nt() != crow::json::num_type::Floating_point &&
+               id.nt() != crow::json::num_type::Double_precision_floating_point) {
+        request.id = std::to_string(id.i());
+    } else {
+        error = "Bad Request: 'id' must be an integer or a string.";
+        return false;
+    }
+
+    if (frame.has("cancel")) {
+        if (frame["cancel"].t() != crow::json::type::True) {
+            error = "Bad Request: 'cancel' must be true.";
+            return false;
+        }
+        request.cancel = true;
+        return true;
+    }
+
+    if (!frame.has("board") || frame["board"].t() != crow::json::type::List) {
+        error = "Bad Request: 'board' must be a list of rows.";
+        return false;
+    }
+    std::vector<std::vector<int>> rows;
+    try {
+        for (const auto &row: frame["board"]) {
+            std::vector<int> pips;
+            for (const auto &pip: row) {
+                pips.push_back(static_cast<int>(pip.i()));
+            }
+            rows.push_back(std::move(pips));
+        }
+    } catch (const std::exception &e) {
+        error = "Bad Request: Board rows must be lists of integers.";
+        return false;
+    }
+    if (!flatten_board(rows, request.board)) {
+        error = "Bad Request: Board must be rectangular with pips from 0 to " + std::to_string(BOARD_MAX_PIP) + ".";
+        return false;
+    }
+    return true;
+}
+
+bool parse_channel_frame(const std::string &data, bool is_binary, ChannelRequest &request, std::string &error) {
+    return is_binary ? parse_binary_frame(data, request, error) : parse_text_frame(data, request, error);
+}
+
+std::string channel_progress_frame(const std::string &id, const SolveContext &context) {
+    std::string frame = "{\"id\":" + id;
+    frame += ",\"type\":\"progress\",\"nodes\":";
+    frame += std::to_string(context.nodes.load(std::memory_order_relaxed));
+    frame += ",\"depth\":";
+    frame += std::to_string(context.depth.load(std::memory_order_relaxed));
+    frame += ",\"max_depth\":";
+    frame += std::to_string(context.max_depth.load(std::memory_order_relaxed));
+    frame += '}';
+    return frame;
+}
+
+std::string channel_result_frame(const std::string &id, const SolveResult &result) {
+    std::string solution = solution_json(result.placement, result.solved, result.seconds);
+    std::string frame;
+    frame.reserve(solution.size() + id.size() + 24);
+    frame += "{\"id\":";
+    frame += id;
+    frame += ",\"type\":\"result\",";
+    frame.append(solution, 1, std::string::npos); // solution without its opening brace
+    return frame;
+}
+
+std::string channel_packed_result_frame(uint32_t id, const FlatBoard &board, const SolveResult &result) {
+    std::vector<unsigned char> directions = placement_directions(result.placement);
+    std::string packed = encode_packed_board(board, &directions, result.solved);
+    std::string frame(CHANNEL_ID_BYTES, '\0');
+    for (size_t i = 0; i < CHANNEL_ID_BYTES; ++i) {
+        frame[i] = static_cast<char>(id >> (8 * (CHANNEL_ID_BYTES - 1 - i)));
+    }
+    frame += packed;
+    return frame;
+}
+
+std::string channel_error_frame(const std::string &id, const std::string &message, int retry_after) {
+    std::string frame = "{\"id\":" + id;
+    frame += ",\"type\":\"error\",\"message\":";
+    frame += crow::json::wvalue(message).dump();
+    if (retry_after > 0) {
+        frame += ",\"retry_after\":";
+        frame += std::to_string(retry_after);
+    }
+    frame += '}';
+    return frame;
+}
+
+SolveChannel::SolveChannel(AuthMiddleware::context auth)
+        : auth_(std::move(auth)), account_(quota_account(auth_)) {}
+
+void SolveChannel::attach(crow::websocket::connection &conn) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    conn_ = &conn;
+}
+
+void SolveChannel::detach() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    conn_ = nullptr;
+    for (auto &entry: running_) {
+        entry.second->cancelled = true;
+    }
+}
+
+void SolveChannel::receive(const std::string &data, bool is_binary) {
+    ChannelRequest request;
+    std::string error;
+    if (!parse_channel_frame(data, is_binary, request, error)) {
+        CROW_LOG_ERROR << error;
+        send(channel_error_frame(request.id.empty() ? "null" : request.id, error));
+        return;
+    }
+    if (request.cancel) {
+        cancel(request.id);
+        return;
+    }
+    if (request.binary && (request.board.rows > 0xFFFF || request.board.cols > 0xFFFF)) {
+        send(channel_error_frame(request.id, "Bad Request: Board is too large for the packed encoding."));
+        return;
+    }
+    start(std::move(request));
+}
+
+void SolveChannel::start(ChannelRequest request) {
+    if (!load_shedder().admit(RouteCost::Expensive)) {
+        if (load_shedder().draining()) {
+            CROW_LOG_WARNING << "Service Unavailable: Server is shutting down.";
+            send(channel_error_frame(request.id, "Service Unavailable: Server is shutting down.", 0));
+        } else {
+            CROW_LOG_WARNING << "Service Unavailable: Server is overloaded.";
+            send(channel_error_frame(request.id, "Service Unavailable: Server is overloaded, retry later.", 1));
+        }
+        return;
+    }
+
+    int retry_after = 0;
+    if (!solver_quota().admit(account_, retry_after)) {
+        load_shedder().release(RouteCost::Expensive);
+        CROW_LOG_WARNING << "Too Many Requests: CPU quota exhausted for user " + auth_.username;
+        send(channel_error_frame(request.id, "Too Many Requests: CPU quota exhausted.", retry_after));
+        return;
+    }
+
+    auto context = std::make_shared<SolveContext>();
+    std::string refusal;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (running_.count(request.id) != 0) {
+            refusal = "Conflict: A request with this id is still running.";
+        } else if (running_.size() >= SOLVE_CHANNEL_MAX_IN_FLIGHT) {
+            refusal = "Too Many Requests: At most " + std::to_string(SOLVE_CHANNEL_MAX_IN_FLIGHT) +
+                      " solves may run per connection.";
+        } else {
+            running_.emplace(request.id, context);
+        }
+    }
+    if (!refusal.empty()) {
+        load_shedder().release(RouteCost::Expensive);
+        send(channel_error_frame(request.id, refusal));
+        return;
+    }
+
+    // The callback runs on the solving thread; a weak reference keeps context -> channel from
+    // forming a cycle through running_.
+    std::weak_ptr<SolveChannel> weak_self = shared_from_this();
+    std::string id = request.id;
+    context->progress_interval = std::chrono::milliseconds(SOLVE_CHANNEL_PROGRESS_MS);
+    context->on_progress = [weak_self, id](const SolveContext &progress) {
+        if (auto self = weak_self.lock()) self->send(channel_progress_frame(id, progress));
+    };
+
+    auto self = shared_from_this();
+    bool queued = compute_pool().submit([self, request = std::move(request), context] {
+        self->run(request, *context);
+    });
+    if (!queued) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            running_.erase(id);
+        }
+        load_shedder().release(RouteCost::Expensive);
+        CROW_LOG_WARNING << "Service Unavailable: Worker queue is full.";
+        send(channel_error_frame(id, "Service Unavailable: Server is busy, retry later.", 1));
+    }
+}
+
+void SolveChannel::cancel(const std::string &id) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = running_.find(id);
+        if (it != running_.end()) {
+            it->second->cancelled = true;
+            return; // the solve answers with "cancelled" as it unwinds
+        }
+    }
+    send(channel_error_frame(id, "Not Found: No running request with this id."));
+}
+
+void SolveChannel::run(const ChannelRequest &request, SolveContext &context) {
+    SolveResult result;
+    {
+        CpuCharge charge(solver_quota(), account_, auth_.username);
+        result = solve_board(request.board, &context);
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_.erase(request.id);
+    }
+    load_shedder().release(RouteCost::Expensive);
+
+    if (result.cancelled) {
+        send("{\"id\":" + request.id + ",\"type\":\"cancelled\"}");
+    } else if (request.binary) {
+        send(channel_packed_result_frame(request.binary_id, request.board, result), true);
+    } else {
+        send(channel_result_frame(request.id, result));
+    }
+}
+
+void SolveChannel::send(std::string frame, bool binary) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (conn_ == nullptr) return;
+    // send_* only queues the frame on the connection's IO thread, so holding the lock is cheap,
+    // and it keeps the close handler (and so the connection's destruction) waiting until we return.
+    if (binary) {
+        conn_->send_binary(std::move(frame));
+    } else {
+        conn_->send_text(std::move(frame));
+    }
+}
+
+/// The channel a connection's userdata points at.
+static std::shared_ptr<SolveChannel> *channel_of(crow::websocket::connection &conn) {
+    return static_cast<std::shared_ptr<SolveChannel> *>(conn.userdata());
+}
+
+bool accept_solve_channel(const crow::request &req, void **userdata) {
+    AuthMiddleware::context auth;
+    if (!authorize_request(req, auth)) {
+        CROW_LOG_ERROR << "Unauthorized: /ws/solve requires a valid token or dev key.";
+        return false;
+    }
+    *userdata = new std::shared_ptr<SolveChannel>(std::make_shared<SolveChannel>(std::move(auth)));
+    return true;
+}
+
+void open_solve_channel(crow::websocket::connection &conn) {
+    if (auto *channel = channel_of(conn)) (*channel)->attach(conn);
+}
+
+void solve_channel_message(crow::websocket::connection &conn, const std::string &data, bool is_binary) {
+    if (auto *channel = channel_of(conn)) (*channel)->receive(data, is_binary);
+}
+
+void close_solve_channel(crow::websocket::connection &conn, const std::string &) {
+    auto *channel = channel_of(conn);
+    if (channel == nullptr) return;
+    (*channel)->detach();
+    delete channel;
+    conn.userdata(nullptr);
+}
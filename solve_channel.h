@@ -0,0 +1,129 @@
+#ifndef DOMINOREST_SOLVE_CHANNEL_H
+#define DOMINOREST_SOLVE_CHANNEL_H
+
+#include "crow.h"
+#include "auth_middleware.h"
+#include "board_parser.h"
+#include "puzzle_solver.h"
+#include "solve_service.h"
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+/**
+ * @file solve_channel.h
+ * @brief The /ws/solve websocket: many solves over one connection, answered as each finishes.
+ *
+ * The upgrade request must carry a login token or dev key, as for /solve. Each frame the client
+ * sends is one request:
+ *
+ *     text     {"id":7,"board":[[0,1],[1,0]]}   solve; id is an integer or a string
+ *     text     {"id":7,"cancel":true}           stop a running solve
+ *     binary   uint32 id (big-endian), then a packed board (board_codec.h)
+ *
+ * Solves run on compute_pool, so replies arrive in completion order, not request order; every
+ * reply names its request id:
+ *
+ *     {"id":7,"type":"progress","nodes":1048576,"depth":12,"max_depth":15}   every SOLVE_CHANNEL_PROGRESS_MS
+ *     {"id":7,"type":"result","status":"solved",...}                         solution_json plus id and type
+ *     binary   uint32 id, then the packed board with its placement            for binary requests
+ *     {"id":7,"type":"cancelled"}
+ *     {"id":7,"type":"error","message":"...","retry_after":3}                retry_after only when throttled
+ *
+ * Each solve is admitted through load_shedder() like an expensive HTTP request, so a saturated
+ * server answers with an error frame instead of queueing it. Closing the connection cancels
+ * everything still running on it.
+ */
+
+/// Largest frame a client may send.
+const uint64_t SOLVE_CHANNEL_MAX_FRAME = 1 << 20;
+
+/// Solves one connection may have queued or running at once.
+const size_t SOLVE_CHANNEL_MAX_IN_FLIGHT = 32;
+
+/// Interval between progress frames for a running solve.
+const int SOLVE_CHANNEL_PROGRESS_MS = 250;
+
+/**
+ * @struct ChannelRequest
+ * @brief One parsed client frame.
+ */
+struct ChannelRequest {
+    std::string id;         ///< The request id as JSON text ("7", "\"a\""), echoed in every reply.
+    uint32_t binary_id = 0; ///< The id prefix of a binary frame.
+    bool binary = false;    ///< Sent as a binary frame, so the result goes back packed.
+    bool cancel = false;
+    FlatBoard board;
+};
+
+/**
+ * @brief Parses a client frame into @p request.
+ * @return false with @p error set if the frame is malformed; @p request.id is filled in when
+ * the id could still be read, so the error can name it.
+ */
+bool parse_channel_frame(const std::string &data, bool is_binary, ChannelRequest &request, std::string &error);
+
+/// {"id":..,"type":"progress",...} from @p context's counters.
+std::string channel_progress_frame(const std::string &id, const SolveContext &context);
+
+/// {"id":..,"type":"result",...}: solution_json with the id and type in front.
+std::string channel_result_frame(const std::string &id, const SolveResult &result);
+
+/// The binary reply to a binary request: the id, then @p board packed with the result's placement.
+std::string channel_packed_result_frame(uint32_t id, const FlatBoard &board, const SolveResult &result);
+
+/// {"id":..,"type":"error","message":..}, with retry_after when @p retry_after is positive.
+std::string channel_error_frame(const std::string &id, const std::string &message, int retry_after = 0);
+
+/**
+ * @class SolveChannel
+ * @brief The requests in flight on one /ws/solve connection.
+ *
+ * Crow destroys a websocket connection right after its close handler returns, while solves may
+ * still be running on compute_pool. The channel therefore holds the connection behind a mutex and
+ * forgets it in detach(); worker threads send only while holding the mutex and only to an
+ * attached connection, and each task keeps the channel itself alive.
+ */
+class SolveChannel : public std::enable_shared_from_this<SolveChannel> {
+public:
+    explicit SolveChannel(AuthMiddleware::context auth);
+
+    void attach(crow::websocket::connection &conn);
+
+    /// Forgets the connection and cancels every request still running.
+    void detach();
+
+    /// Handles one client frame.
+    void receive(const std::string &data, bool is_binary);
+
+private:
+    void start(ChannelRequest request);
+
+    void cancel(const std::string &id);
+
+    void run(const ChannelRequest &request, SolveContext &context);
+
+    void send(std::string frame, bool binary = false);
+
+    AuthMiddleware::context auth_;
+    std::string account_;
+    std::mutex mutex_;
+    crow::websocket::connection *conn_ = nullptr;
+    std::unordered_map<std::string, std::shared_ptr<SolveContext>> running_;
+};
+
+/// onaccept: authenticates the upgrade request and creates the connection's SolveChannel.
+bool accept_solve_channel(const crow::request &req, void **userdata);
+
+/// onopen: attaches the connection to its channel.
+void open_solve_channel(crow::websocket::connection &conn);
+
+/// onmessage: hands the frame to the connection's channel.
+void solve_channel_message(crow::websocket::connection &conn, const std::string &data, bool is_binary);
+
+/// onclose: detaches the channel, cancelling its solves, and releases it.
+void close_solve_channel(crow::websocket::connection &conn, const std::string &reason);
+
+#endif //DOMINOREST_SOLVE_CHANNEL_H
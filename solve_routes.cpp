@@ -0,0 +1,145 @@
+#include "solve_routes.h"
+
+#include "board_codec.h"
+#include "phase_timings.h"
+#include "print_utils.h"
+#include "solve_service.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+/**
+ * @file solve_routes.cpp
+ * @brief Implementation of the /solve route.
+ */
+
+bool accepts_packed(const crow::request &req) {
+    return req.get_header_value("Accept").find(PACKED_BOARD_MIME) != std::string::npos;
+}
+
+bool sent_packed(const crow::request &req) {
+    return req.get_header_value("Content-Type").compare(0, std::strlen(PACKED_BOARD_MIME), PACKED_BOARD_MIME) == 0;
+}
+
+crow::response packed_response(std::string body) {
+    crow::response res(200, std::move(body));
+    res.set_header("Content-Type", PACKED_BOARD_MIME);
+    return res;
+}
+
+std::optional<crow::response> solve_route(const crow::request &req, const AuthMiddleware::context &auth,
+                                          const Respond &later) {
+    std::string account = quota_account(auth);
+    int retry_after = 0;
+    if (!solver_quota().admit(account, retry_after)) {
+        CROW_LOG_WARNING << "Too Many Requests: CPU quota exhausted for user " + auth.username;
+        crow::response res(429, "Too Many Requests: CPU quota exhausted.");
+        res.set_header("Retry-After", std::to_string(retry_after));
+        return res;
+    }
+    CpuCharge charge(solver_quota(), account, auth.username);
+
+    FlatBoard board;
+    BoardParseError error;
+    bool parsed;
+    {
+        PhaseTimer phase(RequestPhase::Parse);
+        parsed = sent_packed(req) ? decode_packed_board(req.body, board, error) : parse_board(req.body, board, error);
+    }
+    if (!parsed) {
+        std::string message = "Bad Request: Invalid board: " + error.message + " at offset " +
+                              std::to_string(error.offset) + ".";
+        CROW_LOG_ERROR << message;
+        return crow::response(400, message);
+    }
+
+    const char *format_param = req.url_params.get("format");
+    std::string format_name = format_param != nullptr ? format_param : "";
+    SolveFormat format = SolveFormat::Json;
+    if (format_name == "text") {
+        format = SolveFormat::Text;
+    } else if (!format_name.empty() && format_name != "json") {
+        CROW_LOG_ERROR << "Bad Request: 'format' must be 'json' or 'text'.";
+        return crow::response(400, "Bad Request: 'format' must be 'json' or 'text'.");
+    } else if (format_name.empty() && accepts_packed(req)) {
+        format = SolveFormat::Packed;
+    }
+
+    if (format == SolveFormat::Packed && (board.rows > 0xFFFF || board.cols > 0xFFFF)) {
+        CROW_LOG_ERROR << "Bad Request: Board is too large for the packed encoding.";
+        return crow::response(400, "Bad Request: Board is too large for the packed encoding.");
+    }
+    return solve_domino_puzzle(req, board, format, later);
+}
+
+/// Renders @p result, the solve of @p flat, as @p format asks.
+static crow::response solve_response(const FlatBoard &flat, const SolveResult &result, SolveFormat format) {
+    if (result.cancelled) {
+        CROW_LOG_WARNING << "Service Unavailable: Solve cancelled by shutdown.";
+        return crow::response(503, "Service Unavailable: Server is shutting down.");
+    }
+    CROW_LOG_INFO << (result.solved ? "Solution found for the domino puzzle."
+                                    : "No solution exists for the domino puzzle.");
+
+    PhaseTimer phase(RequestPhase::Render);
+    if (format == SolveFormat::Json) {
+        return crow::response("json", solution_json(result.placement, result.solved, result.seconds));
+    }
+    if (format == SolveFormat::Packed) {
+        std::vector<unsigned char> directions = placement_directions(result.placement);
+        return packed_response(encode_packed_board(flat, &directions, result.solved));
+    }
+
+    // The unsolved rendering ignores placement, so it can be drawn after solving. Everything is
+    // appended to one buffer reserved up front; each renderer sizes its own part exactly.
+    size_t board_size = board_render_size(result.board);
+    std::string output;
+    output.reserve(2 * board_size + result.dominos.size() * 8 + 128);
+    output += "Domino Board:\n";
+    render_board_with_solution(result.board, result.placement, false, output);
+
+    output += "\nDominos:\n";
+    render_dominos(result.dominos, result.max_pips + 1, output);
+    char seconds_text[64];
+    int seconds_length = std::snprintf(seconds_text, sizeof(seconds_text), "Time to solve: %.8f seconds\n",
+                                       result.seconds);
+    output.append(seconds_text, seconds_length);
+
+    if (result.solved) {
+        output += "\nSolution:\n";
+        render_board_with_solution(result.board, result.placement, true, output);
+    } else {
+        output += "\nNo solution exists.\n";
+    }
+    return crow::response{std::move(output)};
+}
+
+std::optional<crow::response> solve_domino_puzzle(const crow::request &req, const FlatBoard &flat, SolveFormat format,
+                                                  const Respond &later) {
+    // Identical boards arriving together are solved once (see SolveFlights). The leader times its
+    // own phases; a request that joins it carries its phases so far and spends its search waiting.
+    PhaseDurations so_far;
+    if (PhaseTimings::current() != nullptr) so_far = *PhaseTimings::current();
+    auto joined_at = std::chrono::steady_clock::now();
+    const std::string *route = req.route;
+    std::shared_ptr<const SolveResult> result = solve_flights().solve_or_join(
+            flat, [flat, format, later, so_far, joined_at, route](std::shared_ptr<const SolveResult> result,
+                                                                   std::exception_ptr error) {
+                PhaseTimings timings;
+                timings.add(so_far);
+                timings.add(RequestPhase::Search, std::chrono::steady_clock::now() - joined_at);
+                crow::response res;
+                if (error) {
+                    CROW_LOG_ERROR << "Server Error: The shared solve failed.";
+                    res = crow::response(500, "Server Error: Unable to process request.");
+                } else {
+                    res = solve_response(flat, *result, format);
+                }
+                timings.report(route, res);
+                later(std::move(res));
+            });
+    if (result == nullptr) return std::nullopt;
+    return solve_response(flat, *result, format);
+}
@@ -0,0 +1,79 @@
+#ifndef DOMINOREST_SOLVE_ROUTES_H
+#define DOMINOREST_SOLVE_ROUTES_H
+
+#include "crow.h"
+#include "auth_middleware.h"
+#include "board_parser.h"
+#include "worker_pool.h"
+#include <optional>
+#include <string>
+
+/**
+ * @file solve_routes.h
+ * @brief The /solve route, and the packed board negotiation the board routes share with it.
+ */
+
+/**
+ * @brief How /solve renders its answer.
+ */
+enum class SolveFormat {
+    Json,   ///< Status, per-cell domino ids and timing (default).
+    Text,   ///< The ASCII rendering of the board, domino set and solution (?format=text).
+    Packed  ///< The packed binary encoding, see board_codec.h (Accept: application/octet-stream).
+};
+
+/// Whether the client lists the packed board encoding in its Accept header.
+bool accepts_packed(const crow::request &req);
+
+/// Whether the request body is a packed board rather than JSON.
+bool sent_packed(const crow::request &req);
+
+/// A 200 response carrying a packed board.
+crow::response packed_response(std::string body);
+
+/**
+ * @brief Route for solving the domino puzzle.
+ *
+ * This route accepts a POST request with a JSON body representing the domino puzzle board.
+ * The board is a 2D array of integers. The function attempts to solve the puzzle and returns
+ * the solution as JSON:
+ *
+ *     {"status":"solved","rows":2,"cols":2,"placement":[[0,0],[1,1]],"solve_seconds":0.000001}
+ *
+ * where each cell holds the id of the domino covering it (its index in the domino set
+ * generate_dominos builds for the board's highest pip), or {"status":"unsolved",...} without a
+ * placement. ?format=text returns the ASCII rendering instead. With Content-Type
+ * application/octet-stream the body is a packed board, and with Accept application/octet-stream
+ * the answer is the packed board with its placement (see board_codec.h). Requests without a
+ * valid token or dev key are rejected by AuthMiddleware before this runs, and while the server is
+ * saturated ExpensiveAdmission answers 503 before that (see admission_control.h).
+ *
+ * The CPU time each solve takes is charged to the caller's dev key (or user name, for login
+ * tokens); once solver_quota is spent, further solves answer 429 until usage ages out.
+ *
+ * The Server-Timing header splits the time among parse, preprocess, search and render (see
+ * phase_timings.h).
+ *
+ * Returns nothing when the board joined an identical solve already running; @p later then
+ * receives the answer once that solve lands (see solve_domino_puzzle).
+ */
+std::optional<crow::response> solve_route(const crow::request &req, const AuthMiddleware::context &auth,
+                                          const Respond &later);
+
+/**
+ * @brief Solves the domino puzzle given a board configuration.
+ *
+ * Concurrent calls with an identical board share one solve through solve_flights(). A call that
+ * joins a solve already running returns at once, and its answer is handed to @p later from the
+ * solving thread when the solve lands, so the waiting request holds no thread.
+ * @param req The request, for the route its phase timings are recorded under.
+ * @param board The board to solve.
+ * @param format How to render the answer.
+ * @param later Receives the answer when the call joined another solve.
+ * @return A Crow response object with the solution or an error message; nothing if @p later will
+ * receive it.
+ */
+std::optional<crow::response> solve_domino_puzzle(const crow::request &req, const FlatBoard &board, SolveFormat format,
+                                                  const Respond &later);
+
+#endif //DOMINOREST_SOLVE_ROUTES_H
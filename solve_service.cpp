@@ -0,0 +1,239 @@
+#include "solve_service.h"
+
+#include "board_generator.h"
+#include "metrics.h"
+#include "phase_timings.h"
+#include "utils.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+/**
+ * @file solve_service.cpp
+ * @brief Implementation of the shared solve path.
+ */
+
+/// Tasks waiting for a compute_pool thread before new ones are turned away.
+static const size_t COMPUTE_QUEUE_LIMIT = 256;
+
+/// Counts a finished solve, and the search it took, into the solver's /metrics series.
+static void record_solve_metrics(const SolveResult &result, const SolveContext &context,
+                                 std::chrono::steady_clock::duration elapsed) {
+    static const char *const help = "Solves run, by outcome.";
+    static Counter &solved = metrics().counter("dominorest_solves_total", help, "result=\"solved\"");
+    static Counter &unsolved = metrics().counter("dominorest_solves_total", help, "result=\"unsolved\"");
+    static Counter &cancelled = metrics().counter("dominorest_solves_total", help, "result=\"cancelled\"");
+    static Counter &nodes = metrics().counter("dominorest_solver_nodes_total", "Search nodes the solver visited.");
+    static Counter &backtracks = metrics().counter("dominorest_solver_backtracks_total",
+                                                   "Placements the solver took back because nothing fit after them.");
+    static Histogram &duration = metrics().histogram("dominorest_solve_duration_seconds",
+                                                     "Wall time spent in the solver.");
+
+    (result.solved ? solved : result.cancelled ? cancelled : unsolved).add();
+    nodes.add(context.nodes.load(std::memory_order_relaxed));
+    backtracks.add(context.backtracks.load(std::memory_order_relaxed));
+    duration.record(elapsed);
+}
+
+SolveResult solve_board(const FlatBoard &board, SolveContext *context) {
+    SolveResult result;
+    {
+        PhaseTimer phase(RequestPhase::Preprocess);
+        result.board = board.to_rows();
+        result.placement.assign(board.rows, std::vector<int>(board.cols, -1));
+        result.max_pips = find_max_pips(result.board);
+        result.dominos = generate_dominos(result.max_pips + 1);
+    }
+
+    // Every solve gets a context, so that running_solves() can cancel it.
+    SolveContext own_context;
+    if (context == nullptr) context = &own_context;
+    running_solves().add(context);
+
+    PhaseTimer phase(RequestPhase::Search);
+    auto start = std::chrono::steady_clock::now();
+    try {
+        result.solved = PuzzleSolver::solve_puzzle(result.board, result.placement, result.dominos, 0, 0, context);
+    } catch (...) {
+        running_solves().remove(context);
+        throw;
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    result.seconds = std::chrono::duration<double>(elapsed).count();
+    running_solves().remove(context);
+    result.cancelled = !result.solved && context->cancelled.load();
+    record_solve_metrics(result, *context, elapsed);
+    return result;
+}
+
+void RunningSolves::add(SolveContext *context) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (cancelled_) context->cancelled.store(true);
+    contexts_.insert(context);
+}
+
+void RunningSolves::remove(SolveContext *context) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    contexts_.erase(context);
+}
+
+size_t RunningSolves::cancel_all() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    cancelled_ = true;
+    for (SolveContext *context: contexts_) context->cancelled.store(true);
+    return contexts_.size();
+}
+
+size_t RunningSolves::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return contexts_.size();
+}
+
+RunningSolves &running_solves() {
+    static RunningSolves solves;
+    return solves;
+}
+
+uint64_t board_hash(const FlatBoard &board) {
+    uint64_t hash = fnv1a(static_cast<uint32_t>(board.cols), fnv1a(static_cast<uint32_t>(board.rows)));
+    return fnv1a(board.pips.data(), board.pips.size(), hash);
+}
+
+SolveFlights::SolveFlights(Solver solver) : solver_(std::move(solver)) {}
+
+std::shared_ptr<const SolveResult> SolveFlights::solve(const FlatBoard &board, bool *joined) {
+    auto landed = std::make_shared<std::promise<std::shared_ptr<const SolveResult>>>();
+    std::future<std::shared_ptr<const SolveResult>> joined_result = landed->get_future();
+    std::shared_ptr<const SolveResult> result = solve_or_join(
+            board, [landed](std::shared_ptr<const SolveResult> result, std::exception_ptr error) {
+                if (error) {
+                    landed->set_exception(error);
+                } else {
+                    landed->set_value(std::move(result));
+                }
+            });
+    if (joined != nullptr) *joined = result == nullptr;
+    return result != nullptr ? result : joined_result.get();
+}
+
+std::shared_ptr<const SolveResult> SolveFlights::solve_or_join(const FlatBoard &board, Landed landed) {
+    uint64_t key = board_hash(board);
+    std::shared_ptr<Flight> flight;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = flights_.find(key);
+        if (it != flights_.end()) {
+            Flight &running = *it->second;
+            if (running.board.rows == board.rows && running.board.cols == board.cols &&
+                running.board.pips == board.pips) {
+                running.followers.push_back(std::move(landed));
+                joined_.fetch_add(1, std::memory_order_relaxed);
+                return nullptr;
+            }
+        } else {
+            flight = std::make_shared<Flight>();
+            flight->board = board;
+            flights_.emplace(key, flight);
+        }
+    }
+
+    if (!flight) {
+        // Another board with the same hash is in flight; solve this one on its own.
+        return std::make_shared<const SolveResult>(solver_(board, nullptr));
+    }
+
+    std::shared_ptr<const SolveResult> result;
+    std::exception_ptr error;
+    try {
+        result = std::make_shared<const SolveResult>(solver_(board, &flight->context));
+    } catch (...) {
+        error = std::current_exception();
+    }
+    // Once the flight is gone no one can join it, so the list of followers is final.
+    std::vector<Landed> followers;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        flights_.erase(key);
+        followers.swap(flight->followers);
+    }
+    for (Landed &follower: followers) {
+        try {
+            follower(result, error);
+        } catch (const std::exception &e) {
+            CROW_LOG_ERROR << "Solve follower failed: " << e.what();
+        }
+    }
+    if (error) std::rethrow_exception(error);
+    return result;
+}
+
+size_t SolveFlights::in_flight() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return flights_.size();
+}
+
+uint64_t SolveFlights::joined() const {
+    return joined_.load(std::memory_order_relaxed);
+}
+
+SolveFlights &solve_flights() {
+    static SolveFlights flights;
+    return flights;
+}
+
+std::string solution_json(const std::vector<std::vector<int>> &placement, bool solved, double seconds) {
+    int rows = placement.size();
+    int cols = rows == 0 ? 0 : placement[0].size();
+
+    std::string body;
+    // Ids stay below 1000 for any board the solver can finish, so 4 bytes per cell is ample.
+    body.reserve(96 + (solved ? static_cast<size_t>(rows) * (cols * 4 + 3) : 0));
+    body += solved ? "{\"status\":\"solved\"" : "{\"status\":\"unsolved\"";
+    body += ",\"rows\":";
+    body += std::to_string(rows);
+    body += ",\"cols\":";
+    body += std::to_string(cols);
+    if (solved) {
+        body += ",\"placement\":[";
+        for (int i = 0; i < rows; ++i) {
+            if (i > 0) body += ',';
+            body += '[';
+            for (int j = 0; j < cols; ++j) {
+                if (j > 0) body += ',';
+                body += std::to_string(placement[i][j]);
+            }
+            body += ']';
+        }
+        body += ']';
+    }
+    char seconds_text[48];
+    int seconds_length = std::snprintf(seconds_text, sizeof(seconds_text), ",\"solve_seconds\":%.8f}", seconds);
+    body.append(seconds_text, seconds_length);
+    return body;
+}
+
+CpuQuota &solver_quota() {
+    static CpuQuota quota(std::chrono::seconds(60), std::chrono::minutes(5));
+    return quota;
+}
+
+std::string quota_account(const AuthMiddleware::context &auth) {
+    return auth.dev_key.empty() ? "user:" + auth.username : "dev_key:" + auth.dev_key;
+}
+
+/// What compute_pool() is created with; 0 threads means one per core.
+static size_t compute_threads = 0;
+static size_t compute_queue_limit = COMPUTE_QUEUE_LIMIT;
+
+void configure_compute_pool(size_t threads, size_t queue_limit) {
+    compute_threads = threads;
+    compute_queue_limit = queue_limit;
+}
+
+WorkerPool &compute_pool() {
+    static WorkerPool pool("compute", compute_threads != 0 ? compute_threads
+                                                           : std::max(1u, std::thread::hardware_concurrency()),
+                           compute_queue_limit);
+    return pool;
+}
@@ -0,0 +1,160 @@
+#ifndef DOMINOREST_SOLVE_SERVICE_H
+#define DOMINOREST_SOLVE_SERVICE_H
+
+#include "auth_middleware.h"
+#include "board_parser.h"
+#include "cpu_quota.h"
+#include "domino.h"
+#include "puzzle_solver.h"
+#include "worker_pool.h"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+/**
+ * @file solve_service.h
+ * @brief Solving a parsed board, shared by the /solve route and the /ws/solve channel.
+ */
+
+/**
+ * @struct SolveResult
+ * @brief Everything a solve produced, for any of the renderings.
+ */
+struct SolveResult {
+    std::vector<std::vector<int>> board;
+    std::vector<std::vector<int>> placement; ///< Domino index per cell, -1 where the search left it empty.
+    std::vector<Domino> dominos;             ///< The set generate_dominos built for the board.
+    int max_pips = 0;
+    bool solved = false;
+    bool cancelled = false; ///< The context was cancelled before the search finished.
+    double seconds = 0;     ///< Wall time spent in the solver.
+};
+
+/**
+ * @brief Solves @p board with the full domino set for its highest pip.
+ *
+ * The solve is registered with running_solves() while it runs, so shutdown can cancel it.
+ *
+ * @param context If non-null, receives progress and can cancel the search (see SolveContext).
+ */
+SolveResult solve_board(const FlatBoard &board, SolveContext *context = nullptr);
+
+/**
+ * @class RunningSolves
+ * @brief The contexts of the solves running now, so that they can all be cancelled at once.
+ */
+class RunningSolves {
+public:
+    /// Registers @p context; it is cancelled straight away if cancel_all() has been called.
+    void add(SolveContext *context);
+
+    void remove(SolveContext *context);
+
+    /**
+     * @brief Cancels every registered solve, and every one added from now on.
+     * @return How many were running.
+     */
+    size_t cancel_all();
+
+    size_t size() const;
+
+private:
+    mutable std::mutex mutex_;
+    std::unordered_set<SolveContext *> contexts_;
+    bool cancelled_ = false;
+};
+
+/// The solves solve_board is running.
+RunningSolves &running_solves();
+
+/// FNV-1a over a board's dimensions and pips.
+uint64_t board_hash(const FlatBoard &board);
+
+/**
+ * @class SolveFlights
+ * @brief Single-flight solving: concurrent requests for an identical board share one solve.
+ *
+ * The first caller for a board becomes the flight's leader and solves it; callers arriving with
+ * the same board while it runs join the flight and receive the same result. Joining through
+ * solve_or_join blocks nothing: the leader hands the result to each follower as it lands, so a
+ * burst of identical requests occupies one thread, not one each. Flights are keyed by board_hash
+ * and the boards compared in full, so a hash collision only costs a solve of its own. Nothing
+ * outlives the flight: the same board asked for after it lands is solved again.
+ */
+class SolveFlights {
+public:
+    using Solver = std::function<SolveResult(const FlatBoard &, SolveContext *)>;
+
+    /// Receives a joined flight's result, or the exception its leader's solve threw (result null).
+    using Landed = std::function<void(std::shared_ptr<const SolveResult>, std::exception_ptr)>;
+
+    /// @param solver How a leader solves; solve_board unless a test substitutes its own.
+    explicit SolveFlights(Solver solver = solve_board);
+
+    /**
+     * @brief Solves @p board, or joins the solve of an identical board already running.
+     * @param joined Set when this caller received another caller's result.
+     * @throws whatever the leader's solve threw.
+     */
+    std::shared_ptr<const SolveResult> solve(const FlatBoard &board, bool *joined = nullptr);
+
+    /**
+     * @brief Solves @p board, unless an identical board is being solved already: then @p landed is
+     * queued on that flight and called on the leader's thread when it lands, and this returns at once.
+     * @return The result, or null when the caller joined a flight.
+     * @throws whatever this caller's own solve threw.
+     */
+    std::shared_ptr<const SolveResult> solve_or_join(const FlatBoard &board, Landed landed);
+
+    /// Solves currently running.
+    size_t in_flight() const;
+
+    /// Callers that received another caller's result so far.
+    uint64_t joined() const;
+
+private:
+    struct Flight {
+        FlatBoard board;
+        SolveContext context;
+        std::vector<Landed> followers;
+    };
+
+    Solver solver_;
+    mutable std::mutex mutex_;
+    std::unordered_map<uint64_t, std::shared_ptr<Flight>> flights_;
+    std::atomic<uint64_t> joined_{0};
+};
+
+/// The flights /solve shares.
+SolveFlights &solve_flights();
+
+/**
+ * @brief Renders a solve as the JSON document described on solve_route:
+ *
+ *     {"status":"solved","rows":2,"cols":2,"placement":[[0,0],[1,1]],"solve_seconds":0.000001}
+ */
+std::string solution_json(const std::vector<std::vector<int>> &placement, bool solved, double seconds);
+
+/// Solver CPU time each dev key (or user, when calling with a login token) may use per window.
+CpuQuota &solver_quota();
+
+/// The solver_quota account @p auth is charged to: its dev key, or its user for login tokens.
+std::string quota_account(const AuthMiddleware::context &auth);
+
+/// Threads running solves and board generation, so that CPU-bound work never blocks an IO thread.
+WorkerPool &compute_pool();
+
+/**
+ * @brief Sizes compute_pool(); only takes effect before its first use.
+ * @param threads Worker threads, or 0 for one per core.
+ */
+void configure_compute_pool(size_t threads, size_t queue_limit);
+
+#endif //DOMINOREST_SOLVE_SERVICE_H
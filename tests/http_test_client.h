@@ -0,0 +1,158 @@
+#ifndef DOMINOREST_HTTP_TEST_CLIENT_H
+#define DOMINOREST_HTTP_TEST_CLIENT_H
+
+#include "crow.h"
+#include <arpa/inet.h>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <future>
+#include <netinet/in.h>
+#include <poll.h>
+#include <string>
+#include <strings.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+/**
+ * @file http_test_client.h
+ * @brief A Crow app on an ephemeral port and a raw socket client, for tests that need real connections.
+ */
+
+/**
+ * @class TestServer
+ * @brief Runs @p App on 127.0.0.1 on a port the OS picks, until destroyed.
+ */
+template<typename App>
+class TestServer {
+public:
+    /// Starts @p app, whose routes must already be set up, with @p io_threads IO threads.
+    explicit TestServer(App &app, uint16_t io_threads = 1) : app_(app) {
+        app_.loglevel(crow::LogLevel::Warning);
+        app_.signal_clear();
+        running_ = app_.bindaddr("127.0.0.1").port(0).concurrency(io_threads + 1).run_async();
+        app_.wait_for_server_start();
+    }
+
+    ~TestServer() {
+        app_.stop();
+        running_.wait();
+    }
+
+    TestServer(const TestServer &) = delete;
+
+    TestServer &operator=(const TestServer &) = delete;
+
+    uint16_t port() { return app_.port(); }
+
+private:
+    App &app_;
+    std::future<void> running_;
+};
+
+/// A connection to 127.0.0.1:@p port, or -1.
+inline int connect_local(uint16_t port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+inline bool send_all(int fd, const std::string &data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) return false;
+        sent += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+/// Appends to @p buffer whatever arrives within @p timeout; false once the peer has closed or nothing came.
+inline bool read_some(int fd, std::string &buffer, std::chrono::milliseconds timeout) {
+    pollfd ready{fd, POLLIN, 0};
+    if (poll(&ready, 1, static_cast<int>(timeout.count())) <= 0) return false;
+    char chunk[16384];
+    ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+    if (n <= 0) return false;
+    buffer.append(chunk, static_cast<size_t>(n));
+    return true;
+}
+
+/// Everything received until the peer closes, or until nothing arrives for @p timeout.
+inline std::string read_until_closed(int fd, std::chrono::milliseconds timeout = std::chrono::milliseconds(2000)) {
+    std::string buffer;
+    while (read_some(fd, buffer, timeout)) {}
+    return buffer;
+}
+
+/**
+ * @struct TestResponse
+ * @brief One response read off the wire.
+ */
+struct TestResponse {
+    int code = 0;
+    std::string head; ///< Status line and headers, without the blank line.
+    std::string body;
+
+    /// The value of header @p name, matched case-insensitively; empty when absent.
+    std::string header(const std::string &name) const {
+        size_t line = head.find("\r\n");
+        while (line != std::string::npos) {
+            size_t start = line + 2;
+            size_t end = head.find("\r\n", start);
+            std::string field = head.substr(start, end == std::string::npos ? std::string::npos : end - start);
+            size_t colon = field.find(':');
+            if (colon == name.size() && strncasecmp(field.c_str(), name.c_str(), colon) == 0) {
+                size_t value = field.find_first_not_of(' ', colon + 1);
+                return value == std::string::npos ? "" : field.substr(value);
+            }
+            line = end;
+        }
+        return "";
+    }
+};
+
+/**
+ * @brief Splits @p count responses with Content-Length bodies off the front of @p buffer, reading
+ * more from @p fd as needed. Interim responses such as 100 Continue count as responses.
+ * @return The responses read; fewer than @p count if the connection closed or went quiet first.
+ */
+inline std::vector<TestResponse> read_responses(int fd, size_t count, std::string &buffer,
+                                                std::chrono::milliseconds timeout = std::chrono::milliseconds(2000)) {
+    std::vector<TestResponse> responses;
+    while (responses.size() < count) {
+        size_t head_end = buffer.find("\r\n\r\n");
+        if (head_end != std::string::npos) {
+            TestResponse response;
+            response.head = buffer.substr(0, head_end);
+            response.code = std::atoi(response.head.c_str() + response.head.find(' ') + 1);
+            std::string length = response.header("Content-Length");
+            size_t body_length = length.empty() ? 0 : std::strtoul(length.c_str(), nullptr, 10);
+            if (buffer.size() >= head_end + 4 + body_length) {
+                response.body = buffer.substr(head_end + 4, body_length);
+                buffer.erase(0, head_end + 4 + body_length);
+                responses.push_back(std::move(response));
+                continue;
+            }
+        }
+        if (!read_some(fd, buffer, timeout)) break;
+    }
+    return responses;
+}
+
+inline std::vector<TestResponse> read_responses(int fd, size_t count) {
+    std::string buffer;
+    return read_responses(fd, count, buffer);
+}
+
+#endif //DOMINOREST_HTTP_TEST_CLIENT_H
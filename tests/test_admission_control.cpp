@@ -0,0 +1,96 @@
+#include <gtest/gtest.h>
+#include "admission_control.h"
+#include "shutdown.h"
+#include "http_test_client.h"
+
+static AdmissionLimits TestLimits() {
+    AdmissionLimits limits;
+    limits.max_expensive_in_flight = 2;
+    limits.max_compute_backlog = 4;
+    limits.expensive_io_queue = 10;
+    limits.max_io_queue = 20;
+    return limits;
+}
+
+TEST(AdmissionControlTest, CapsExpensiveWorkInFlight) {
+    LoadShedder shedder(TestLimits());
+
+    EXPECT_TRUE(shedder.admit(RouteCost::Expensive));
+    EXPECT_TRUE(shedder.admit(RouteCost::Expensive));
+    EXPECT_FALSE(shedder.admit(RouteCost::Expensive));
+    EXPECT_EQ(shedder.in_flight(RouteCost::Expensive), 2u);
+    EXPECT_EQ(shedder.shed(RouteCost::Expensive), 1u);
+
+    // Cheap work is not counted against the expensive cap.
+    EXPECT_TRUE(shedder.admit(RouteCost::Cheap));
+
+    shedder.release(RouteCost::Expensive);
+    EXPECT_TRUE(shedder.admit(RouteCost::Expensive));
+}
+
+TEST(AdmissionControlTest, ShedsExpensiveWorkBeforeCheapAsIoQueuesGrow) {
+    LoadShedder shedder(TestLimits());
+    size_t io_queue = 10;
+    shedder.watch([&io_queue] { return io_queue; }, nullptr);
+
+    EXPECT_FALSE(shedder.admit(RouteCost::Expensive));
+    EXPECT_TRUE(shedder.admit(RouteCost::Cheap));
+
+    io_queue = 20;
+    EXPECT_FALSE(shedder.admit(RouteCost::Cheap));
+    EXPECT_EQ(shedder.in_flight(RouteCost::Cheap), 1u);
+    EXPECT_EQ(shedder.in_flight(RouteCost::Expensive), 0u);
+}
+
+TEST(AdmissionControlTest, ShedsExpensiveWorkWhileTheComputePoolIsBackedUp) {
+    LoadShedder shedder(TestLimits());
+    size_t backlog = 4;
+    shedder.watch(nullptr, [&backlog] { return backlog; });
+
+    EXPECT_FALSE(shedder.admit(RouteCost::Expensive));
+    EXPECT_TRUE(shedder.admit(RouteCost::Cheap));
+
+    backlog = 3;
+    EXPECT_TRUE(shedder.admit(RouteCost::Expensive));
+}
+
+TEST(AdmissionControlTest, DrainingRefusesOnlyExpensiveWork) {
+    LoadShedder shedder(TestLimits());
+    EXPECT_FALSE(shedder.draining());
+
+    shedder.drain();
+
+    EXPECT_TRUE(shedder.draining());
+    EXPECT_FALSE(shedder.admit(RouteCost::Expensive));
+    EXPECT_TRUE(shedder.admit(RouteCost::Cheap));
+}
+
+TEST(AdmissionControlTest, AdmitsAgainOnceConnectionsClose) {
+    crow::SimpleApp app;
+    CROW_ROUTE(app, "/")([] { return "ok"; });
+    TestServer<crow::SimpleApp> server(app);
+    LoadShedder shedder(TestLimits());
+    shedder.watch([&app] { return static_cast<size_t>(app.io_queue_length()); }, nullptr);
+
+    // Far more connections over the server's life than expensive_io_queue, but never many at once.
+    for (int i = 0; i < 50; ++i) {
+        int fd = connect_local(server.port());
+        ASSERT_GE(fd, 0);
+        ASSERT_TRUE(send_all(fd, "GET / HTTP/1.1\r\nHost: test\r\nConnection: close\r\n\r\n"));
+        read_until_closed(fd);
+        close(fd);
+    }
+    EXPECT_TRUE(wait_until([&app] { return app.io_queue_length() == 0; }, std::chrono::milliseconds(2000)));
+    EXPECT_TRUE(shedder.admit(RouteCost::Expensive));
+    shedder.release(RouteCost::Expensive);
+
+    // Connections held open do count, and stop counting once closed.
+    std::vector<int> open;
+    for (int i = 0; i < 12; ++i) open.push_back(connect_local(server.port()));
+    EXPECT_TRUE(wait_until([&app] { return app.io_queue_length() == 12; }, std::chrono::milliseconds(2000)));
+    EXPECT_FALSE(shedder.admit(RouteCost::Expensive));
+    for (int fd: open) close(fd);
+    EXPECT_TRUE(wait_until([&app] { return app.io_queue_length() == 0; }, std::chrono::milliseconds(2000)));
+    EXPECT_TRUE(shedder.admit(RouteCost::Expensive));
+    shedder.release(RouteCost::Expensive);
+}
@@ -0,0 +1,117 @@
+#include <gtest/gtest.h>
+#include "async_log.h"
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Options writing into @p out, waking only when flushed.
+static AsyncLogOptions CaptureTo(std::string &out, std::mutex &mutex, size_t capacity = 1024) {
+    AsyncLogOptions options;
+    options.ring_capacity = capacity;
+    options.flush_interval = std::chrono::hours(1);
+    options.write = [&out, &mutex](const std::string &lines) {
+        std::lock_guard<std::mutex> lock(mutex);
+        out += lines;
+    };
+    return options;
+}
+
+static size_t Count(const std::string &text, const std::string &needle) {
+    size_t count = 0;
+    for (size_t pos = text.find(needle); pos != std::string::npos; pos = text.find(needle, pos + 1)) ++count;
+    return count;
+}
+
+TEST(AsyncLogTest, WritesEveryThreadsLinesOnFlush) {
+    std::string out;
+    std::mutex mutex;
+    AsyncLogHandler handler(CaptureTo(out, mutex));
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&handler, t] {
+            for (int i = 0; i < 100; ++i) handler.log("thread " + std::to_string(t) + " line " + std::to_string(i),
+                                                     crow::LogLevel::Info);
+        });
+    }
+    for (auto &thread: threads) thread.join();
+    handler.flush();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    EXPECT_EQ(Count(out, "] thread "), 400u);
+    EXPECT_EQ(Count(out, "[INFO    ] thread 3 line 99\n"), 1u);
+    EXPECT_EQ(out[0], '(');
+    EXPECT_EQ(handler.dropped(), 0u);
+}
+
+TEST(AsyncLogTest, CollapsesRepeatedMessages) {
+    std::string out;
+    std::mutex mutex;
+    AsyncLogHandler handler(CaptureTo(out, mutex));
+
+    for (int i = 0; i < 5; ++i) handler.log("Bad Request: Invalid board.", crow::LogLevel::Error);
+    handler.log("Solution found.", crow::LogLevel::Info);
+    handler.flush();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    EXPECT_EQ(Count(out, "Bad Request: Invalid board."), 1u);
+    EXPECT_NE(out.find("[ERROR   ] Last message repeated 4 times.\n"), std::string::npos) << out;
+    EXPECT_LT(out.find("repeated 4 times"), out.find("Solution found."));
+    EXPECT_EQ(handler.suppressed(), 4u);
+}
+
+TEST(AsyncLogTest, CountsAndReportsDropsWhenARingIsFull) {
+    std::string out;
+    std::mutex mutex;
+    AsyncLogHandler handler(CaptureTo(out, mutex, 4));
+
+    for (int i = 0; i < 10; ++i) handler.log("line " + std::to_string(i), crow::LogLevel::Info);
+    handler.flush();
+
+    EXPECT_EQ(handler.dropped(), 6u);
+    std::lock_guard<std::mutex> lock(mutex);
+    EXPECT_NE(out.find("line 3\n"), std::string::npos);
+    EXPECT_EQ(out.find("line 4\n"), std::string::npos);
+    EXPECT_NE(out.find("[WARNING ] Log buffer full: dropped 6 messages.\n"), std::string::npos) << out;
+}
+
+TEST(AsyncLogTest, WritesSynchronouslyAfterStop) {
+    std::string out;
+    std::mutex mutex;
+    AsyncLogHandler handler(CaptureTo(out, mutex));
+    handler.log("buffered", crow::LogLevel::Info);
+
+    handler.stop();
+    handler.log("direct", crow::LogLevel::Warning);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    EXPECT_NE(out.find("[INFO    ] buffered\n"), std::string::npos);
+    EXPECT_NE(out.find("[WARNING ] direct\n"), std::string::npos);
+}
+
+TEST(AsyncLogTest, LinesLoggedWhileStoppingAreNotLost) {
+    // Threads keep logging across stop(): each line lands either in a ring stop() drains or in a direct write.
+    for (int round = 0; round < 20; ++round) {
+        std::string out;
+        std::mutex mutex;
+        AsyncLogHandler handler(CaptureTo(out, mutex));
+        std::atomic<int> started{0};
+
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t) {
+            threads.emplace_back([&handler, &started, t] {
+                started.fetch_add(1);
+                for (int i = 0; i < 500; ++i) handler.log("thread " + std::to_string(t) + " line " + std::to_string(i),
+                                                         crow::LogLevel::Info);
+            });
+        }
+        while (started.load() < 4) std::this_thread::yield();
+        handler.stop();
+        for (auto &thread: threads) thread.join();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        ASSERT_EQ(handler.dropped(), 0u);
+        ASSERT_EQ(Count(out, " line "), 2000u) << "round " << round;
+    }
+}
@@ -1,11 +1,17 @@
 #include <gtest/gtest.h>
 #include <crow.h>
-#include <unordered_map>
 #include "auth_handler.h"
 
-extern std::unordered_map<std::string, User> users;
-extern std::unordered_map<std::string, std::string> active_tokens;
-extern std::unordered_map<std::string, std::string> dev_keys;
+extern ShardedMap<std::string, User> users;
+extern TokenStore active_tokens;
+extern TokenStore dev_keys;
+
+// Stores @p token the way login_route does.
+void AddToken(TokenStore &store, const std::string &token) {
+    TokenKey key;
+    ASSERT_TRUE(decodeToken(token, key));
+    store.insert(key, "testuser");
+}
 
 // Test for generateNonce function
 TEST(AuthHandlerTest, GenerateNonceLength) {
@@ -34,8 +40,10 @@ TEST(AuthHandlerTest, RegisterRouteSuccess) {
     auto res = register_route(req);
     ASSERT_EQ(res.code, 200);
     ASSERT_EQ(users.size(), 1);
-    ASSERT_EQ(users["testuser"].salt.size(), 24);  // 16 bytes base64 encoded
-    ASSERT_EQ(users["testuser"].hashed_password.size(), 32);
+    User user;
+    ASSERT_TRUE(users.find("testuser", user));
+    ASSERT_EQ(user.salt.size(), 24);  // 16 bytes base64 encoded
+    ASSERT_EQ(user.hashed_password.size(), 32);
 }
 
 TEST(AuthHandlerTest, RegisterRouteUserExists) {
@@ -74,7 +82,7 @@ TEST(AuthHandlerTest, LoginRouteInvalidUser) {
 // Test for authenticate function
 TEST(AuthHandlerTest, AuthenticateSuccess) {
     std::string token = generateToken();
-    active_tokens[token] = "testuser";
+    AddToken(active_tokens, token);
     ASSERT_TRUE(authenticate(token));
 }
 
@@ -83,6 +91,23 @@ TEST(AuthHandlerTest, AuthenticateFailure) {
     ASSERT_FALSE(authenticate(token));
 }
 
+TEST(AuthHandlerTest, DecodeTokenRoundTrips) {
+    std::string token = generateToken();
+    TokenKey key;
+    ASSERT_TRUE(decodeToken(token, key));
+    EXPECT_EQ(crow::utility::base64encode(key.data(), key.size()), token);
+    EXPECT_FALSE(decodeToken("", key));
+    EXPECT_FALSE(decodeToken(generateNonce(16), key));
+}
+
+TEST(AuthHandlerTest, AuthenticateRejectsExpiredToken) {
+    std::string token = generateToken();
+    TokenKey key;
+    ASSERT_TRUE(decodeToken(token, key));
+    active_tokens.insert(key, "testuser", TokenStore::clock::now() - TOKEN_TTL);
+    ASSERT_FALSE(authenticate(token));
+}
+
 // Test for generateDevKey function
 TEST(AuthHandlerTest, GenerateDevKeyLength) {
     std::string dev_key = generateDevKey();
@@ -92,7 +117,7 @@ TEST(AuthHandlerTest, GenerateDevKeyLength) {
 // Test for create_dev_key_route function
 TEST(AuthHandlerTest, CreateDevKeyRouteSuccess) {
     std::string token = generateToken();
-    active_tokens[token] = "testuser";
+    AddToken(active_tokens, token);
 
     crow::request req;
     req.add_header("Authorization", token);
@@ -113,7 +138,7 @@ TEST(AuthHandlerTest, CreateDevKeyRouteUnauthorized) {
 // Test for verifyDevKey function
 TEST(AuthHandlerTest, VerifyDevKeySuccess) {
     std::string dev_key = generateDevKey();
-    dev_keys[dev_key] = "testuser";
+    AddToken(dev_keys, dev_key);
     ASSERT_TRUE(verifyDevKey(dev_key));
 }
 
@@ -134,4 +159,15 @@ TEST(AuthHandlerTest, LoginRouteInvalidPassword) {
     auto res = login_route(req2);
     ASSERT_EQ(res.code, 400);
     ASSERT_EQ(res.body, "Invalid username or password.");
-}
\ No newline at end of file
+}
+
+TEST(AuthHandlerTest, LogoutRouteInvalidatesToken) {
+    std::string token = generateToken();
+    AddToken(active_tokens, token);
+
+    crow::request req;
+    req.add_header("Authorization", token);
+    ASSERT_EQ(logout_route(req).code, 200);
+    ASSERT_FALSE(authenticate(token));
+    ASSERT_EQ(logout_route(req).code, 401);
+}
@@ -0,0 +1,67 @@
+#include <gtest/gtest.h>
+#include "auth_middleware.h"
+#include "auth_handler.h"
+
+extern TokenStore active_tokens;
+extern TokenStore dev_keys;
+
+// Issues a stored login token or dev key for @p username.
+std::string IssueCredential(TokenStore &store, const std::string &username) {
+    std::string credential = generateToken();
+    TokenKey key;
+    EXPECT_TRUE(decodeToken(credential, key));
+    store.insert(key, username);
+    return credential;
+}
+
+TEST(AuthMiddlewareTest, RejectsMissingCredentials) {
+    AuthMiddleware middleware;
+    AuthMiddleware::context ctx;
+    crow::request req;
+    crow::response res;
+    middleware.before_handle(req, res, ctx);
+    EXPECT_TRUE(res.is_completed());
+    EXPECT_EQ(res.code, 401);
+}
+
+TEST(AuthMiddlewareTest, AcceptsTokenOrDevKey) {
+    AuthMiddleware middleware;
+
+    crow::request with_token;
+    with_token.add_header("Authorization", IssueCredential(active_tokens, "alice"));
+    AuthMiddleware::context token_ctx;
+    crow::response token_res;
+    middleware.before_handle(with_token, token_res, token_ctx);
+    EXPECT_FALSE(token_res.is_completed());
+    EXPECT_EQ(token_ctx.username, "alice");
+    EXPECT_TRUE(token_ctx.dev_key.empty());
+
+    crow::request with_dev_key;
+    std::string dev_key = IssueCredential(dev_keys, "bob");
+    with_dev_key.add_header("Authorization", "invalidtoken");
+    with_dev_key.add_header("Dev-Key", dev_key);
+    AuthMiddleware::context dev_ctx;
+    crow::response dev_res;
+    middleware.before_handle(with_dev_key, dev_res, dev_ctx);
+    EXPECT_FALSE(dev_res.is_completed());
+    EXPECT_EQ(dev_ctx.username, "bob");
+    EXPECT_EQ(dev_ctx.dev_key, dev_key);
+}
+
+TEST(AuthMiddlewareTest, TokenIsNotAcceptedAsDevKey) {
+    crow::request req;
+    req.add_header("Dev-Key", IssueCredential(active_tokens, "alice"));
+    AuthMiddleware::context ctx;
+    EXPECT_FALSE(authorize_request(req, ctx));
+}
+
+TEST(AuthMiddlewareTest, CachedTokenIsDroppedOnLogout) {
+    crow::request req;
+    req.add_header("Authorization", IssueCredential(active_tokens, "alice"));
+    AuthMiddleware::context ctx;
+    ASSERT_TRUE(authorize_request(req, ctx));
+    ASSERT_TRUE(authorize_request(req, ctx)); // served from the cache
+
+    ASSERT_EQ(logout_route(req).code, 200);
+    EXPECT_FALSE(authorize_request(req, ctx));
+}
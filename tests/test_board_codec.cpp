@@ -0,0 +1,76 @@
+#include <gtest/gtest.h>
+#include "board_codec.h"
+
+FlatBoard MakeBoard(const std::vector<std::vector<int>> &rows) {
+    FlatBoard board;
+    EXPECT_TRUE(flatten_board(rows, board));
+    return board;
+}
+
+TEST(BoardCodecTest, SmallPipsPackIntoNibbles) {
+    FlatBoard board = MakeBoard({{1, 2, 3}, {4, 5, 15}});
+    std::string packed = encode_packed_board(board);
+    ASSERT_EQ(packed.size(), PACKED_BOARD_HEADER + 3);
+    EXPECT_EQ(packed.substr(0, 2), "DB");
+    EXPECT_EQ(packed[3], static_cast<char>(PACKED_NIBBLES));
+    EXPECT_EQ(static_cast<unsigned char>(packed[8]), 0x12);
+
+    FlatBoard decoded;
+    BoardParseError error;
+    ASSERT_TRUE(decode_packed_board(packed, decoded, error)) << error.message;
+    EXPECT_EQ(decoded.rows, 2);
+    EXPECT_EQ(decoded.cols, 3);
+    EXPECT_EQ(decoded.pips, board.pips);
+}
+
+TEST(BoardCodecTest, LargePipsUseWholeBytes) {
+    FlatBoard board = MakeBoard({{16, 200}});
+    std::string packed = encode_packed_board(board);
+    ASSERT_EQ(packed.size(), PACKED_BOARD_HEADER + 2);
+    EXPECT_EQ(packed[3], 0);
+
+    FlatBoard decoded;
+    BoardParseError error;
+    ASSERT_TRUE(decode_packed_board(packed, decoded, error));
+    EXPECT_EQ(decoded.pips, board.pips);
+}
+
+TEST(BoardCodecTest, PlacementDirectionsRoundTrip) {
+    // Piece 0 spans (0,0)-(0,1); piece 1 spans (0,2)-(1,2); piece 2 spans (1,0)-(1,1).
+    std::vector<std::vector<int>> placement{{0, 0, 1}, {2, 2, 1}};
+    std::vector<unsigned char> directions = placement_directions(placement);
+    std::vector<unsigned char> expected{PLACEMENT_RIGHT, PLACEMENT_LEFT, PLACEMENT_DOWN,
+                                        PLACEMENT_RIGHT, PLACEMENT_LEFT, PLACEMENT_UP};
+    ASSERT_EQ(directions, expected);
+
+    FlatBoard board = MakeBoard({{1, 2, 3}, {4, 5, 6}});
+    std::string packed = encode_packed_board(board, &directions, true);
+    EXPECT_EQ(packed[3], static_cast<char>(PACKED_NIBBLES | PACKED_PLACEMENT | PACKED_SOLVED));
+
+    FlatBoard decoded;
+    BoardParseError error;
+    std::vector<unsigned char> decoded_directions;
+    ASSERT_TRUE(decode_packed_board(packed, decoded, error, &decoded_directions));
+    EXPECT_EQ(decoded_directions, directions);
+}
+
+TEST(BoardCodecTest, RejectsMalformedInput) {
+    std::string packed = encode_packed_board(MakeBoard({{1, 2}}));
+    FlatBoard board;
+    BoardParseError error;
+
+    EXPECT_FALSE(decode_packed_board(packed.substr(0, 5), board, error));
+    EXPECT_EQ(error.message, "truncated header");
+
+    std::string bad_magic = packed;
+    bad_magic[0] = 'X';
+    EXPECT_FALSE(decode_packed_board(bad_magic, board, error));
+    EXPECT_EQ(error.offset, 0);
+
+    EXPECT_FALSE(decode_packed_board(packed + "x", board, error));
+    EXPECT_EQ(error.message, "length does not match dimensions");
+
+    EXPECT_FALSE(decode_packed_board(packed, board, error, nullptr, 1));
+    EXPECT_EQ(error.message, "pip out of range");
+    EXPECT_EQ(error.offset, PACKED_BOARD_HEADER);
+}
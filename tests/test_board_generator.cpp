@@ -49,3 +49,30 @@ TEST(GenerateAllBoardsTest, UniqueBoardsGenerated) {
         EXPECT_TRUE(result.second) << "Duplicate board detected: " << str;
     }
 }
+
+TEST(BoardToJson, FormatsMultiDigitAndNegativeValues) {
+    std::vector<std::vector<int>> board = {{0, 9, 10, 99}, {100, 12345, -7, 2147483647}, {-2147483647 - 1, 255, 1000, 42}};
+    std::string expected_json = "[[0,9,10,99],[100,12345,-7,2147483647],[-2147483648,255,1000,42]]";
+    EXPECT_EQ(board_to_json_string(board), expected_json);
+    EXPECT_EQ(board_json_size(board), expected_json.size());
+}
+
+TEST(BoardToJson, AppendsToExistingText) {
+    std::string out = "x";
+    append_board_json({{1}}, out);
+    EXPECT_EQ(out, "x[[1]]");
+    EXPECT_EQ(board_to_json_string({}), "[]");
+}
+
+TEST(BoardToJson, ResponseBodyWrapsBoardAndId) {
+    EXPECT_EQ(board_response_json("[[0,1],[2,3]]", 17), "{\"board\":[[0,1],[2,3]],\"id\":17}");
+}
+
+TEST(GenerateBoard, LargestGeneratedBoardsFitTheParser) {
+    // Each orientation at the longest side /generate_board allows: its pips must still parse.
+    for (auto size: {std::make_pair(2, GENERATED_BOARD_MAX_SIDE), std::make_pair(GENERATED_BOARD_MAX_SIDE, 2)}) {
+        auto board = generate_board(size.first, size.second);
+        FlatBoard flat;
+        EXPECT_TRUE(flatten_board(board, flat));
+    }
+}
@@ -0,0 +1,52 @@
+#include <gtest/gtest.h>
+#include "board_parser.h"
+
+TEST(BoardParserTest, ParsesRectangularBoard) {
+    FlatBoard board;
+    BoardParseError error;
+    ASSERT_TRUE(parse_board(" [[1, 2, 3],\n  [4,5,6]] ", board, error));
+    EXPECT_EQ(board.rows, 2);
+    EXPECT_EQ(board.cols, 3);
+    EXPECT_EQ(board.at(0, 0), 1);
+    EXPECT_EQ(board.at(1, 2), 6);
+
+    std::vector<std::vector<int>> expected = {{1, 2, 3}, {4, 5, 6}};
+    EXPECT_EQ(board.to_rows(), expected);
+}
+
+TEST(BoardParserTest, AcceptsMultiDigitPipsUpToMax) {
+    FlatBoard board;
+    BoardParseError error;
+    ASSERT_TRUE(parse_board("[[0,255],[10,9]]", board, error));
+    EXPECT_EQ(board.at(0, 1), 255);
+    EXPECT_EQ(board.at(1, 0), 10);
+}
+
+// Expects @p text to be rejected with @p message at @p offset.
+void ExpectError(const std::string &text, size_t offset, const std::string &message, int max_pip = BOARD_MAX_PIP) {
+    FlatBoard board;
+    BoardParseError error;
+    EXPECT_FALSE(parse_board(text, board, error, max_pip)) << text;
+    EXPECT_EQ(error.offset, offset) << text;
+    EXPECT_EQ(error.message, message) << text;
+}
+
+TEST(BoardParserTest, ReportsErrorPositions) {
+    ExpectError("", 0, "expected '[' opening the board");
+    ExpectError("[]", 1, "expected '[' opening a row");
+    ExpectError("[[]]", 2, "expected a pip value");
+    ExpectError("[[1,2],[3]]", 9, "row is shorter than the first row");
+    ExpectError("[[1,2],[3,4,5]]", 12, "row is longer than the first row");
+    ExpectError("[[1,2] [3,4]]", 7, "expected ',' or ']' after a row");
+    ExpectError("[[1.5]]", 3, "expected ',' or ']' after a pip");
+    ExpectError("[[1,\"2\"]]", 4, "expected a pip value");
+    ExpectError("[[1,2]] x", 8, "unexpected data after the board");
+    ExpectError("[[1,2", 5, "expected ',' or ']' after a pip");
+}
+
+TEST(BoardParserTest, ValidatesPipRange) {
+    ExpectError("[[1,256]]", 4, "pip out of range");
+    ExpectError("[[-1,2]]", 2, "pip out of range");
+    ExpectError("[[1,7]]", 4, "pip out of range", 6);
+    ExpectError("[[99999999999999999999]]", 2, "pip out of range");
+}
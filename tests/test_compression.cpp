@@ -0,0 +1,109 @@
+#include <gtest/gtest.h>
+#include "crow.h"
+#include "http_test_client.h"
+#include <string>
+
+using crow::compression::compress_string;
+using crow::compression::decompress_string;
+
+static std::string RepetitiveText() {
+    std::string text;
+    for (int i = 0; i < 2000; ++i) text += "| " + std::to_string(i % 7) + "   " + std::to_string(i % 5) + " |\n";
+    return text;
+}
+
+TEST(CompressionTest, GzipRoundTrips) {
+    std::string text = RepetitiveText();
+    std::string compressed = compress_string(text, crow::compression::GZIP);
+    ASSERT_GE(compressed.size(), 2u);
+    EXPECT_EQ(static_cast<unsigned char>(compressed[0]), 0x1f);
+    EXPECT_EQ(static_cast<unsigned char>(compressed[1]), 0x8b);
+    EXPECT_LT(compressed.size() * 5, text.size());
+    EXPECT_EQ(decompress_string(compressed), text);
+}
+
+TEST(CompressionTest, ReusedStreamsStayIndependent) {
+    // The thread's streams are reset between bodies; each level and algorithm has a stream of its own.
+    std::string first = RepetitiveText();
+    std::string second = "a different body " + first.substr(0, 500);
+    for (int level: {Z_BEST_SPEED, Z_BEST_COMPRESSION, Z_DEFAULT_COMPRESSION, Z_BEST_SPEED}) {
+        EXPECT_EQ(decompress_string(compress_string(first, crow::compression::GZIP, level)), first);
+        EXPECT_EQ(decompress_string(compress_string(second, crow::compression::DEFLATE, level)), second);
+        EXPECT_EQ(decompress_string(compress_string(second, crow::compression::GZIP, level)), second);
+    }
+}
+
+TEST(CompressionTest, UnknownLevelCompressesNothing) {
+    EXPECT_EQ(compress_string(RepetitiveText(), crow::compression::GZIP, Z_BEST_COMPRESSION + 1), "");
+    EXPECT_EQ(compress_string(RepetitiveText(), crow::compression::GZIP, crow::compression::INHERIT_LEVEL), "");
+}
+
+TEST(CompressionTest, HigherLevelIsNoLarger) {
+    std::string text = RepetitiveText();
+    EXPECT_LE(compress_string(text, crow::compression::GZIP, Z_BEST_COMPRESSION).size(),
+              compress_string(text, crow::compression::GZIP, Z_BEST_SPEED).size());
+}
+
+TEST(CompressionTest, EmptyAndIncompressibleBodiesStillRoundTrip) {
+    EXPECT_EQ(decompress_string(compress_string("", crow::compression::GZIP)), "");
+    std::string noise;
+    unsigned state = 12345;
+    for (int i = 0; i < 4096; ++i) {
+        state = state * 1103515245 + 12345;
+        noise += static_cast<char>(state >> 24);
+    }
+    EXPECT_EQ(decompress_string(compress_string(noise, crow::compression::DEFLATE, Z_BEST_SPEED)), noise);
+}
+
+TEST(CompressionTest, AcceptEncodingHonoursQValues) {
+    using crow::compression::accepts_encoding;
+    EXPECT_TRUE(accepts_encoding("gzip", "gzip"));
+    EXPECT_TRUE(accepts_encoding("deflate, GZIP;q=0.5", "gzip"));
+    EXPECT_TRUE(accepts_encoding("br;q=1.0, gzip ; q=0.001", "gzip"));
+    EXPECT_FALSE(accepts_encoding("gzip;q=0", "gzip"));
+    EXPECT_FALSE(accepts_encoding("gzip; q=0.000, deflate", "gzip"));
+    EXPECT_FALSE(accepts_encoding("", "gzip"));
+    EXPECT_FALSE(accepts_encoding("x-gzip-like, br", "gzip"));
+}
+
+TEST(CompressionTest, AcceptEncodingWildcardYieldsToExplicitEntries) {
+    using crow::compression::accepts_encoding;
+    EXPECT_TRUE(accepts_encoding("*", "gzip"));
+    EXPECT_FALSE(accepts_encoding("*;q=0", "gzip"));
+    EXPECT_FALSE(accepts_encoding("*, gzip;q=0", "gzip"));
+    EXPECT_TRUE(accepts_encoding("*;q=0, gzip", "gzip"));
+}
+
+TEST(CompressionTest, CompressibleResponsesVaryOnAcceptEncoding) {
+    crow::SimpleApp app;
+    app.use_compression(crow::compression::GZIP).compression_min_size(1024);
+    CROW_ROUTE(app, "/big")([] { return RepetitiveText(); });
+    CROW_ROUTE(app, "/small")([] { return "tiny"; });
+    TestServer<crow::SimpleApp> server(app);
+
+    auto fetch = [&server](const std::string &path, const std::string &accept_encoding) {
+        int fd = connect_local(server.port());
+        std::string request = "GET " + path + " HTTP/1.1\r\nHost: test\r\n";
+        if (!accept_encoding.empty()) request += "Accept-Encoding: " + accept_encoding + "\r\n";
+        send_all(fd, request + "\r\n");
+        auto responses = read_responses(fd, 1);
+        close(fd);
+        return responses.empty() ? TestResponse{} : responses[0];
+    };
+
+    TestResponse gzipped = fetch("/big", "gzip, deflate");
+    EXPECT_EQ(gzipped.header("Content-Encoding"), "gzip");
+    EXPECT_EQ(gzipped.header("Vary"), "Accept-Encoding");
+    EXPECT_EQ(decompress_string(gzipped.body), RepetitiveText());
+
+    // Refused or not asked for, the body goes out plain, but its form still depended on the header.
+    for (const char *accept_encoding: {"gzip;q=0", ""}) {
+        TestResponse plain = fetch("/big", accept_encoding);
+        EXPECT_EQ(plain.header("Content-Encoding"), "") << accept_encoding;
+        EXPECT_EQ(plain.header("Vary"), "Accept-Encoding") << accept_encoding;
+        EXPECT_EQ(plain.body, RepetitiveText());
+    }
+
+    // Too small to ever be compressed, so the same for every client.
+    EXPECT_EQ(fetch("/small", "gzip").header("Vary"), "");
+}
@@ -0,0 +1,80 @@
+#include <gtest/gtest.h>
+#include "cpu_quota.h"
+
+using namespace std::chrono;
+
+// Spins the calling thread until it has used at least @p amount of CPU time.
+void BurnCpu(nanoseconds amount) {
+    nanoseconds start = thread_cpu_time();
+    volatile unsigned sink = 0;
+    while (thread_cpu_time() - start < amount) {
+        for (int i = 0; i < 1000; ++i) sink = sink + i;
+    }
+}
+
+TEST(CpuQuotaTest, ThreadCpuTimeAdvancesWithWork) {
+    nanoseconds before = thread_cpu_time();
+    BurnCpu(milliseconds(5));
+    EXPECT_GE(thread_cpu_time() - before, milliseconds(5));
+}
+
+TEST(CpuQuotaTest, RefusesOnceBudgetIsSpent) {
+    CpuQuota quota(milliseconds(100), seconds(60));
+    auto now = CpuQuota::clock::now();
+    int retry_after = 0;
+    EXPECT_TRUE(quota.admit("team-a", retry_after, now));
+
+    quota.charge("team-a", "alice", milliseconds(60), now);
+    EXPECT_TRUE(quota.admit("team-a", retry_after, now));
+    quota.charge("team-a", "alice", milliseconds(60), now);
+    EXPECT_FALSE(quota.admit("team-a", retry_after, now));
+    EXPECT_GE(retry_after, 59);
+    EXPECT_LE(retry_after, 61);
+
+    EXPECT_TRUE(quota.admit("team-b", retry_after, now));
+}
+
+TEST(CpuQuotaTest, UsageAgesOutOfTheWindow) {
+    CpuQuota quota(milliseconds(100), seconds(60));
+    auto now = CpuQuota::clock::now();
+    int retry_after = 0;
+    quota.charge("team-a", "alice", milliseconds(80), now);
+    quota.charge("team-a", "alice", milliseconds(80), now + seconds(30));
+
+    EXPECT_FALSE(quota.admit("team-a", retry_after, now + seconds(31)));
+    EXPECT_TRUE(quota.admit("team-a", retry_after, now + seconds(62)));
+    EXPECT_TRUE(quota.usage(now + seconds(120)).empty());
+}
+
+TEST(CpuQuotaTest, UsageReportsPerAccount) {
+    CpuQuota quota(seconds(1), seconds(60));
+    auto now = CpuQuota::clock::now();
+    quota.charge("team-a", "alice", milliseconds(10), now);
+    quota.charge("team-a", "alice", milliseconds(20), now);
+    quota.charge("team-b", "bob", milliseconds(5), now);
+
+    auto usage = quota.usage(now);
+    ASSERT_EQ(usage.size(), 2);
+    for (const auto &entry: usage) {
+        if (entry.account == "team-a") {
+            EXPECT_EQ(entry.username, "alice");
+            EXPECT_EQ(entry.used, milliseconds(30));
+            EXPECT_EQ(entry.requests, 2u);
+        } else {
+            EXPECT_EQ(entry.account, "team-b");
+            EXPECT_EQ(entry.used, milliseconds(5));
+        }
+    }
+}
+
+TEST(CpuQuotaTest, CpuChargeMeasuresItsScope) {
+    CpuQuota quota(seconds(1), seconds(60));
+    {
+        CpuCharge charge(quota, "team-a", "alice");
+        BurnCpu(milliseconds(5));
+    }
+    auto usage = quota.usage();
+    ASSERT_EQ(usage.size(), 1);
+    EXPECT_GE(usage[0].used, milliseconds(5));
+    EXPECT_LT(usage[0].used, milliseconds(500));
+}
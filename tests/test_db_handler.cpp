@@ -3,6 +3,7 @@
 #include <fstream>
 #include <unistd.h>
 #include <fcntl.h>
+#include <cstdio>
 
 TEST(DBHandlerTest, OpenDatabaseSuccess) {
     sqlite3 *db = open_database();
@@ -16,8 +17,14 @@ TEST(DBHandlerTest, GetBoardByIdNotFound) {
     EXPECT_EQ(retrieved_board, "");
 }
 
+void ResetDatabase() {
+    std::remove(DB_PATH);
+    clear_board_cache();
+}
+
 void CorruptDatabaseFile() {
     // Create a corrupted database file
+    clear_board_cache();
     std::ofstream file(DB_PATH, std::ios::out | std::ios::trunc);
     file << "corrupted data";
     file.close();
@@ -79,6 +86,84 @@ TEST(DBHandlerTest, CallbackFunctionNullValue) {
     ASSERT_EQ(data, "");
 }
 
+TEST(DBHandlerTest, SaveIntoDBDeduplicatesIdenticalBoards) {
+    ResetDatabase();
+
+    std::string board = "[[0,1],[1,1]]";
+    int first_id = save_into_db(2, 2, board);
+    int second_id = save_into_db(2, 2, board);
+    EXPECT_GT(first_id, 0);
+    EXPECT_EQ(first_id, second_id);
+    EXPECT_EQ(get_board_by_id(first_id), board);
+
+    int other_id = save_into_db(2, 2, "[[1,1],[0,1]]");
+    EXPECT_GT(other_id, first_id);
+}
+
+TEST(DBHandlerTest, SaveIntoDBMigratesTableWithoutHash) {
+    ResetDatabase();
+    sqlite3 *db = open_database();
+    execute_sql(db, "CREATE TABLE BOARD(ID INTEGER PRIMARY KEY AUTOINCREMENT, COLS INT NOT NULL, "
+                    "ROWS INT NOT NULL, BOARD TEXT NOT NULL);", nullptr, nullptr);
+    execute_sql(db, "INSERT INTO BOARD (COLS, ROWS, BOARD) VALUES (2, 1, '[[0,0]]');", nullptr, nullptr);
+    sqlite3_close(db);
+
+    int first_id = save_into_db(2, 1, "[[0,1]]");
+    EXPECT_EQ(first_id, 2);
+    EXPECT_EQ(save_into_db(2, 1, "[[0,1]]"), first_id);
+    EXPECT_EQ(get_board_by_id(1), "[[0,0]]");
+}
+
+TEST(DBHandlerTest, BoardHashCoversDimensions) {
+    std::string board = "[[0,1,1],[1,2,2]]";
+    EXPECT_EQ(board_hash(3, 2, board), board_hash(3, 2, board));
+    EXPECT_NE(board_hash(3, 2, board), board_hash(2, 3, board));
+    EXPECT_NE(board_hash(3, 2, board), board_hash(3, 2, "[[0,1,1],[1,2,1]]"));
+}
+
+TEST(DBHandlerTest, BoardHashIsStableAcrossReleases) {
+    // Stored in the HASH column and in mmap store records: changing it orphans existing boards.
+    EXPECT_EQ(board_hash(3, 2, "[[0,1,1],[1,2,2]]"), 0x7cb85eb3ebed4e71ULL);
+}
+
+TEST(DBHandlerTest, ListBoardsKeysetPagination) {
+    ResetDatabase();
+    int a = save_into_db(2, 1, "[[0,0]]");
+    int b = save_into_db(1, 2, "[[0],[1]]");
+    int c = save_into_db(2, 1, "[[0,1]]");
+    int d = save_into_db(2, 1, "[[1,1]]");
+
+    std::vector<int> page;
+    auto collect = [&page](int id, int, int, const char *) { page.push_back(id); };
+
+    EXPECT_EQ(list_boards(1, 2, 0, 2, collect), 2);
+    EXPECT_EQ(page, (std::vector<int>{a, c}));
+
+    page.clear();
+    EXPECT_EQ(list_boards(1, 2, c, 2, collect), 1);
+    EXPECT_EQ(page, (std::vector<int>{d}));
+
+    page.clear();
+    EXPECT_EQ(list_boards(0, 0, a, 10, collect), 3);
+    EXPECT_EQ(page, (std::vector<int>{b, c, d}));
+}
+
+TEST(DBHandlerTest, GetBoardsByIdsMixesCacheAndDatabase) {
+    ResetDatabase();
+    int a = save_into_db(2, 1, "[[0,0]]");
+    int b = save_into_db(2, 1, "[[0,1]]");
+
+    // Drop b from the cache so it has to come from the database.
+    clear_board_cache();
+    EXPECT_EQ(get_board_by_id(a), "[[0,0]]");
+
+    auto boards = get_boards_by_ids({b, a, 999, a});
+    ASSERT_EQ(boards.size(), 2);
+    EXPECT_EQ(boards[a], "[[0,0]]");
+    EXPECT_EQ(boards[b], "[[0,1]]");
+    EXPECT_EQ(boards.count(999), 0);
+}
+
 // Test for the open_database function
 TEST(DBHandlerTest, OpenDatabaseSuccessMY) {
     sqlite3* db = open_database();
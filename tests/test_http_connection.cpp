@@ -0,0 +1,252 @@
+#include <gtest/gtest.h>
+#include "worker_pool.h"
+#include "http_test_client.h"
+#include <cerrno>
+#include <fcntl.h>
+#include <fstream>
+#include <future>
+#include <string>
+#include <thread>
+#include <vector>
+
+using std::chrono::milliseconds;
+
+/**
+ * A server whose routes answer with what they were asked: /n/<n> at once, /pool/<n> from a worker
+ * pool once the test releases it, /echo with the request body, /big with 1 MiB, and /file with a static file.
+ */
+struct PipelineServer {
+    crow::SimpleApp app;
+    WorkerPool pool{"test", 1, 16};
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    std::string file_path;
+
+    explicit PipelineServer(std::string file = "") : file_path(std::move(file)) {
+        CROW_ROUTE(app, "/n/<int>")([](int n) { return std::to_string(n); });
+        CROW_ROUTE(app, "/pool/<int>")([this](const crow::request &req, crow::response &res, int n) {
+            std::shared_future<void> wait = released;
+            respond_from_pool(pool, req, res, [wait, n] {
+                wait.wait();
+                return crow::response(std::to_string(n));
+            });
+        });
+        CROW_ROUTE(app, "/echo").methods(crow::HTTPMethod::Post)([](const crow::request &req) { return req.body; });
+        CROW_ROUTE(app, "/big")([] { return std::string(size_t(1) << 20, 'b'); });
+        CROW_ROUTE(app, "/file")([this](crow::response &res) {
+            res.set_static_file_info_unsafe(file_path);
+            res.end();
+        });
+    }
+
+    ~PipelineServer() {
+        try {
+            release.set_value();
+        } catch (const std::future_error &) {} // the test released it already
+    }
+};
+
+static std::string get(const std::string &path) {
+    return "GET " + path + " HTTP/1.1\r\nHost: test\r\n\r\n";
+}
+
+/// True if @p fd's peer closes it within @p timeout, having sent nothing more.
+static bool peer_closes(int fd, milliseconds timeout = milliseconds(2000)) {
+    pollfd ready{fd, POLLIN, 0};
+    if (poll(&ready, 1, static_cast<int>(timeout.count())) <= 0) return false;
+    char byte;
+    return recv(fd, &byte, 1, 0) == 0;
+}
+
+static std::vector<std::string> bodies(const std::vector<TestResponse> &responses) {
+    std::vector<std::string> result;
+    for (const auto &response: responses) result.push_back(response.body);
+    return result;
+}
+
+TEST(HttpConnectionTest, PipelinedRequestsAreAnsweredInOrder) {
+    PipelineServer test;
+    TestServer<crow::SimpleApp> server(test.app);
+    int fd = connect_local(server.port());
+    ASSERT_GE(fd, 0);
+
+    ASSERT_TRUE(send_all(fd, get("/n/1") + get("/n/2") + get("/n/3")));
+
+    auto responses = read_responses(fd, 3);
+    EXPECT_EQ(bodies(responses), (std::vector<std::string>{"1", "2", "3"}));
+    close(fd);
+}
+
+TEST(HttpConnectionTest, PoolResponseHoldsBackTheRequestsBufferedBehindIt) {
+    PipelineServer test;
+    TestServer<crow::SimpleApp> server(test.app);
+    int fd = connect_local(server.port());
+    ASSERT_GE(fd, 0);
+
+    ASSERT_TRUE(send_all(fd, get("/pool/1") + get("/n/2") + get("/n/3")));
+    std::string buffer;
+    EXPECT_FALSE(read_some(fd, buffer, milliseconds(100))); // /n/2 is ready but owed after /pool/1
+
+    test.release.set_value();
+    auto responses = read_responses(fd, 3, buffer);
+    EXPECT_EQ(bodies(responses), (std::vector<std::string>{"1", "2", "3"}));
+    close(fd);
+}
+
+TEST(HttpConnectionTest, ContinueIsQueuedBehindEarlierResponses) {
+    PipelineServer test;
+    TestServer<crow::SimpleApp> server(test.app);
+    int fd = connect_local(server.port());
+    ASSERT_GE(fd, 0);
+
+    ASSERT_TRUE(send_all(fd, get("/pool/1") + "POST /echo HTTP/1.1\r\nHost: test\r\nExpect: 100-continue\r\n"
+                                              "Content-Length: 5\r\n\r\n"));
+    std::string buffer;
+    EXPECT_FALSE(read_some(fd, buffer, milliseconds(100)));
+
+    test.release.set_value();
+    auto responses = read_responses(fd, 2, buffer);
+    ASSERT_EQ(responses.size(), 2u);
+    EXPECT_EQ(responses[0].code, 200);
+    EXPECT_EQ(responses[0].body, "1");
+    EXPECT_EQ(responses[1].code, 100);
+
+    ASSERT_TRUE(send_all(fd, "hello"));
+    responses = read_responses(fd, 1, buffer);
+    ASSERT_EQ(responses.size(), 1u);
+    EXPECT_EQ(responses[0].body, "hello");
+    close(fd);
+}
+
+TEST(HttpConnectionTest, BodySplitAcrossReadsIsReassembled) {
+    PipelineServer test;
+    TestServer<crow::SimpleApp> server(test.app);
+    int fd = connect_local(server.port());
+    ASSERT_GE(fd, 0);
+
+    ASSERT_TRUE(send_all(fd, "POST /echo HTTP/1.1\r\nHost: test\r\nContent-Length: 11\r\n\r\nhello"));
+    std::this_thread::sleep_for(milliseconds(50));
+    ASSERT_TRUE(send_all(fd, " world" + get("/n/2")));
+
+    auto responses = read_responses(fd, 2);
+    EXPECT_EQ(bodies(responses), (std::vector<std::string>{"hello world", "2"}));
+    close(fd);
+}
+
+TEST(HttpConnectionTest, ParseErrorAnswersEarlierRequestsThenCloses) {
+    PipelineServer test;
+    TestServer<crow::SimpleApp> server(test.app);
+    int fd = connect_local(server.port());
+    ASSERT_GE(fd, 0);
+
+    ASSERT_TRUE(send_all(fd, get("/n/1") + get("/n/2") + "NOT HTTP AT ALL\r\n\r\n" + get("/n/3")));
+
+    std::string buffer;
+    auto responses = read_responses(fd, 2, buffer);
+    EXPECT_EQ(bodies(responses), (std::vector<std::string>{"1", "2"}));
+    EXPECT_TRUE(buffer.empty());
+    EXPECT_TRUE(peer_closes(fd));
+    close(fd);
+}
+
+TEST(HttpConnectionTest, StopsReadingAheadPastTheInputCap) {
+    PipelineServer test;
+    TestServer<crow::SimpleApp> server(test.app);
+    int fd = connect_local(server.port());
+    ASSERT_GE(fd, 0);
+    // A fixed send buffer, so the kernel cannot grow it to hide that the server stopped reading.
+    int send_buffer = 16384;
+    ASSERT_EQ(setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &send_buffer, sizeof(send_buffer)), 0);
+
+    // 1 KiB requests, 8 MiB of them, all behind one the server cannot answer yet.
+    std::string padded = "GET /n/2 HTTP/1.1\r\nHost: test\r\nX-Pad: " + std::string(990, 'x') + "\r\n\r\n";
+    const size_t count = 8192;
+    std::string pipeline = get("/pool/1");
+    pipeline.reserve(pipeline.size() + padded.size() * count);
+    for (size_t i = 0; i < count; ++i) pipeline += padded;
+
+    size_t sent = 0;
+    while (sent < pipeline.size()) {
+        ssize_t n = send(fd, pipeline.data() + sent, pipeline.size() - sent, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n > 0) {
+            sent += static_cast<size_t>(n);
+            continue;
+        }
+        ASSERT_TRUE(errno == EAGAIN || errno == EWOULDBLOCK);
+        pollfd writable{fd, POLLOUT, 0};
+        if (poll(&writable, 1, 200) == 0) break; // nobody is reading
+    }
+    // 64 KiB buffered by the server plus what the kernel holds at both ends; far short of all of it.
+    EXPECT_LT(sent, size_t(2) << 20);
+
+    // Once the first is answered the rest are read and answered too.
+    test.release.set_value();
+    std::thread sender([fd, &pipeline, sent] { send_all(fd, pipeline.substr(sent)); });
+    std::string buffer;
+    auto responses = read_responses(fd, count + 1, buffer);
+    sender.join();
+    ASSERT_EQ(responses.size(), count + 1);
+    EXPECT_EQ(responses.front().body, "1");
+    EXPECT_EQ(responses.back().body, "2");
+    close(fd);
+}
+
+TEST(HttpConnectionTest, SlowReaderIsNotTimedOutMidResponse) {
+    PipelineServer test;
+    test.app.timeout(1);
+    TestServer<crow::SimpleApp> server(test.app);
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    ASSERT_GE(fd, 0);
+    // A small receive window, set before connecting, so the server's writes stall until the test reads.
+    int receive_buffer = 4096;
+    ASSERT_EQ(setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &receive_buffer, sizeof(receive_buffer)), 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(server.port());
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    ASSERT_EQ(connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)), 0);
+
+    const size_t count = 4;
+    std::string pipeline;
+    for (size_t i = 0; i < count; ++i) pipeline += get("/big");
+    ASSERT_TRUE(send_all(fd, pipeline));
+
+    // Well past the 1 s timeout with a write still in flight.
+    std::this_thread::sleep_for(milliseconds(2500));
+    std::string buffer;
+    auto responses = read_responses(fd, count, buffer);
+    ASSERT_EQ(responses.size(), count);
+    for (const auto &response: responses) EXPECT_EQ(response.body.size(), size_t(1) << 20);
+
+    // Idle again once everything has been sent, the connection does time out.
+    EXPECT_TRUE(peer_closes(fd, milliseconds(4000)));
+    close(fd);
+}
+
+TEST(HttpConnectionTest, StaticFilesAreStreamedAheadOfLaterResponses) {
+    char path[] = "/tmp/dominorest_static_XXXXXX";
+    int file = mkstemp(path);
+    ASSERT_GE(file, 0);
+    close(file);
+    // Several chunks' worth, not a multiple of the chunk size.
+    std::string content;
+    for (int i = 0; content.size() < 100000; ++i) content += std::to_string(i) + ",";
+    std::ofstream(path, std::ios::binary) << content;
+
+    {
+        PipelineServer test(path);
+        TestServer<crow::SimpleApp> server(test.app);
+        int fd = connect_local(server.port());
+        ASSERT_GE(fd, 0);
+
+        ASSERT_TRUE(send_all(fd, get("/file") + get("/n/2")));
+
+        auto responses = read_responses(fd, 2);
+        ASSERT_EQ(responses.size(), 2u);
+        EXPECT_EQ(responses[0].header("Content-Length"), std::to_string(content.size()));
+        EXPECT_TRUE(responses[0].body == content);
+        EXPECT_EQ(responses[1].body, "2");
+        close(fd);
+    }
+    unlink(path);
+}
@@ -0,0 +1,83 @@
+#include <gtest/gtest.h>
+#include "metrics.h"
+#include <thread>
+#include <vector>
+
+TEST(MetricsTest, BucketsAreLogLinear) {
+    EXPECT_EQ(Histogram::bucket_bound(0), 1u);
+    EXPECT_EQ(Histogram::bucket_bound(1), 2u);
+    EXPECT_EQ(Histogram::bucket_bound(2), 3u);
+    EXPECT_EQ(Histogram::bucket_bound(3), 4u);
+    EXPECT_EQ(Histogram::bucket_bound(4), 6u);
+    EXPECT_EQ(Histogram::bucket_bound(5), 8u);
+    EXPECT_EQ(Histogram::bucket_bound(Histogram::FINITE_BUCKETS - 1), 1ULL << 27);
+
+    // Every value lands in the first bucket whose bound is not below it.
+    for (uint64_t micros = 0; micros <= 5000; ++micros) {
+        size_t index = Histogram::bucket_index(micros);
+        ASSERT_LE(micros, Histogram::bucket_bound(index)) << micros;
+        if (index > 0) {
+            ASSERT_GT(micros, Histogram::bucket_bound(index - 1)) << micros;
+        }
+    }
+    EXPECT_EQ(Histogram::bucket_index((1ULL << 27) + 1), Histogram::FINITE_BUCKETS);
+    EXPECT_EQ(Histogram::bucket_index(~0ULL), Histogram::FINITE_BUCKETS);
+}
+
+TEST(MetricsTest, CountersAddUpAcrossThreads) {
+    Counter counter;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t) {
+        threads.emplace_back([&counter] {
+            for (int i = 0; i < 10000; ++i) counter.add();
+        });
+    }
+    for (auto &thread: threads) thread.join();
+    EXPECT_EQ(counter.value(), 80000u);
+}
+
+TEST(MetricsTest, HistogramSnapshotCountsAndSums) {
+    Histogram histogram;
+    histogram.record(std::chrono::nanoseconds(500));
+    histogram.record(std::chrono::microseconds(5));
+    histogram.record(std::chrono::seconds(1000));
+
+    Histogram::Snapshot snapshot = histogram.snapshot();
+    EXPECT_EQ(snapshot.count, 3u);
+    EXPECT_EQ(snapshot.counts[0], 1u);
+    EXPECT_EQ(snapshot.counts[Histogram::bucket_index(5)], 1u);
+    EXPECT_EQ(snapshot.counts[Histogram::FINITE_BUCKETS], 1u);
+    EXPECT_EQ(snapshot.sum_nanos, 500u + 5000u + 1000000000000u);
+}
+
+TEST(MetricsTest, RendersPrometheusText) {
+    MetricsRegistry registry;
+    registry.counter("test_requests_total", "Requests.", "route=\"/a\"").add(3);
+    EXPECT_EQ(&registry.counter("test_requests_total", "Requests.", "route=\"/a\""),
+              &registry.counter("test_requests_total", "Requests.", "route=\"/a\""));
+    registry.gauge("test_queue_depth", "Queued.", "", [] { return 7.0; });
+    registry.histogram("test_latency_seconds", "Latency.", "op=\"get\"").record(std::chrono::microseconds(3));
+
+    std::string text = registry.render();
+    EXPECT_NE(text.find("# HELP test_requests_total Requests.\n# TYPE test_requests_total counter\n"
+                        "test_requests_total{route=\"/a\"} 3\n"), std::string::npos) << text;
+    EXPECT_NE(text.find("# TYPE test_queue_depth gauge\ntest_queue_depth 7\n"), std::string::npos) << text;
+    EXPECT_NE(text.find("test_latency_seconds_bucket{op=\"get\",le=\"2e-06\"} 0\n"), std::string::npos) << text;
+    EXPECT_NE(text.find("test_latency_seconds_bucket{op=\"get\",le=\"3e-06\"} 1\n"), std::string::npos) << text;
+    EXPECT_NE(text.find("test_latency_seconds_bucket{op=\"get\",le=\"+Inf\"} 1\n"), std::string::npos) << text;
+    EXPECT_NE(text.find("test_latency_seconds_count{op=\"get\"} 1\n"), std::string::npos) << text;
+}
+
+TEST(MetricsTest, GaugesMayRegisterMetricsWhileRendered) {
+    MetricsRegistry registry;
+    registry.gauge("test_lazy", "Reads a counter registered on first use.", "", [&registry] {
+        return static_cast<double>(registry.counter("test_lazy_total", "Registered during a render.").value());
+    });
+
+    EXPECT_NE(registry.render().find("test_lazy 0\n"), std::string::npos);
+    EXPECT_NE(registry.render().find("test_lazy_total 0\n"), std::string::npos);
+}
+
+TEST(MetricsTest, EscapesLabelValues) {
+    EXPECT_EQ(label_value("/a\"b\\c\n"), "\"/a\\\"b\\\\c\\n\"");
+}
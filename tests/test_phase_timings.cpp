@@ -0,0 +1,50 @@
+#include <gtest/gtest.h>
+#include "phase_timings.h"
+#include "metrics.h"
+
+TEST(PhaseTimingsTest, TimersAddToTheCurrentTimings) {
+    EXPECT_EQ(PhaseTimings::current(), nullptr);
+    {
+        PhaseTimer ignored(RequestPhase::Parse); // nothing current: a no-op
+    }
+
+    PhaseTimings timings;
+    EXPECT_EQ(PhaseTimings::current(), &timings);
+    timings.add(RequestPhase::Search, std::chrono::milliseconds(12));
+    timings.add(RequestPhase::Search, std::chrono::microseconds(500));
+    {
+        PhaseTimer parse(RequestPhase::Parse);
+    }
+    {
+        PhaseTimings inner;
+        PhaseTimer render(RequestPhase::Render);
+    }
+    EXPECT_EQ(PhaseTimings::current(), &timings);
+
+    EXPECT_EQ(timings.elapsed(RequestPhase::Search), std::chrono::microseconds(12500));
+    EXPECT_EQ(timings.elapsed(RequestPhase::Render), std::chrono::steady_clock::duration::zero());
+    std::string header = timings.server_timing();
+    EXPECT_EQ(header.compare(0, 10, "parse;dur="), 0) << header;
+    EXPECT_NE(header.find(", search;dur=12.500"), std::string::npos) << header;
+    EXPECT_EQ(header.find("render"), std::string::npos) << header;
+}
+
+TEST(PhaseTimingsTest, ReportsTheHeaderAndRecordsPhasesUnderTheRoute) {
+    static const std::string route = "/test_phase_route";
+    crow::request req;
+    req.route = &route;
+
+    crow::response res = timed_phases(req, [] {
+        PhaseTimings::current()->add(RequestPhase::Db, std::chrono::milliseconds(3));
+        return crow::response(200);
+    });
+
+    EXPECT_EQ(res.get_header_value("Server-Timing"), "db;dur=3.000");
+    Histogram &db = metrics().histogram("dominorest_request_phase_seconds", "",
+                                        "route=\"/test_phase_route\",phase=\"db\"");
+    EXPECT_EQ(db.snapshot().count, 1u);
+    Histogram &parse = metrics().histogram("dominorest_request_phase_seconds", "",
+                                           "route=\"/test_phase_route\",phase=\"parse\"");
+    EXPECT_EQ(parse.snapshot().count, 0u);
+    EXPECT_EQ(PhaseTimings::current(), nullptr);
+}
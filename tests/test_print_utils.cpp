@@ -42,3 +42,59 @@ TEST(PrintUtilsTest, PrintDominos) {
             "[0|3] \n";
     EXPECT_EQ(output.str(), expectedOutput);
 }
+
+TEST(PrintUtilsTest, RenderBoardAppendsMultiDigitPips) {
+    std::vector<std::vector<int>> board = {{10, 2, 7}, {3, 104, 0}};
+    std::vector<std::vector<int>> placement = {{0, 0, 1}, {2, 2, 1}};
+    std::string rendered = "prefix:";
+    render_board_with_solution(board, placement, false, rendered);
+    EXPECT_EQ(rendered,
+              "prefix:"
+              "+---+---+---+\n"
+              "| 10   2   7 |\n"
+              "+   +   +   +\n"
+              "| 3   104   0 |\n"
+              "+---+---+---+\n");
+    EXPECT_EQ(board_render_size(board), rendered.size() - 7);
+
+    rendered.clear();
+    render_board_with_solution(board, placement, true, rendered);
+    EXPECT_EQ(rendered,
+              "+---+---+---+\n"
+              "| 10   2 | 7 |\n"
+              "+---+---+   +\n"
+              "| 3   104 | 0 |\n"
+              "+---+---+---+\n");
+    EXPECT_EQ(board_render_size(board), rendered.size());
+
+    std::ostringstream stream;
+    print_board_with_solution(board, placement, true, stream);
+    EXPECT_EQ(stream.str(), rendered);
+}
+
+TEST(PrintUtilsTest, RenderBoardSizeCountsEveryDigit) {
+    std::vector<std::vector<int>> board = {{-5, 12}};
+    std::vector<std::vector<int>> placement = {{0, 0}};
+    std::string rendered;
+    render_board_with_solution(board, placement, true, rendered);
+    EXPECT_EQ(rendered,
+              "+---+---+\n"
+              "| -5   12 |\n"
+              "+---+---+\n");
+    EXPECT_EQ(board_render_size(board), rendered.size());
+}
+
+TEST(PrintUtilsTest, RenderDominosGroupsBySide2InOrder) {
+    std::vector<Domino> dominos = {{0, 3}, {0, 1}, {12, 12}, {1, 1}, {2, 2}, {5, 40}, {1, 3}};
+    std::string rendered;
+    render_dominos(dominos, 13, rendered);
+    // Dominos whose side2 falls outside [0, rows) are not listed, as with print_dominos.
+    std::string expectedOutput =
+            "\n"
+            "[0|1] [1|1] \n"
+            "[2|2] \n"
+            "[0|3] [1|3] \n"
+            "\n\n\n\n\n\n\n\n"
+            "[12|12] \n";
+    EXPECT_EQ(rendered, expectedOutput);
+}
@@ -268,4 +268,44 @@ TEST(PuzzleSolverThreadTest, MultipleThreads) {
 
     // Check if solution_found is set to true if either thread solves the puzzle
     EXPECT_TRUE(PuzzleSolver::get_solution_found());
-}
\ No newline at end of file
+}
+
+TEST(PuzzleSolverTest, PlacementRecordsDominoIndices) {
+    // Both dominos have side1 == 1, so only their indices tell the two pieces apart.
+    std::vector<std::vector<int>> board{{1, 1, 1, 2}};
+    std::vector<std::vector<int>> placement{{-1, -1, -1, -1}};
+    std::vector<Domino> dominos{{1, 2},
+                                {1, 1}};
+
+    ASSERT_TRUE(PuzzleSolver::solve_puzzle(board, placement, dominos, 0, 0));
+    std::vector<std::vector<int>> expected{{1, 1, 0, 0}};
+    EXPECT_EQ(placement, expected);
+}
+
+TEST(PuzzleSolverTest, SolveContextCountsNodesAndPlacedDominos) {
+    std::vector<std::vector<int>> board{{1, 2, 3, 4},
+                                        {5, 6, 7, 8}};
+    std::vector<std::vector<int>> placement(2, std::vector<int>(4, -1));
+    std::vector<Domino> dominos{{1, 2}, {3, 4}, {5, 6}, {7, 8}};
+    SolveContext context;
+
+    EXPECT_TRUE(PuzzleSolver::solve_puzzle(board, placement, dominos, 0, 0, &context));
+    EXPECT_GT(context.nodes.load(), 0u);
+    EXPECT_EQ(context.depth.load(), 4);
+    EXPECT_EQ(context.max_depth.load(), 4);
+}
+
+TEST(PuzzleSolverTest, CancelledSolveReturnsFalseAndLeavesBoardEmpty) {
+    std::vector<std::vector<int>> board{{1, 2},
+                                        {2, 1}};
+    std::vector<std::vector<int>> placement(2, std::vector<int>(2, -1));
+    std::vector<Domino> dominos{{1, 2}, {2, 1}};
+    SolveContext context;
+    context.cancelled = true;
+
+    EXPECT_FALSE(PuzzleSolver::solve_puzzle(board, placement, dominos, 0, 0, &context));
+    EXPECT_EQ(context.nodes.load(), 1u);
+    for (const auto &row: placement) {
+        for (int cell: row) EXPECT_EQ(cell, -1);
+    }
+}
@@ -0,0 +1,123 @@
+#include <gtest/gtest.h>
+#include "rate_limiter.h"
+#include "auth_handler.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono;
+
+extern TokenStore active_tokens;
+extern TokenStore dev_keys;
+
+// Defined in test_auth_middleware.cpp.
+std::string IssueCredential(TokenStore &store, const std::string &username);
+
+TEST(RateLimiterTest, AdmitsBurstThenRefuses) {
+    RateLimiter limiter(1.0, 3.0);
+    auto now = RateLimiter::clock::now();
+    int retry_after = 0;
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_TRUE(limiter.try_acquire("key", retry_after, now));
+    }
+    EXPECT_FALSE(limiter.try_acquire("key", retry_after, now));
+    EXPECT_EQ(retry_after, 1);
+}
+
+TEST(RateLimiterTest, RefillsAtRate) {
+    RateLimiter limiter(2.0, 1.0);
+    auto now = RateLimiter::clock::now();
+    int retry_after = 0;
+    ASSERT_TRUE(limiter.try_acquire("key", retry_after, now));
+    EXPECT_FALSE(limiter.try_acquire("key", retry_after, now + milliseconds(400)));
+    EXPECT_TRUE(limiter.try_acquire("key", retry_after, now + milliseconds(500)));
+}
+
+TEST(RateLimiterTest, RetryAfterReflectsSlowRates) {
+    RateLimiter limiter(0.1, 1.0);
+    auto now = RateLimiter::clock::now();
+    int retry_after = 0;
+    ASSERT_TRUE(limiter.try_acquire("key", retry_after, now));
+    EXPECT_FALSE(limiter.try_acquire("key", retry_after, now));
+    EXPECT_EQ(retry_after, 10);
+}
+
+TEST(RateLimiterTest, KeysHaveSeparateBuckets) {
+    RateLimiter limiter(1.0, 1.0);
+    auto now = RateLimiter::clock::now();
+    int retry_after = 0;
+    ASSERT_TRUE(limiter.try_acquire("alice", retry_after, now));
+    EXPECT_FALSE(limiter.try_acquire("alice", retry_after, now));
+    EXPECT_TRUE(limiter.try_acquire("bob", retry_after, now));
+}
+
+TEST(RateLimiterTest, ConcurrentCallersNeverExceedBurst) {
+    RateLimiter limiter(0.001, 100.0);
+    std::atomic<int> admitted{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t) {
+        threads.emplace_back([&limiter, &admitted] {
+            int retry_after = 0;
+            for (int i = 0; i < 100; ++i) {
+                if (limiter.try_acquire("shared", retry_after)) ++admitted;
+            }
+        });
+    }
+    for (auto &thread: threads) thread.join();
+    EXPECT_EQ(admitted.load(), 100);
+}
+
+TEST(RateLimiterTest, MiddlewareAnswers429WithRetryAfter) {
+    ExpensiveRateLimit middleware;
+    middleware.limiter.configure(1.0, 1.0);
+    crow::request req;
+    req.add_header("Dev-Key", "some-key");
+    ExpensiveRateLimit::context ctx;
+
+    crow::response first;
+    middleware.before_handle(req, first, ctx);
+    EXPECT_FALSE(first.is_completed());
+
+    crow::response second;
+    middleware.before_handle(req, second, ctx);
+    EXPECT_TRUE(second.is_completed());
+    EXPECT_EQ(second.code, 429);
+    EXPECT_EQ(second.get_header_value("Retry-After"), "1");
+}
+
+TEST(RateLimiterTest, InventedCredentialsShareTheAddressBucket) {
+    ExpensiveRateLimit middleware;
+    middleware.limiter.configure(1.0, 1.0);
+    ExpensiveRateLimit::context ctx;
+
+    crow::request first;
+    first.remote_ip_address = "10.0.0.1";
+    first.add_header("Dev-Key", "made-up-1");
+    crow::response first_res;
+    middleware.before_handle(first, first_res, ctx);
+    EXPECT_FALSE(first_res.is_completed());
+
+    crow::request second;
+    second.remote_ip_address = "10.0.0.1";
+    second.add_header("Authorization", "made-up-2");
+    crow::response second_res;
+    middleware.before_handle(second, second_res, ctx);
+    EXPECT_EQ(second_res.code, 429);
+}
+
+TEST(RateLimiterTest, VerifiedCredentialsGetTheirOwnBucket) {
+    std::string dev_key = IssueCredential(dev_keys, "carol");
+    crow::request req;
+    req.remote_ip_address = "10.0.0.2";
+    req.add_header("Dev-Key", dev_key);
+    EXPECT_EQ(rate_limit_key(req), "dev_key:" + dev_key);
+
+    crow::request with_token;
+    with_token.remote_ip_address = "10.0.0.2";
+    with_token.add_header("Authorization", IssueCredential(active_tokens, "carol"));
+    EXPECT_EQ(rate_limit_key(with_token), "user:carol");
+
+    crow::request anonymous;
+    anonymous.remote_ip_address = "10.0.0.2";
+    EXPECT_EQ(rate_limit_key(anonymous), "10.0.0.2");
+}
@@ -0,0 +1,58 @@
+#include <gtest/gtest.h>
+#include "server_config.h"
+#include <map>
+
+// An environment holding only @p vars.
+static std::function<const char *(const char *)> FakeEnv(const std::map<std::string, std::string> &vars) {
+    return [vars](const char *name) -> const char * {
+        auto it = vars.find(name);
+        return it == vars.end() ? nullptr : it->second.c_str();
+    };
+}
+
+TEST(ServerConfigTest, DefaultsWithoutFlagsOrEnvironment) {
+    const char *argv[] = {"server"};
+    ServerConfig config;
+    std::string error;
+
+    ASSERT_TRUE(load_server_config(1, argv, config, error, FakeEnv({}))) << error;
+    EXPECT_EQ(config.port, 18080);
+    EXPECT_EQ(config.io_threads, 0u);
+    EXPECT_EQ(config.compute_threads, 0u);
+    EXPECT_EQ(config.compute_queue, 256u);
+    EXPECT_EQ(config.drain_seconds, 30u);
+}
+
+TEST(ServerConfigTest, FlagsOverrideTheEnvironment) {
+    const char *argv[] = {"server", "--port=9000", "--compute-threads", "6", "--hashing-queue=32", "--drain-seconds=0"};
+    ServerConfig config;
+    std::string error;
+
+    ASSERT_TRUE(load_server_config(6, argv, config, error,
+                                   FakeEnv({{"DOMINOREST_PORT", "8000"}, {"DOMINOREST_IO_THREADS", "3"},
+                                            {"DOMINOREST_COMPUTE_THREADS", "2"}}))) << error;
+    EXPECT_EQ(config.port, 9000);
+    EXPECT_EQ(config.io_threads, 3u);
+    EXPECT_EQ(config.compute_threads, 6u);
+    EXPECT_EQ(config.hashing_queue, 32u);
+    EXPECT_EQ(config.drain_seconds, 0u);
+}
+
+TEST(ServerConfigTest, RejectsUnknownFlagsAndBadValues) {
+    ServerConfig config;
+    std::string error;
+
+    const char *unknown[] = {"server", "--threads=4"};
+    EXPECT_FALSE(load_server_config(2, unknown, config, error, FakeEnv({})));
+    EXPECT_NE(error.find("--threads=4"), std::string::npos);
+
+    const char *zero[] = {"server", "--compute-threads=0"};
+    EXPECT_FALSE(load_server_config(2, zero, config, error, FakeEnv({})));
+
+    const char *missing[] = {"server", "--port"};
+    EXPECT_FALSE(load_server_config(2, missing, config, error, FakeEnv({})));
+
+    const char *argv[] = {"server"};
+    EXPECT_FALSE(load_server_config(1, argv, config, error, FakeEnv({{"DOMINOREST_PORT", "70000"}})));
+    EXPECT_FALSE(load_server_config(1, argv, config, error, FakeEnv({{"DOMINOREST_IO_THREADS", "4x"}})));
+}
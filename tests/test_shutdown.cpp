@@ -0,0 +1,79 @@
+#include <gtest/gtest.h>
+#include "shutdown.h"
+#include "http_test_client.h"
+#include <atomic>
+#include <string>
+#include <vector>
+
+using std::chrono::milliseconds;
+
+// Short timeouts, so a test that waits out a phase still runs in well under a second.
+static DrainTimeouts TestTimeouts() {
+    DrainTimeouts timeouts;
+    timeouts.grace = milliseconds(100);
+    timeouts.cancelled = milliseconds(100);
+    timeouts.flush = milliseconds(50);
+    return timeouts;
+}
+
+// Steps that record what drain() did; cancelling finishes the work when @p cancel_finishes.
+struct FakeServer {
+    std::vector<std::string> calls;
+    std::atomic<size_t> in_flight{0};
+    bool cancel_finishes = true;
+
+    DrainSteps steps() {
+        return {[this] { calls.push_back("stop_accepting"); },
+                [this] { return in_flight.load(); },
+                [this] {
+                    calls.push_back("cancel");
+                    size_t running = in_flight.load();
+                    if (cancel_finishes) in_flight = 0;
+                    return running;
+                },
+                [] { return size_t(0); },
+                [this] { calls.push_back("stop"); }};
+    }
+};
+
+TEST(ShutdownTest, WaitUntilReportsWhetherTheConditionHeld) {
+    int polls = 0;
+    EXPECT_TRUE(wait_until([&polls] { return ++polls == 3; }, milliseconds(1000), milliseconds(1)));
+    EXPECT_EQ(polls, 3);
+    EXPECT_FALSE(wait_until([] { return false; }, milliseconds(10), milliseconds(1)));
+}
+
+TEST(ShutdownTest, WorkFinishingInTimeIsNotCancelled) {
+    FakeServer server;
+    EXPECT_TRUE(drain(server.steps(), TestTimeouts()));
+    EXPECT_EQ(server.calls, (std::vector<std::string>{"stop_accepting", "stop"}));
+}
+
+TEST(ShutdownTest, SolvesRunningPastTheGracePeriodAreCancelled) {
+    FakeServer server;
+    server.in_flight = 2;
+
+    EXPECT_TRUE(drain(server.steps(), TestTimeouts()));
+    EXPECT_EQ(server.calls, (std::vector<std::string>{"stop_accepting", "cancel", "stop"}));
+}
+
+TEST(ShutdownTest, StopsEvenIfWorkNeverFinishes) {
+    FakeServer server;
+    server.in_flight = 1;
+    server.cancel_finishes = false;
+
+    EXPECT_FALSE(drain(server.steps(), TestTimeouts()));
+    EXPECT_EQ(server.calls.back(), "stop");
+}
+
+TEST(ShutdownTest, OpenConnectionsCountsEveryIoThreadAndDropsAsTheyClose) {
+    crow::SimpleApp app;
+    CROW_ROUTE(app, "/")([] { return "ok"; });
+    TestServer<crow::SimpleApp> server(app, 2);
+
+    std::vector<int> open;
+    for (int i = 0; i < 3; ++i) open.push_back(connect_local(server.port()));
+    EXPECT_TRUE(wait_until([&app] { return app.open_connections() == 3; }, milliseconds(2000)));
+    for (int fd: open) close(fd);
+    EXPECT_TRUE(wait_until([&app] { return app.open_connections() == 0; }, milliseconds(2000)));
+}
@@ -0,0 +1,96 @@
+#include <gtest/gtest.h>
+#include "signed_token.h"
+#include "auth_handler.h"
+
+using namespace std::chrono;
+
+const seconds MAX_LIFETIME(3600);
+
+TEST(SignedTokenTest, IssuedTokenVerifies) {
+    TokenSigner signer(7, "secret", MAX_LIFETIME);
+    auto expires = system_clock::now() + minutes(5);
+    std::string token = signer.issue(TokenKind::Session, "alice.smith", expires);
+
+    TokenClaims claims;
+    ASSERT_TRUE(signer.verify(token, TokenKind::Session, claims));
+    EXPECT_EQ(claims.username, "alice.smith");
+    EXPECT_EQ(claims.key_id, 7u);
+    EXPECT_EQ(claims.expires, duration_cast<seconds>(expires.time_since_epoch()).count());
+}
+
+TEST(SignedTokenTest, AnotherInstanceWithTheSameSecretAccepts) {
+    TokenSigner issuer(1, "shared", MAX_LIFETIME);
+    TokenSigner verifier(1, "shared", MAX_LIFETIME);
+    TokenSigner stranger(1, "other", MAX_LIFETIME);
+    std::string token = issuer.issue(TokenKind::Session, "alice", system_clock::now() + minutes(5));
+
+    TokenClaims claims;
+    EXPECT_TRUE(verifier.verify(token, TokenKind::Session, claims));
+    EXPECT_FALSE(stranger.verify(token, TokenKind::Session, claims));
+}
+
+TEST(SignedTokenTest, RejectsTamperedExpiredAndWrongKind) {
+    TokenSigner signer(1, "secret", MAX_LIFETIME);
+    auto now = system_clock::now();
+    std::string token = signer.issue(TokenKind::Session, "alice", now + minutes(5));
+    TokenClaims claims;
+
+    std::string tampered = signer.issue(TokenKind::Session, "mallory", now + minutes(5));
+    tampered = tampered.substr(0, tampered.find('.')) + token.substr(token.find('.'));
+    EXPECT_FALSE(signer.verify(tampered, TokenKind::Session, claims));
+
+    EXPECT_FALSE(signer.verify(token, TokenKind::Session, claims, now + minutes(6)));
+    EXPECT_FALSE(signer.verify(token, TokenKind::DevKey, claims));
+    EXPECT_FALSE(signer.verify("", TokenKind::Session, claims));
+    EXPECT_FALSE(signer.verify("a.b", TokenKind::Session, claims));
+}
+
+TEST(SignedTokenTest, PreviousKeyStillVerifiesAfterRotation) {
+    TokenSigner old_signer(1, "old", MAX_LIFETIME);
+    std::string token = old_signer.issue(TokenKind::DevKey, "alice", system_clock::now() + minutes(5));
+
+    TokenSigner signer(2, "new", MAX_LIFETIME);
+    TokenClaims claims;
+    EXPECT_FALSE(signer.verify(token, TokenKind::DevKey, claims));
+    signer.add_verification_key(1, "old");
+    EXPECT_TRUE(signer.verify(token, TokenKind::DevKey, claims));
+}
+
+TEST(SignedTokenTest, RevokedTokenIsRejected) {
+    TokenSigner signer(1, "secret", MAX_LIFETIME);
+    std::string token = signer.issue(TokenKind::Session, "alice", system_clock::now() + minutes(5));
+    std::string other = signer.issue(TokenKind::Session, "bob", system_clock::now() + minutes(5));
+
+    ASSERT_TRUE(signer.revoke(token));
+    TokenClaims claims;
+    EXPECT_FALSE(signer.verify(token, TokenKind::Session, claims));
+    EXPECT_TRUE(signer.verify(other, TokenKind::Session, claims));
+    EXPECT_FALSE(signer.revoke("not-a-token"));
+}
+
+TEST(SignedTokenTest, AuthRoutesIssueSignedCredentials) {
+    use_signed_tokens(1, "secret");
+
+    crow::request reg;
+    reg.body = R"({"username":"signeduser","password":"password"})";
+    register_route(reg);
+    auto login = login_route(reg);
+    ASSERT_EQ(login.code, 200);
+    std::string token = crow::json::load(login.body)["token"].s();
+    EXPECT_NE(token.find('.'), std::string::npos);
+    EXPECT_TRUE(authenticate(token));
+
+    crow::request req;
+    req.add_header("Authorization", token);
+    auto dev = create_dev_key_route(req);
+    ASSERT_EQ(dev.code, 200);
+    std::string dev_key = crow::json::load(dev.body)["dev_key"].s();
+    EXPECT_TRUE(verifyDevKey(dev_key));
+    EXPECT_FALSE(authenticate(dev_key));
+
+    EXPECT_EQ(logout_route(req).code, 200);
+    EXPECT_FALSE(authenticate(token));
+    EXPECT_EQ(logout_route(req).code, 401);
+
+    use_signed_tokens(0, "");
+}
@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+#include "solve_channel.h"
+#include "board_codec.h"
+
+TEST(SolveChannelTest, ParsesTextSolveRequests) {
+    ChannelRequest request;
+    std::string error;
+
+    ASSERT_TRUE(parse_channel_frame("{\"id\":7,\"board\":[[0,1],[1,0]]}", false, request, error)) << error;
+    EXPECT_EQ(request.id, "7");
+    EXPECT_FALSE(request.binary);
+    EXPECT_FALSE(request.cancel);
+    EXPECT_EQ(request.board.rows, 2);
+    EXPECT_EQ(request.board.cols, 2);
+    EXPECT_EQ(request.board.at(0, 1), 1);
+}
+
+TEST(SolveChannelTest, KeepsStringIdsAsEscapedJson) {
+    ChannelRequest request;
+    std::string error;
+
+    ASSERT_TRUE(parse_channel_frame("{\"id\":\"a\\\"b\",\"cancel\":true}", false, request, error)) << error;
+    EXPECT_EQ(request.id, "\"a\\\"b\"");
+    EXPECT_TRUE(request.cancel);
+}
+
+TEST(SolveChannelTest, RejectsMalformedTextFrames) {
+    ChannelRequest request;
+    std::string error;
+
+    EXPECT_FALSE(parse_channel_frame("[[0,1]]", false, request, error));
+    EXPECT_FALSE(parse_channel_frame("{\"id\":1.5,\"board\":[[0,1]]}", false, request, error));
+
+    ChannelRequest ragged;
+    EXPECT_FALSE(parse_channel_frame("{\"id\":3,\"board\":[[0,1],[1]]}", false, ragged, error));
+    EXPECT_EQ(ragged.id, "3"); // still known, so the error can name it
+}
+
+TEST(SolveChannelTest, ParsesBinaryFramesAndAnswersWithTheSameId) {
+    FlatBoard board;
+    ASSERT_TRUE(flatten_board({{0, 0, 1},
+                               {1, 1, 0}}, board));
+    std::string frame("\x00\x01\x02\x03", 4);
+    frame += encode_packed_board(board);
+
+    ChannelRequest request;
+    std::string error;
+    ASSERT_TRUE(parse_channel_frame(frame, true, request, error)) << error;
+    EXPECT_TRUE(request.binary);
+    EXPECT_EQ(request.binary_id, 0x00010203u);
+    EXPECT_EQ(request.id, std::to_string(0x00010203));
+    EXPECT_EQ(request.board.pips, board.pips);
+
+    SolveResult result = solve_board(request.board);
+    std::string reply = channel_packed_result_frame(request.binary_id, request.board, result);
+    EXPECT_EQ(reply.compare(0, 4, frame, 0, 4), 0);
+
+    FlatBoard decoded;
+    std::vector<unsigned char> directions;
+    BoardParseError decode_error;
+    ASSERT_TRUE(decode_packed_board(reply.data() + 4, reply.size() - 4, decoded, decode_error, &directions));
+    EXPECT_EQ(directions, placement_directions(result.placement));
+    EXPECT_NE(static_cast<unsigned char>(reply[4 + 3]) & PACKED_SOLVED, 0);
+}
+
+TEST(SolveChannelTest, RejectsBinaryFramesWithoutAnId) {
+    ChannelRequest request;
+    std::string error;
+
+    EXPECT_FALSE(parse_channel_frame(std::string("\x00\x01", 2), true, request, error));
+    EXPECT_TRUE(request.id.empty());
+}
+
+TEST(SolveChannelTest, FramesCarryTheRequestId) {
+    SolveResult result;
+    result.placement = {{0, 0}};
+    result.solved = true;
+
+    EXPECT_EQ(channel_result_frame("\"x\"", result),
+              "{\"id\":\"x\",\"type\":\"result\",\"status\":\"solved\",\"rows\":1,\"cols\":2,"
+              "\"placement\":[[0,0]],\"solve_seconds\":0.00000000}");
+
+    SolveContext context;
+    context.nodes = 42;
+    context.depth = 3;
+    context.max_depth = 5;
+    EXPECT_EQ(channel_progress_frame("9", context),
+              "{\"id\":9,\"type\":\"progress\",\"nodes\":42,\"depth\":3,\"max_depth\":5}");
+
+    EXPECT_EQ(channel_error_frame("9", "Too \"many\"", 4),
+              "{\"id\":9,\"type\":\"error\",\"message\":\"Too \\\"many\\\"\",\"retry_after\":4}");
+}
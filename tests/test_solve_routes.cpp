@@ -0,0 +1,80 @@
+#include <gtest/gtest.h>
+#include "solve_routes.h"
+#include "board_codec.h"
+
+// A request for /solve from an authenticated caller, with @p query appended to the URL.
+static crow::request SolveRequest(const std::string &query = "") {
+    crow::request req;
+    req.method = crow::HTTPMethod::Post;
+    req.url = "/solve";
+    req.url_params = crow::query_string("/solve" + query);
+    req.body = "[[0,0,1],[1,1,0]]";
+    return req;
+}
+
+static AuthMiddleware::context Caller() {
+    AuthMiddleware::context auth;
+    auth.username = "solve_routes_test";
+    return auth;
+}
+
+// Answers @p req, failing if it was handed to a solve already running instead.
+static crow::response Solve(const crow::request &req) {
+    std::optional<crow::response> answer =
+            solve_route(req, Caller(), [](crow::response) { ADD_FAILURE() << "no identical solve was running"; });
+    EXPECT_TRUE(answer.has_value());
+    return answer ? std::move(*answer) : crow::response(500);
+}
+
+TEST(SolveRoutesTest, AnswersJsonByDefault) {
+    crow::response res = Solve(SolveRequest());
+
+    EXPECT_EQ(res.code, 200);
+    EXPECT_EQ(res.get_header_value("Content-Type"), "application/json");
+    EXPECT_EQ(res.body.compare(0, 19, "{\"status\":\"solved\","), 0) << res.body;
+}
+
+TEST(SolveRoutesTest, FormatTextAnswersTheAsciiRendering) {
+    crow::response res = Solve(SolveRequest("?format=text"));
+
+    EXPECT_EQ(res.code, 200);
+    EXPECT_EQ(res.body.compare(0, 32, "Domino Board:\n"
+                                      "+---+---+---+\n"
+                                      "| 0 "), 0) << res.body;
+    EXPECT_NE(res.body.find("\nSolution:\n"), std::string::npos) << res.body;
+}
+
+TEST(SolveRoutesTest, AcceptOctetStreamAnswersThePackedSolution) {
+    crow::request req = SolveRequest();
+    req.add_header("Accept", PACKED_BOARD_MIME);
+
+    crow::response res = Solve(req);
+
+    EXPECT_EQ(res.code, 200);
+    EXPECT_EQ(res.get_header_value("Content-Type"), PACKED_BOARD_MIME);
+    FlatBoard board;
+    BoardParseError error;
+    std::vector<unsigned char> directions;
+    ASSERT_TRUE(decode_packed_board(res.body, board, error, &directions)) << error.message;
+    EXPECT_EQ(board.rows, 2);
+    EXPECT_EQ(board.cols, 3);
+    EXPECT_EQ(directions.size(), 6u);
+    EXPECT_NE(static_cast<unsigned char>(res.body[3]) & PACKED_SOLVED, 0);
+}
+
+TEST(SolveRoutesTest, FormatParameterOverridesAccept) {
+    crow::request req = SolveRequest("?format=json");
+    req.add_header("Accept", PACKED_BOARD_MIME);
+
+    crow::response res = Solve(req);
+
+    EXPECT_EQ(res.code, 200);
+    EXPECT_EQ(res.get_header_value("Content-Type"), "application/json");
+}
+
+TEST(SolveRoutesTest, UnknownFormatIsRejected) {
+    crow::response res = Solve(SolveRequest("?format=yaml"));
+
+    EXPECT_EQ(res.code, 400);
+    EXPECT_EQ(res.body, "Bad Request: 'format' must be 'json' or 'text'.");
+}
@@ -0,0 +1,190 @@
+#include <gtest/gtest.h>
+#include "solve_service.h"
+#include "board_generator.h"
+#include <atomic>
+#include <future>
+#include <stdexcept>
+#include <thread>
+
+TEST(SolveServiceTest, SolvesBoardWithItsFullDominoSet) {
+    FlatBoard board;
+    ASSERT_TRUE(flatten_board({{0, 0, 1},
+                               {1, 1, 0}}, board));
+
+    SolveResult result = solve_board(board);
+
+    EXPECT_TRUE(result.solved);
+    EXPECT_FALSE(result.cancelled);
+    EXPECT_EQ(result.max_pips, 1);
+    EXPECT_EQ(result.dominos.size(), 6u); // pips 0 to 2, as generate_dominos(max_pips + 1) builds it
+    EXPECT_EQ(result.placement.size(), 2u);
+}
+
+TEST(SolveServiceTest, ReportsCancelledSolves) {
+    FlatBoard board;
+    ASSERT_TRUE(flatten_board({{0, 0, 1},
+                               {1, 1, 0}}, board));
+    SolveContext context;
+    context.cancelled = true;
+
+    SolveResult result = solve_board(board, &context);
+
+    EXPECT_FALSE(result.solved);
+    EXPECT_TRUE(result.cancelled);
+}
+
+TEST(SolveServiceTest, CancelAllCancelsRunningAndLaterSolves) {
+    RunningSolves solves;
+    SolveContext running, finished, later;
+    solves.add(&running);
+    solves.add(&finished);
+    solves.remove(&finished);
+
+    EXPECT_EQ(solves.cancel_all(), 1u);
+    EXPECT_TRUE(running.cancelled.load());
+    EXPECT_FALSE(finished.cancelled.load());
+
+    solves.add(&later);
+    EXPECT_TRUE(later.cancelled.load());
+    EXPECT_EQ(solves.size(), 2u);
+}
+
+TEST(SolveServiceTest, SolvesAreRegisteredWhileRunning) {
+    FlatBoard board;
+    ASSERT_TRUE(flatten_board(generate_board(40, 40), board)); // far too large to finish
+    SolveContext context;
+    auto solving = std::async(std::launch::async, [&] { return solve_board(board, &context); });
+
+    while (running_solves().size() == 0) std::this_thread::yield();
+    context.cancelled = true;
+    SolveResult result = solving.get();
+
+    EXPECT_TRUE(result.cancelled);
+    EXPECT_EQ(running_solves().size(), 0u);
+}
+
+TEST(SolveServiceTest, SolutionJsonListsPlacementOnlyWhenSolved) {
+    EXPECT_EQ(solution_json({{0, 0}, {1, 1}}, true, 0.5),
+              "{\"status\":\"solved\",\"rows\":2,\"cols\":2,\"placement\":[[0,0],[1,1]],\"solve_seconds\":0.50000000}");
+    EXPECT_EQ(solution_json({{-1, -1}}, false, 0),
+              "{\"status\":\"unsolved\",\"rows\":1,\"cols\":2,\"solve_seconds\":0.00000000}");
+}
+
+TEST(SolveServiceTest, BoardHashCoversDimensionsAndPips) {
+    FlatBoard wide, tall, other;
+    ASSERT_TRUE(flatten_board({{0, 1, 1, 0}}, wide));
+    ASSERT_TRUE(flatten_board({{0, 1}, {1, 0}}, tall));
+    ASSERT_TRUE(flatten_board({{0, 1, 1, 1}}, other));
+
+    EXPECT_NE(board_hash(wide), board_hash(tall));
+    EXPECT_NE(board_hash(wide), board_hash(other));
+    EXPECT_EQ(board_hash(wide), board_hash(wide));
+}
+
+TEST(SolveServiceTest, ConcurrentIdenticalBoardsShareOneSolve) {
+    std::atomic<int> solves{0};
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    SolveFlights flights([&solves, released](const FlatBoard &board, SolveContext *context) {
+        ++solves;
+        released.wait();
+        return solve_board(board, context);
+    });
+    FlatBoard board;
+    ASSERT_TRUE(flatten_board({{0, 0, 1},
+                               {1, 1, 0}}, board));
+
+    auto leader = std::async(std::launch::async, [&flights, &board] { return flights.solve(board); });
+    while (flights.in_flight() == 0) std::this_thread::yield();
+
+    std::vector<std::future<std::shared_ptr<const SolveResult>>> followers;
+    for (int i = 0; i < 3; ++i) {
+        followers.push_back(std::async(std::launch::async, [&flights, &board] {
+            bool joined = false;
+            auto result = flights.solve(board, &joined);
+            EXPECT_TRUE(joined);
+            return result;
+        }));
+    }
+    while (flights.joined() < 3) std::this_thread::yield();
+    release.set_value();
+
+    std::shared_ptr<const SolveResult> result = leader.get();
+    EXPECT_TRUE(result->solved);
+    for (auto &follower: followers) EXPECT_EQ(follower.get(), result);
+    EXPECT_EQ(solves.load(), 1);
+    EXPECT_EQ(flights.in_flight(), 0u);
+}
+
+TEST(SolveServiceTest, JoiningReturnsAtOnceAndLandsOnTheLeadersThread) {
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    SolveFlights flights([released](const FlatBoard &board, SolveContext *context) {
+        released.wait();
+        return solve_board(board, context);
+    });
+    FlatBoard board;
+    ASSERT_TRUE(flatten_board({{0, 0, 1},
+                               {1, 1, 0}}, board));
+
+    std::thread::id leader_thread;
+    auto leader = std::async(std::launch::async, [&flights, &board, &leader_thread] {
+        leader_thread = std::this_thread::get_id();
+        return flights.solve(board);
+    });
+    while (flights.in_flight() == 0) std::this_thread::yield();
+
+    std::promise<std::thread::id> landed_on;
+    std::shared_ptr<const SolveResult> landed;
+    std::shared_ptr<const SolveResult> joined = flights.solve_or_join(
+            board, [&](std::shared_ptr<const SolveResult> result, std::exception_ptr error) {
+                EXPECT_FALSE(error);
+                landed = result;
+                landed_on.set_value(std::this_thread::get_id());
+            });
+    EXPECT_EQ(joined, nullptr);
+    release.set_value();
+
+    std::shared_ptr<const SolveResult> result = leader.get();
+    EXPECT_EQ(landed_on.get_future().get(), leader_thread);
+    EXPECT_EQ(landed, result);
+}
+
+TEST(SolveServiceTest, FinishedFlightsAreNotReused) {
+    int solves = 0;
+    SolveFlights flights([&solves](const FlatBoard &board, SolveContext *context) {
+        ++solves;
+        return solve_board(board, context);
+    });
+    FlatBoard board;
+    ASSERT_TRUE(flatten_board({{0, 0, 1},
+                               {1, 1, 0}}, board));
+
+    bool joined = true;
+    flights.solve(board, &joined);
+    EXPECT_FALSE(joined);
+    flights.solve(board, &joined);
+    EXPECT_FALSE(joined);
+    EXPECT_EQ(solves, 2);
+}
+
+TEST(SolveServiceTest, FollowersReceiveTheLeadersFailure) {
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    SolveFlights flights([released](const FlatBoard &, SolveContext *) -> SolveResult {
+        released.wait();
+        throw std::runtime_error("solver failed");
+    });
+    FlatBoard board;
+    ASSERT_TRUE(flatten_board({{0, 1}}, board));
+
+    auto leader = std::async(std::launch::async, [&flights, &board] { return flights.solve(board); });
+    while (flights.in_flight() == 0) std::this_thread::yield();
+    auto follower = std::async(std::launch::async, [&flights, &board] { return flights.solve(board); });
+    while (flights.joined() < 1) std::this_thread::yield();
+    release.set_value();
+
+    EXPECT_THROW(leader.get(), std::runtime_error);
+    EXPECT_THROW(follower.get(), std::runtime_error);
+    EXPECT_EQ(flights.in_flight(), 0u);
+}
@@ -0,0 +1,117 @@
+#include <gtest/gtest.h>
+#include "sharded_map.h"
+#include "token_store.h"
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono;
+
+TokenKey MakeKey(unsigned char seed) {
+    TokenKey key{};
+    for (size_t i = 0; i < key.size(); ++i) key[i] = static_cast<unsigned char>(seed * 31 + i);
+    return key;
+}
+
+TEST(ShardedMapTest, InsertFindErase) {
+    ShardedMap<std::string, int> map;
+    EXPECT_TRUE(map.insert("a", 1));
+    EXPECT_FALSE(map.insert("a", 2));
+
+    int value = 0;
+    ASSERT_TRUE(map.find("a", value));
+    EXPECT_EQ(value, 1);
+    EXPECT_FALSE(map.find("b", value));
+
+    map.assign("a", 3);
+    ASSERT_TRUE(map.find("a", value));
+    EXPECT_EQ(value, 3);
+
+    EXPECT_TRUE(map.erase("a"));
+    EXPECT_FALSE(map.contains("a"));
+    EXPECT_EQ(map.size(), 0);
+}
+
+TEST(ShardedMapTest, ConcurrentInsertsOfOneKeyHaveOneWinner) {
+    ShardedMap<std::string, int> map;
+    std::atomic<int> winners{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t) {
+        threads.emplace_back([&map, &winners, t] {
+            for (int i = 0; i < 1000; ++i) {
+                if (map.insert("user" + std::to_string(i), t)) ++winners;
+            }
+        });
+    }
+    for (auto &thread: threads) thread.join();
+    EXPECT_EQ(winners.load(), 1000);
+    EXPECT_EQ(map.size(), 1000);
+}
+
+TEST(TokenStoreTest, EntriesWithoutTtlNeverExpire) {
+    TokenStore store;
+    auto now = TokenStore::clock::now();
+    store.insert(MakeKey(1), "alice", now);
+
+    std::string username;
+    ASSERT_TRUE(store.find(MakeKey(1), username, now + hours(24 * 365)));
+    EXPECT_EQ(username, "alice");
+    EXPECT_FALSE(store.contains(MakeKey(2), now));
+}
+
+TEST(TokenStoreTest, LookupsRejectExpiredEntries) {
+    TokenStore store(minutes(10));
+    auto now = TokenStore::clock::now();
+    store.insert(MakeKey(1), "alice", now);
+
+    EXPECT_TRUE(store.contains(MakeKey(1), now + minutes(9)));
+    EXPECT_FALSE(store.contains(MakeKey(1), now + minutes(10)));
+}
+
+TEST(TokenStoreTest, ExpireReclaimsOnlyDueEntries) {
+    TokenStore store(minutes(10));
+    auto now = TokenStore::clock::now();
+    store.insert(MakeKey(1), "alice", now);
+    store.insert(MakeKey(2), "bob", now + minutes(5));
+
+    store.expire(now + minutes(9));
+    EXPECT_EQ(store.size(), 2);
+
+    store.expire(now + minutes(11));
+    EXPECT_EQ(store.size(), 1);
+    EXPECT_TRUE(store.contains(MakeKey(2), now + minutes(11)));
+
+    store.expire(now + minutes(16));
+    EXPECT_EQ(store.size(), 0);
+}
+
+TEST(TokenStoreTest, ReinsertExtendsLifetime) {
+    TokenStore store(minutes(10));
+    auto now = TokenStore::clock::now();
+    store.insert(MakeKey(1), "alice", now);
+    store.insert(MakeKey(1), "alice", now + minutes(8));
+
+    store.expire(now + minutes(11));
+    EXPECT_TRUE(store.contains(MakeKey(1), now + minutes(11)));
+
+    store.expire(now + minutes(19));
+    EXPECT_EQ(store.size(), 0);
+}
+
+TEST(TokenStoreTest, ExpireAfterLongIdleReclaimsEverything) {
+    TokenStore store(seconds(30));
+    auto now = TokenStore::clock::now();
+    for (unsigned char i = 0; i < 100; ++i) store.insert(MakeKey(i), "user", now);
+
+    store.expire(now + hours(24));
+    EXPECT_EQ(store.size(), 0);
+}
+
+TEST(TokenStoreTest, EraseRemovesEntry) {
+    TokenStore store(minutes(10));
+    store.insert(MakeKey(1), "alice");
+    EXPECT_TRUE(store.erase(MakeKey(1)));
+    EXPECT_FALSE(store.erase(MakeKey(1)));
+    EXPECT_FALSE(store.contains(MakeKey(1)));
+}
@@ -41,3 +41,23 @@ TEST(FindMaxPipsTest, SingleColumnBoard) {
     };
     EXPECT_EQ(find_max_pips(board), 6); // Expect 6 on a single column
 }
+
+TEST(Fnv1aTest, MatchesReferenceValues) {
+    EXPECT_EQ(fnv1a("", 0), 0xcbf29ce484222325ULL);
+    EXPECT_EQ(fnv1a("a", 1), 0xaf63dc4c8601ec8cULL);
+}
+
+TEST(Fnv1aTest, ChainsAcrossCalls) {
+    EXPECT_EQ(fnv1a("b", 1, fnv1a("a", 1)), fnv1a("ab", 2));
+    unsigned char little_endian[4] = {0x04, 0x03, 0x02, 0x01};
+    EXPECT_EQ(fnv1a(static_cast<uint32_t>(0x01020304)), fnv1a(little_endian, 4));
+}
+
+TEST(DecimalWidthTest, CountsDigitsAndSign) {
+    EXPECT_EQ(decimal_width(0), 1u);
+    EXPECT_EQ(decimal_width(9), 1u);
+    EXPECT_EQ(decimal_width(10), 2u);
+    EXPECT_EQ(decimal_width(-5), 2u);
+    EXPECT_EQ(decimal_width(2147483647), 10u);
+    EXPECT_EQ(decimal_width(-2147483647 - 1), 11u);
+}
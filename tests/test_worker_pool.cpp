@@ -0,0 +1,81 @@
+#include <gtest/gtest.h>
+#include "worker_pool.h"
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <thread>
+
+// Blocks the pool's only thread until the returned promise is fulfilled.
+std::shared_ptr<std::promise<void>> OccupyPool(WorkerPool &pool) {
+    auto release = std::make_shared<std::promise<void>>();
+    std::shared_future<void> released = release->get_future().share();
+    EXPECT_TRUE(pool.submit([released] { released.wait(); }));
+    while (pool.running() == 0) std::this_thread::yield();
+    return release;
+}
+
+void WaitForCompletion(const crow::response &res) {
+    for (int i = 0; i < 1000 && !res.is_completed(); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+TEST(WorkerPoolTest, RunsEverySubmittedTask) {
+    std::atomic<int> done{0};
+    {
+        WorkerPool pool("test", 2, 16);
+        for (int i = 0; i < 10; ++i) {
+            ASSERT_TRUE(pool.submit([&done] { ++done; }));
+        }
+    } // the destructor drains the queue
+    EXPECT_EQ(done.load(), 10);
+}
+
+TEST(WorkerPoolTest, RejectsWhenQueueIsFull) {
+    WorkerPool pool("test", 1, 1);
+    auto release = OccupyPool(pool);
+
+    EXPECT_TRUE(pool.submit([] {}));
+    EXPECT_EQ(pool.queue_depth(), 1);
+    EXPECT_FALSE(pool.submit([] {}));
+
+    release->set_value();
+}
+
+TEST(WorkerPoolTest, RespondFromPoolCompletesResponse) {
+    WorkerPool pool("test", 1, 4);
+    crow::request req;
+    crow::response res;
+    respond_from_pool(pool, req, res, [] { return crow::response(201, "created"); });
+    WaitForCompletion(res);
+
+    ASSERT_TRUE(res.is_completed());
+    EXPECT_EQ(res.code, 201);
+    EXPECT_EQ(res.body, "created");
+}
+
+TEST(WorkerPoolTest, RespondFromPoolShedsLoadWith503) {
+    WorkerPool pool("test", 1, 1);
+    auto release = OccupyPool(pool);
+    ASSERT_TRUE(pool.submit([] {}));
+
+    crow::request req;
+    crow::response res;
+    respond_from_pool(pool, req, res, [] { return crow::response(200); });
+    EXPECT_TRUE(res.is_completed());
+    EXPECT_EQ(res.code, 503);
+    EXPECT_EQ(res.get_header_value("Retry-After"), "1");
+
+    release->set_value();
+}
+
+TEST(WorkerPoolTest, RespondFromPoolTurnsExceptionsInto500) {
+    WorkerPool pool("test", 1, 4);
+    crow::request req;
+    crow::response res;
+    respond_from_pool(pool, req, res, []() -> crow::response { throw std::runtime_error("boom"); });
+    WaitForCompletion(res);
+
+    ASSERT_TRUE(res.is_completed());
+    EXPECT_EQ(res.code, 500);
+}
@@ -0,0 +1,124 @@
+#include "token_store.h"
+
+#include <algorithm>
+#include <mutex>
+
+/**
+ * @file token_store.cpp
+ * @brief Implementation of the sharded, expiring credential store.
+ */
+
+TokenStore::TokenStore(clock::duration ttl)
+        : ttl_(ttl),
+          // The wheel spans two lifetimes, so every entry lands within one revolution.
+          tick_(std::max<clock::duration>(std::chrono::seconds(1), ttl / (WHEEL_SLOTS / 2))) {}
+
+TokenStore::Shard &TokenStore::shard_for(const TokenKey &key) {
+    // Byte 8 is not part of TokenKeyHash, so the shard choice does not skew per-shard buckets.
+    return shards_[key[8] % SHARD_COUNT];
+}
+
+const TokenStore::Shard &TokenStore::shard_for(const TokenKey &key) const {
+    return shards_[key[8] % SHARD_COUNT];
+}
+
+int64_t TokenStore::tick_of(clock::time_point when) const {
+    return static_cast<int64_t>(when.time_since_epoch() / tick_);
+}
+
+void TokenStore::schedule(Shard &shard, const TokenKey &key, clock::time_point expires) {
+    if (shard.wheel.empty()) shard.wheel.resize(WHEEL_SLOTS);
+    // First tick that starts at or after the expiry time; by then the entry is due.
+    int64_t due = tick_of(expires) + 1;
+    shard.wheel[static_cast<size_t>(due) % WHEEL_SLOTS].push_back(key);
+}
+
+void TokenStore::advance(Shard &shard, clock::time_point now) {
+    int64_t now_tick = tick_of(now);
+    if (shard.wheel_tick < 0 || shard.wheel.empty()) {
+        shard.wheel_tick = now_tick;
+        return;
+    }
+    if (now_tick <= shard.wheel_tick) return;
+
+    // After a long idle period, one pass over every slot is enough.
+    int64_t first = std::max(shard.wheel_tick + 1, now_tick - static_cast<int64_t>(WHEEL_SLOTS) + 1);
+    std::vector<TokenKey> due;
+    for (int64_t tick = first; tick <= now_tick; ++tick) {
+        auto &slot = shard.wheel[static_cast<size_t>(tick) % WHEEL_SLOTS];
+        due.insert(due.end(), slot.begin(), slot.end());
+        slot.clear();
+    }
+    shard.wheel_tick = now_tick;
+
+    for (const TokenKey &key: due) {
+        auto it = shard.entries.find(key);
+        if (it == shard.entries.end()) continue;
+        if (it->second.expires <= now) {
+            shard.entries.erase(it);
+        } else {
+            // Re-inserted after this slot entry was made; wait for its current expiry.
+            schedule(shard, key, it->second.expires);
+        }
+    }
+}
+
+void TokenStore::insert(const TokenKey &key, std::string username, clock::time_point now) {
+    Shard &shard = shard_for(key);
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    if (ttl_ == clock::duration::zero()) {
+        shard.entries[key] = Entry{std::move(username), clock::time_point::max()};
+        return;
+    }
+    advance(shard, now);
+    clock::time_point expires = now + ttl_;
+    shard.entries[key] = Entry{std::move(username), expires};
+    schedule(shard, key, expires);
+}
+
+bool TokenStore::find(const TokenKey &key, std::string &username, clock::time_point now) const {
+    const Shard &shard = shard_for(key);
+    std::shared_lock<std::shared_mutex> lock(shard.mutex);
+    auto it = shard.entries.find(key);
+    if (it == shard.entries.end() || it->second.expires <= now) return false;
+    username = it->second.username;
+    return true;
+}
+
+bool TokenStore::contains(const TokenKey &key, clock::time_point now) const {
+    const Shard &shard = shard_for(key);
+    std::shared_lock<std::shared_mutex> lock(shard.mutex);
+    auto it = shard.entries.find(key);
+    return it != shard.entries.end() && it->second.expires > now;
+}
+
+bool TokenStore::erase(const TokenKey &key) {
+    Shard &shard = shard_for(key);
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    return shard.entries.erase(key) != 0;
+}
+
+void TokenStore::expire(clock::time_point now) {
+    if (ttl_ == clock::duration::zero()) return;
+    for (Shard &shard: shards_) {
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        advance(shard, now);
+    }
+}
+
+size_t TokenStore::size() const {
+    size_t total = 0;
+    for (const Shard &shard: shards_) {
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        total += shard.entries.size();
+    }
+    return total;
+}
+
+void TokenStore::clear() {
+    for (Shard &shard: shards_) {
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        shard.entries.clear();
+        for (auto &slot: shard.wheel) slot.clear();
+    }
+}
@@ -0,0 +1,95 @@
+#ifndef DOMINOREST_TOKEN_STORE_H
+#define DOMINOREST_TOKEN_STORE_H
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @file token_store.h
+ * @brief Concurrent store of opaque credentials (session tokens, dev keys) with TTL expiry.
+ */
+
+/// A credential in binary form: the 32 random bytes behind its base64 text.
+using TokenKey = std::array<unsigned char, 32>;
+
+/// Keys are uniformly random, so any 8 of their bytes already make a good hash.
+struct TokenKeyHash {
+    size_t operator()(const TokenKey &key) const {
+        size_t hash;
+        std::memcpy(&hash, key.data(), sizeof(hash));
+        return hash;
+    }
+};
+
+/**
+ * @class TokenStore
+ * @brief Maps credentials to user names, sharded by key, with per-shard timer wheels for expiry.
+ *
+ * Lookups take one shared lock on one of SHARD_COUNT shards and reject expired entries inline, so
+ * they never wait on expiry work. Each shard schedules its entries on a wheel of WHEEL_SLOTS
+ * ticks; the wheel is advanced whenever the shard is written and by expire(), which only visits
+ * the slots whose time has come rather than scanning every entry.
+ */
+class TokenStore {
+public:
+    using clock = std::chrono::steady_clock;
+
+    /// @param ttl Lifetime of every entry; zero means entries never expire.
+    explicit TokenStore(clock::duration ttl = clock::duration::zero());
+
+    void insert(const TokenKey &key, std::string username, clock::time_point now = clock::now());
+
+    /// @return true if @p key is present and unexpired; copies its user name into @p username.
+    bool find(const TokenKey &key, std::string &username, clock::time_point now = clock::now()) const;
+
+    bool contains(const TokenKey &key, clock::time_point now = clock::now()) const;
+
+    bool erase(const TokenKey &key);
+
+    /// Drops every entry whose time has come.
+    void expire(clock::time_point now = clock::now());
+
+    /// @return Entries held, including expired ones not yet reclaimed.
+    size_t size() const;
+
+    void clear();
+
+private:
+    static const size_t SHARD_COUNT = 32;
+    static const size_t WHEEL_SLOTS = 256;
+
+    struct Entry {
+        std::string username;
+        clock::time_point expires;
+    };
+
+    struct alignas(64) Shard {
+        mutable std::shared_mutex mutex;
+        std::unordered_map<TokenKey, Entry, TokenKeyHash> entries;
+        std::vector<std::vector<TokenKey>> wheel;
+        int64_t wheel_tick = -1; ///< Last tick whose slot was processed.
+    };
+
+    Shard &shard_for(const TokenKey &key);
+
+    const Shard &shard_for(const TokenKey &key) const;
+
+    int64_t tick_of(clock::time_point when) const;
+
+    void schedule(Shard &shard, const TokenKey &key, clock::time_point expires);
+
+    void advance(Shard &shard, clock::time_point now);
+
+    clock::duration ttl_;
+    clock::duration tick_;
+    std::array<Shard, SHARD_COUNT> shards_;
+};
+
+#endif //DOMINOREST_TOKEN_STORE_H
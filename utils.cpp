@@ -9,3 +9,30 @@ int find_max_pips(const std::vector<std::vector<int>> &board) {
     }
     return maxPips;
 }
+
+size_t decimal_width(int value) {
+    size_t width = value < 0 ? 2 : 1;
+    unsigned magnitude = value < 0 ? 0u - static_cast<unsigned>(value) : static_cast<unsigned>(value);
+    while (magnitude >= 10) {
+        magnitude /= 10;
+        ++width;
+    }
+    return width;
+}
+
+uint64_t fnv1a(const void *data, size_t size, uint64_t hash) {
+    const unsigned char *bytes = static_cast<const unsigned char *>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+uint64_t fnv1a(uint32_t value, uint64_t hash) {
+    for (int shift = 0; shift < 32; shift += 8) {
+        unsigned char byte = static_cast<unsigned char>(value >> shift);
+        hash = fnv1a(&byte, 1, hash);
+    }
+    return hash;
+}
@@ -1,5 +1,19 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <vector>
 
 int find_max_pips(const std::vector<std::vector<int>> &board);
+
+/// Characters @p value takes in decimal, minus sign included: what std::to_chars writes for it.
+size_t decimal_width(int value);
+
+/// 64-bit FNV-1a offset basis: the hash of no bytes, and the seed of every fnv1a chain.
+const uint64_t FNV1A_BASIS = 14695981039346656037ULL;
+
+/// Continues the FNV-1a @p hash over @p size bytes at @p data.
+uint64_t fnv1a(const void *data, size_t size, uint64_t hash = FNV1A_BASIS);
+
+/// Continues the FNV-1a @p hash over @p value's four bytes, least significant first.
+uint64_t fnv1a(uint32_t value, uint64_t hash = FNV1A_BASIS);
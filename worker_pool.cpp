@@ -0,0 +1,112 @@
+#include "worker_pool.h"
+
+#include <atomic>
+#include <memory>
+#include <utility>
+
+/**
+ * @file worker_pool.cpp
+ * @brief Implementation of the bounded worker pools.
+ */
+
+WorkerPool::WorkerPool(std::string name, size_t threads, size_t queue_limit)
+        : name_(std::move(name)), queue_limit_(queue_limit) {
+    if (threads == 0) threads = 1;
+    threads_.reserve(threads);
+    for (size_t i = 0; i < threads; ++i) {
+        threads_.emplace_back([this] { work(); });
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    for (auto &thread: threads_) thread.join();
+}
+
+bool WorkerPool::submit(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_ || queue_.size() >= queue_limit_) {
+            return false;
+        }
+        queue_.push_back(std::move(task));
+    }
+    wake_.notify_one();
+    return true;
+}
+
+size_t WorkerPool::queue_depth() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return queue_.size();
+}
+
+size_t WorkerPool::running() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return running_;
+}
+
+void WorkerPool::work() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        wake_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+        if (queue_.empty()) {
+            return; // stopping_ and fully drained
+        }
+        std::function<void()> task = std::move(queue_.front());
+        queue_.pop_front();
+        ++running_;
+        lock.unlock();
+        try {
+            task();
+        } catch (const std::exception &e) {
+            CROW_LOG_ERROR << name_ << " pool: task failed: " << e.what();
+        }
+        lock.lock();
+        --running_;
+    }
+}
+
+void respond_from_pool(WorkerPool &pool, const crow::request &req, crow::response &res,
+                       std::function<crow::response()> work) {
+    respond_from_pool_async(pool, req, res, [work = std::move(work)](const Respond &respond) { respond(work()); });
+}
+
+void respond_from_pool_async(WorkerPool &pool, const crow::request &req, crow::response &res,
+                             std::function<void(const Respond &)> work) {
+    asio::io_service *io = req.io_service;
+    crow::response *out = &res;
+    bool queued = pool.submit([io, out, work = std::move(work)] {
+        auto responded = std::make_shared<std::atomic<bool>>(false);
+        Respond respond = [io, out, responded](crow::response response) {
+            if (responded->exchange(true)) return;
+            auto result = std::make_shared<crow::response>(std::move(response));
+            auto complete = [out, result] {
+                *out = std::move(*result);
+                out->end();
+            };
+            if (io != nullptr) {
+                io->post(complete);
+            } else {
+                complete();
+            }
+        };
+        try {
+            work(respond);
+        } catch (const std::exception &e) {
+            CROW_LOG_ERROR << "Server Error: " << e.what();
+            respond(crow::response(500, "Server Error: Unable to process request."));
+        }
+    });
+
+    if (!queued) {
+        CROW_LOG_WARNING << "Service Unavailable: Worker queue is full.";
+        res.code = 503;
+        res.set_header("Retry-After", "1");
+        res.body = "Service Unavailable: Server is busy, retry later.";
+        res.end();
+    }
+}
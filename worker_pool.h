@@ -0,0 +1,88 @@
+#ifndef DOMINOREST_WORKER_POOL_H
+#define DOMINOREST_WORKER_POOL_H
+
+#include "crow.h"
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @file worker_pool.h
+ * @brief Bounded thread pools for CPU-bound work that must stay off the HTTP IO threads.
+ */
+
+/**
+ * @class WorkerPool
+ * @brief A fixed set of threads draining a bounded FIFO queue.
+ *
+ * submit() never blocks: once @p queue_limit tasks are waiting it refuses new work, so callers can
+ * shed load (e.g. answer 503) instead of letting the queue, and every request's latency, grow.
+ */
+class WorkerPool {
+public:
+    /**
+     * @param name Used in log lines.
+     * @param threads Number of worker threads, at least 1.
+     * @param queue_limit Maximum number of tasks waiting for a thread.
+     */
+    WorkerPool(std::string name, size_t threads, size_t queue_limit);
+
+    /// Runs every queued task, then joins the workers.
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool &) = delete;
+
+    WorkerPool &operator=(const WorkerPool &) = delete;
+
+    /// @return false if the queue is full or the pool is shutting down; the task is not run.
+    bool submit(std::function<void()> task);
+
+    /// @return Tasks waiting for a thread.
+    size_t queue_depth() const;
+
+    /// @return Tasks currently running.
+    size_t running() const;
+
+private:
+    void work();
+
+    std::string name_;
+    size_t queue_limit_;
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;
+    std::deque<std::function<void()>> queue_;
+    size_t running_ = 0;
+    bool stopping_ = false;
+    std::vector<std::thread> threads_;
+};
+
+/**
+ * @brief Runs @p work on @p pool and completes @p res with its result.
+ *
+ * The response is handed back to the connection's IO thread (req.io_service) before res.end() is
+ * called, so Crow's connection state is only ever touched from its own thread. If the pool is
+ * full, @p res is completed immediately with 503 and a Retry-After header. An exception escaping
+ * @p work becomes a 500.
+ */
+void respond_from_pool(WorkerPool &pool, const crow::request &req, crow::response &res,
+                       std::function<crow::response()> work);
+
+/// Completes a response handed out by respond_from_pool_async; only the first call has an effect.
+using Respond = std::function<void(crow::response)>;
+
+/**
+ * @brief Runs @p work on @p pool, which completes @p res by calling the Respond it is given.
+ *
+ * Unlike respond_from_pool, @p work may return without responding and leave the Respond to be
+ * called later from another thread, so a request waiting on something else does not hold a pool
+ * thread. A full pool and exceptions escaping @p work are answered as respond_from_pool answers them.
+ */
+void respond_from_pool_async(WorkerPool &pool, const crow::request &req, crow::response &res,
+                             std::function<void(const Respond &)> work);
+
+#endif //DOMINOREST_WORKER_POOL_H